@@ -14,6 +14,7 @@
 
 import os
 import struct
+import zlib
 
 from PyInstaller.loader.pyimod01_archive import ZlibArchiveReader, ArchiveReadError
 
@@ -33,6 +34,12 @@ class NotAnArchiveError(TypeError):
 PKG_ITEM_DATA = 'x'  # data
 PKG_ITEM_RUNTIME_OPTION = 'o'  # runtime option
 PKG_ITEM_SPLASH = 'l'  # splash resources
+PKG_ITEM_SYMLINK = 'n'  # symbolic link
+PKG_ITEM_ALIAS = 'h'  # alias of an extractable entry with identical data
+PKG_ITEM_LAZY_BINARY = 'e'  # binary that is extracted on demand
+PKG_ITEM_LAZY_DATA = 'r'  # data file that is read from the archive or extracted on demand
+PKG_ITEM_LAZY_INDEX = 'i'  # index of on-demand entries
+PKG_ITEM_SHARED_PYZ = 'y'  # reference to PYZ archive shared by multiple executables (MERGE)
 
 
 class CArchiveReader:
@@ -41,7 +48,7 @@ class CArchiveReader:
     """
 
     # Cookie - holds some information for the bootloader. C struct format definition. '!' at the beginning means network
-    # byte order. C struct looks like:
+    # byte order. C struct (format version 1) looks like:
     #
     # typedef struct _archive_cookie
     # {
@@ -51,14 +58,14 @@ class CArchiveReader:
     #     uint32_t toc_length;
     #     uint32_t python_version;
     #     char python_libname[64];
-    # } ARCHIVE_COOKIE;
+    # } ARCHIVE_COOKIE_V1;
     #
     _COOKIE_MAGIC_PATTERN = b'MEI\014\013\012\013\016'
 
     _COOKIE_FORMAT = '!8sIIII64s'
     _COOKIE_LENGTH = struct.calcsize(_COOKIE_FORMAT)
 
-    # TOC entry:
+    # TOC entry (format version 1):
     #
     # typedef struct _toc_entry
     # {
@@ -69,19 +76,72 @@ class CArchiveReader:
     #     unsigned char compression_flag;
     #     char typecode;
     #     char name[1]; /* Variable-length name, padded to multiple of 16 */
-    # } TOC_ENTRY;
+    # } TOC_ENTRY_V1;
     #
     _TOC_ENTRY_FORMAT = '!IIIIBc'
     _TOC_ENTRY_LENGTH = struct.calcsize(_TOC_ENTRY_FORMAT)
 
+    # Cookie (format version 2). The magic pattern is the same as in format version 1; it is followed by a zero field
+    # (which corresponds to the non-zero `pkg_length` in format version 1) and by the format version. Sizes and offsets
+    # are 64-bit.
+    #
+    # typedef struct _archive_cookie_v2
+    # {
+    #     char magic[8];
+    #     uint32_t v1_marker; /* always 0 */
+    #     uint32_t format_version; /* 2 */
+    #     uint64_t pkg_length;
+    #     uint64_t toc_offset;
+    #     uint64_t toc_length;
+    #     uint32_t entry_count;
+    #     uint32_t section_count;
+    #     uint32_t python_version;
+    #     uint32_t reserved;
+    #     char python_libname[64];
+    # } ARCHIVE_COOKIE_V2;
+    #
+    # The TOC consists of array of fixed-size entries, followed by the section table, the entry index (array of uint32_t
+    # entry positions, grouped by typecode), and the string pool with NULL-terminated entry names.
+    #
+    # typedef struct _toc_entry_v2
+    # {
+    #     uint64_t offset;
+    #     uint64_t length;
+    #     uint64_t uncompressed_length;
+    #     uint32_t name_offset; /* Position of the name in the string pool */
+    #     uint32_t digest; /* CRC-32 of the uncompressed data */
+    #     unsigned char compression_flag;
+    #     char typecode;
+    #     char reserved[6];
+    # } TOC_ENTRY_V2;
+    #
+    # typedef struct _toc_section
+    # {
+    #     char typecode;
+    #     char reserved[3];
+    #     uint32_t index_start; /* Position of the section's first entry in the entry index */
+    #     uint32_t count;
+    # } TOC_SECTION;
+    #
+    _COOKIE_V2_FORMAT = '!8sIIQQQIIII64s'
+    _COOKIE_V2_LENGTH = struct.calcsize(_COOKIE_V2_FORMAT)
+
+    _TOC_ENTRY_V2_FORMAT = '!QQQIIBc6x'
+    _TOC_ENTRY_V2_LENGTH = struct.calcsize(_TOC_ENTRY_V2_FORMAT)
+
+    _TOC_SECTION_FORMAT = '!c3xII'
+    _TOC_SECTION_LENGTH = struct.calcsize(_TOC_SECTION_FORMAT)
+
     def __init__(self, filename):
         self._filename = filename
         self._start_offset = 0
         self._toc_offset = 0
         self._toc_length = 0
+        self._format_version = 1
 
         self.toc = {}
         self.options = []
+        self.digests = {}  # CRC-32 digests of entries' uncompressed data; available only in format version 2.
 
         # Load TOC
         with open(self._filename, "rb") as fp:
@@ -90,15 +150,28 @@ def __init__(self, filename):
             if cookie_start_offset == -1:
                 raise ArchiveReadError("Could not find COOKIE magic pattern!")
 
-            # Read the whole cookie
+            # Read the whole cookie; the zero-valued field after the magic pattern indicates format version 2 (or
+            # later).
             fp.seek(cookie_start_offset, os.SEEK_SET)
-            cookie_data = fp.read(self._COOKIE_LENGTH)
-
-            magic, archive_length, toc_offset, toc_length, pyvers, pylib_name = \
-                struct.unpack(self._COOKIE_FORMAT, cookie_data)
+            cookie_data = fp.read(self._COOKIE_V2_LENGTH)
+
+            v1_marker, format_version = struct.unpack('!II', cookie_data[8:16])
+            if v1_marker != 0:
+                magic, archive_length, toc_offset, toc_length, pyvers, pylib_name = \
+                    struct.unpack(self._COOKIE_FORMAT, cookie_data[:self._COOKIE_LENGTH])
+                cookie_length = self._COOKIE_LENGTH
+            elif format_version == 2:
+                (
+                    magic, _, _, archive_length, toc_offset, toc_length, entry_count, section_count, pyvers, _,
+                    pylib_name
+                ) = struct.unpack(self._COOKIE_V2_FORMAT, cookie_data)
+                cookie_length = self._COOKIE_V2_LENGTH
+                self._format_version = 2
+            else:
+                raise ArchiveReadError(f"Unsupported archive format version: {format_version}!")
 
             # Compute start of the the archive
-            self._start_offset = (cookie_start_offset + self._COOKIE_LENGTH) - archive_length
+            self._start_offset = (cookie_start_offset + cookie_length) - archive_length
 
             # Verify that Python shared library name is set
             if not pylib_name:
@@ -108,7 +181,10 @@ def __init__(self, filename):
             fp.seek(self._start_offset + toc_offset)
             toc_data = fp.read(toc_length)
 
-            self.toc, self.options = self._parse_toc(toc_data)
+            if self._format_version == 1:
+                self.toc, self.options = self._parse_toc(toc_data)
+            else:
+                self.toc, self.options, self.digests = self._parse_toc_v2(toc_data, entry_count, section_count)
 
     @staticmethod
     def _find_magic_pattern(fp, magic_pattern):
@@ -137,6 +213,20 @@ def _find_magic_pattern(fp, magic_pattern):
 
         return magic_offset
 
+    @property
+    def start_offset(self):
+        """
+        Offset of the start of the archive within the file (non-zero if archive is embedded in an executable).
+        """
+        return self._start_offset
+
+    @property
+    def format_version(self):
+        """
+        Format version of the archive (1 or 2).
+        """
+        return self._format_version
+
     @classmethod
     def _parse_toc(cls, data):
         options = []
@@ -165,6 +255,29 @@ def _parse_toc(cls, data):
 
         return toc, options
 
+    @classmethod
+    def _parse_toc_v2(cls, data, entry_count, section_count):
+        options = []
+        toc = {}
+        digests = {}
+        # Skip the section table and the entry index; entries are processed in their original order.
+        string_pool_offset = entry_count * (cls._TOC_ENTRY_V2_LENGTH + 4) + section_count * cls._TOC_SECTION_LENGTH
+        for entry_offset, data_length, uncompressed_length, name_offset, digest, compression_flag, typecode in \
+                struct.iter_unpack(cls._TOC_ENTRY_V2_FORMAT, data[:entry_count * cls._TOC_ENTRY_V2_LENGTH]):
+            name_start = string_pool_offset + name_offset
+            name = data[name_start:data.index(b'\0', name_start)].decode('utf-8')
+
+            typecode = typecode.decode('ascii')
+
+            # See the comment in `_parse_toc`.
+            if typecode == 'o':
+                options.append(name)
+            else:
+                toc[name] = (entry_offset, data_length, uncompressed_length, compression_flag, typecode)
+                digests[name] = digest
+
+        return toc, options, digests
+
     def extract(self, name):
         """
         Extract data for the given entry name.
@@ -180,9 +293,13 @@ def extract(self, name):
             data = fp.read(data_length)
 
         if compression_flag:
-            import zlib
             data = zlib.decompress(data)
 
+        # Verify the data against the digest stored in the TOC, if available.
+        digest = self.digests.get(name)
+        if digest is not None and zlib.crc32(data) != digest:
+            raise ArchiveReadError(f"Data of entry {name} does not match its digest!")
+
         return data
 
     def open_embedded_archive(self, name):
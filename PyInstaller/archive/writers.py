@@ -12,9 +12,9 @@
 Utilities to create data structures for embedding Python modules and additional files into the executable.
 """
 
+import hashlib
 import marshal
 import os
-import shutil
 import struct
 import sys
 import zlib
@@ -33,7 +33,7 @@ class ZlibArchiveWriter:
     _HEADER_LENGTH = 12 + 5
     _COMPRESSION_LEVEL = 6  # zlib compression level
 
-    def __init__(self, filename, entries, code_dict=None):
+    def __init__(self, filename, entries, code_dict=None, lazy_modules=None):
         """
         filename
             Target filename of the archive.
@@ -43,6 +43,8 @@ def __init__(self, filename, entries, code_dict=None):
             file from which the resource is read, and `typecode` is the Analysis-level TOC typecode (`PYMODULE`).
         code_dict
             Optional code dictionary containing code objects for analyzed/collected python modules.
+        lazy_modules
+            Optional list of names of modules whose execution should be deferred by the run-time importer.
         """
         code_dict = code_dict or {}
 
@@ -61,16 +63,23 @@ def __init__(self, filename, entries, code_dict=None):
             toc_data = marshal.dumps(toc)
             fp.write(toc_data)
 
+            # Write the list of modules with deferred execution, if applicable.
+            lazy_modules_offset = 0
+            if lazy_modules:
+                lazy_modules_offset = fp.tell()
+                fp.write(marshal.dumps(sorted(lazy_modules)))
+
             # Write header:
             #  - PYZ magic pattern (4 bytes)
             #  - python bytecode magic pattern (4 bytes)
             #  - TOC offset (32-bit int, 4 bytes)
-            #  - 4 unused bytes
+            #  - offset of the list of modules with deferred execution, or 0 if there is none (32-bit int, 4 bytes)
             fp.seek(0, os.SEEK_SET)
 
             fp.write(self._PYZ_MAGIC_PATTERN)
             fp.write(BYTECODE_MAGIC)
             fp.write(struct.pack('!i', toc_offset))
+            fp.write(struct.pack('!i', lazy_modules_offset))
 
     @classmethod
     def _write_entry(cls, fp, entry, code_dict):
@@ -118,51 +127,205 @@ class CArchiveWriter:
     _TOC_ENTRY_FORMAT = '!IIIIBc'
     _TOC_ENTRY_LENGTH = struct.calcsize(_TOC_ENTRY_FORMAT)
 
-    _COMPRESSION_LEVEL = 9  # zlib compression level
-
-    def __init__(self, filename, entries, pylib_name):
+    _COOKIE_V2_FORMAT = '!8sIIQQQIIII64s'
+    _COOKIE_V2_LENGTH = struct.calcsize(_COOKIE_V2_FORMAT)
+
+    _TOC_ENTRY_V2_FORMAT = '!QQQIIBc6x'
+    _TOC_SECTION_FORMAT = '!c3xII'
+
+    # Maximum archive length that can be represented in format version 1, which uses 32-bit offsets and lengths.
+    _MAX_V1_ARCHIVE_LENGTH = 0xFFFFFFFF
+
+    _COMPRESSION_LEVEL = 9  # default zlib compression level
+
+    # Adaptive compression: compressibility of files larger than `_SAMPLE_COUNT * _SAMPLE_SIZE` is estimated by
+    # compressing evenly-spaced samples with the fastest compression level; smaller files are compressed in memory.
+    _SAMPLE_SIZE = 64 * 1024
+    _SAMPLE_COUNT = 4
+
+    # Typecodes of entries that are extracted onto filesystem at run-time, and are thus eligible for data alignment.
+    _ALIGNABLE_TYPECODES = {'b', 'x', 'Z', 'e', 'r'}
+
+    # Typecodes of entries that are eligible for data de-duplication.
+    _DEDUPLICABLE_TYPECODES = {'b', 'x', 'Z'}
+
+    # Typecodes of entries whose data is read from the source file. When the archive is updated in-place, the data blobs
+    # of such entries are kept if their source file has not changed. Alias entries (typecode 'h', written in place of
+    # de-duplicated entries) are never kept, because the data blob of their original entry might have been re-written
+    # at a different offset; they are de-duplicated again instead.
+    _REUSABLE_TYPECODES = {'b', 'x', 'Z', 'e', 'r', 'm', 'M', 's', 's1', 's2', 'z', 'a', 'l'}
+
+    # Version of the archive layout file, used for in-place updates.
+    _LAYOUT_VERSION = 2
+
+    def __init__(
+        self,
+        filename,
+        entries,
+        pylib_name,
+        alignment=None,
+        deduplicate=False,
+        compression_threshold=None,
+        format_version=1,
+        layout_file=None,
+        max_waste=0.25,
+    ):
         """
         filename
             Target filename of the archive.
         entries
             An iterable containing entries in the form of tuples: (dest_name, src_name, compress, typecode), where
             `dest_name` is the name under which the resource is stored in the archive (and name under which it is
-            extracted at runtime), `src_name` is name of the file from which the resouce is read, `compress` is a
-            boolean compression flag, and `typecode` is the Analysis-level TOC typecode.
+            extracted at runtime), `src_name` is name of the file from which the resouce is read, `compress` is either
+            a boolean compression flag or an integer zlib compression level (0 meaning no compression), and `typecode`
+            is the Analysis-level TOC typecode.
         pylib_name
             Name of the python shared library.
+        alignment
+            Optional alignment (in bytes) for data of uncompressed entries that are extracted at run-time. The offset
+            is relative to the start of the archive; the caller is responsible for placing the archive itself at an
+            aligned offset within the executable. Aligning data to the filesystem block size (4096 bytes) allows the
+            bootloader to share data extents between the executable and extracted files on copy-on-write filesystems
+            instead of copying the data.
+        deduplicate
+            If True, the data of extractable entries with identical contents (and identical typecode and compression
+            flag) is stored only once; the subsequent entries are written as alias entries (typecode 'h') that refer to
+            the data blob of the first entry. At run-time, the bootloader extracts aliases as hard links to the file
+            extracted from the first entry (or as copies, if hard links cannot be created).
+        compression_threshold
+            Optional minimal relative size reduction (for example, 0.02 for 2%) that compression must achieve for an
+            entry to be stored compressed; entries that do not meet it are stored uncompressed. For large files, the
+            size reduction is estimated from data samples before compressing the whole file, which avoids spending
+            build time (and run-time decompression time) on already-compressed data, such as archives, images, or
+            UPX-compressed binaries. If not specified, entries are compressed as requested.
+        format_version
+            Archive format version. Version 1 (the default) uses 32-bit offsets and lengths (limiting the archive size
+            to 4 GiB) and variable-length TOC entries. Version 2 uses 64-bit offsets and lengths, fixed-size TOC entries
+            with names stored in a separate string pool, and a section table that groups the entries by their typecode.
+            Its TOC entries also store the CRC-32 digest of the entry's uncompressed data, which allows the integrity of
+            the entry's data (and of files extracted from it) to be verified without comparing it to the archive.
+            Version 2 archives can be read only by bootloaders built from sources that support it.
+        layout_file
+            Optional path to the file that records the layout of the archive (the data blobs of entries and the source
+            files they were created from). If given, and the recorded layout matches the existing archive, the archive
+            is updated in-place: the data blobs of unchanged entries are kept at their offsets, the data of changed and
+            new entries is appended after them, and the TOC and the cookie are rewritten. This makes re-building a large
+            archive after a small change much faster, at the cost of the archive containing stale data blobs.
+        max_waste
+            The maximal fraction of the archive's data that may be taken by stale data blobs when updating the archive
+            in-place; if exceeded, the archive is compacted by re-writing it from scratch.
         """
-        self._collected_names = set()  # Track collected names for strict package mode.
+        if format_version not in (1, 2):
+            raise ValueError(f"Unsupported archive format version: {format_version}!")
 
-        with open(filename, "wb") as fp:
-            # Write entries' data and collect TOC entries
+        self._collected_names = set()  # Track collected names for strict package mode.
+        self._alignment = alignment
+        self._deduplicate = deduplicate
+        self._compression_threshold = compression_threshold
+        self._written_files = {}  # Track written file entries by their content, for data de-duplication.
+
+        entries = list(entries)
+        settings = (pylib_name, alignment, deduplicate, compression_threshold, format_version)
+        entry_keys = [self._get_layout_key(entry) for entry in entries] if layout_file else [None] * len(entries)
+
+        reusable_entries = {}
+        reusable_dedup_keys = {}
+        data_end = 0
+        if layout_file:
+            layout = self._load_layout(layout_file, filename, settings)
+            if layout is not None:
+                reusable_entries, data_end = self._plan_in_place_update(layout, entry_keys, max_waste)
+                reusable_dedup_keys = layout.get('dedup_keys', {})
+            # Remove the layout file, so that it does not refer to a partially-written archive if writing fails.
+            if os.path.exists(layout_file):
+                os.remove(layout_file)
+
+        # Number of entries whose data was reused from the previously-written archive.
+        self.num_reused_entries = 0
+
+        with open(filename, "r+b" if reusable_entries else "wb") as fp:
+            # When updating in-place, discard everything after the data of the previously-written entries (i.e., the
+            # index of on-demand data files, the TOC, and the cookie).
+            if reusable_entries:
+                fp.seek(data_end, os.SEEK_SET)
+                fp.truncate()
+
+            # Write entries' data (or reuse the previously-written data) and collect TOC entries
             toc = []
-            for entry in entries:
-                toc_entry = self._write_entry(fp, entry)
+            layout_entries = {}
+            for entry, key in zip(entries, entry_keys):
+                toc_entry = reusable_entries.get(key) if key is not None else None
+                if toc_entry is not None:
+                    self._check_collected_name(toc_entry[5], entry[3])
+                    self.num_reused_entries += 1
+                    # Allow the subsequent identical entries to be written as aliases of the reused data blob.
+                    if self._deduplicate and key in reusable_dedup_keys:
+                        self._written_files.setdefault(reusable_dedup_keys[key], toc_entry)
+                else:
+                    toc_entry = self._write_entry(fp, entry)
                 toc.append(toc_entry)
+                if key is not None:
+                    layout_entries[key] = toc_entry
+            data_end = fp.tell()
+
+            # Write the index of on-demand data files, which allows the frozen application to read them directly from
+            # the archive.
+            lazy_data_index = {
+                name: (data_offset, compressed_length, data_length, compress)
+                for data_offset, compressed_length, data_length, compress, typecode, name, _ in toc if typecode == 'r'
+            }
+            if lazy_data_index:
+                toc.append(self._write_blob(fp, marshal.dumps(lazy_data_index), 'pyi-lazy-data', 'i', compress=True))
 
             # Write TOC
             toc_offset = fp.tell()
-            toc_data = self._serialize_toc(toc)
+            if format_version == 1:
+                toc_data = self._serialize_toc(toc)
+            else:
+                toc_data, entry_count, section_count = self._serialize_toc_v2(toc)
             toc_length = len(toc_data)
 
             fp.write(toc_data)
 
             # Write cookie
-            archive_length = toc_offset + toc_length + self._COOKIE_LENGTH
             pyvers = sys.version_info[0] * 100 + sys.version_info[1]
-            cookie_data = struct.pack(
-                self._COOKIE_FORMAT,
-                self._COOKIE_MAGIC_PATTERN,
-                archive_length,
-                toc_offset,
-                toc_length,
-                pyvers,
-                pylib_name.encode('ascii'),
-            )
+            if format_version == 1:
+                archive_length = toc_offset + toc_length + self._COOKIE_LENGTH
+                if archive_length > self._MAX_V1_ARCHIVE_LENGTH:
+                    raise ValueError(
+                        f"Archive length ({archive_length} bytes) exceeds the limit of archive format version 1!"
+                    )
+                cookie_data = struct.pack(
+                    self._COOKIE_FORMAT,
+                    self._COOKIE_MAGIC_PATTERN,
+                    archive_length,
+                    toc_offset,
+                    toc_length,
+                    pyvers,
+                    pylib_name.encode('ascii'),
+                )
+            else:
+                archive_length = toc_offset + toc_length + self._COOKIE_V2_LENGTH
+                cookie_data = struct.pack(
+                    self._COOKIE_V2_FORMAT,
+                    self._COOKIE_MAGIC_PATTERN,
+                    0,  # v1_marker
+                    format_version,
+                    archive_length,
+                    toc_offset,
+                    toc_length,
+                    entry_count,
+                    section_count,
+                    pyvers,
+                    0,  # reserved
+                    pylib_name.encode('ascii'),
+                )
 
             fp.write(cookie_data)
 
+        if layout_file:
+            self._save_layout(layout_file, filename, settings, layout_entries, data_end)
+
     def _write_entry(self, fp, entry):
         dest_name, src_name, compress, typecode = entry
 
@@ -184,28 +347,16 @@ def _write_entry(self, fp, entry):
             if typecode == 'n':
                 src_name = src_name.replace(os.path.sep, '\\')
 
-        # Strict pack/collect mode: keep track of the destination names, and raise an error if we try to add a duplicate
-        # (a file with same destination name, subject to OS case normalization rules).
-        if strict_collect_mode:
-            normalized_dest = None
-            if typecode in {'s', 's1', 's2', 'm', 'M'}:
-                # Exempt python source scripts and modules from the check.
-                pass
-            else:
-                # Everything else; normalize the case
-                normalized_dest = os.path.normcase(dest_name)
-            # Check for existing entry, if applicable
-            if normalized_dest:
-                if normalized_dest in self._collected_names:
-                    raise ValueError(
-                        f"Attempting to collect a duplicated file into CArchive: {normalized_dest} (type: {typecode})"
-                    )
-                self._collected_names.add(normalized_dest)
+        self._check_collected_name(dest_name, typecode)
 
         if typecode == 'd':
             # Dependency; merge src_name (= reference path prefix) and dest_name (= name) into single-string format that
             # is parsed by bootloader.
             return self._write_blob(fp, b"", f"{src_name}:{dest_name}", typecode)
+        elif typecode == 'y':
+            # Reference to shared PYZ archive; the path to the archive (relative to the executable's parent directory)
+            # is stored in dest_name.
+            return self._write_blob(fp, b"", dest_name, typecode)
         elif typecode in {'s', 's1', 's2'}:
             # If it is a source code file, compile it to a code object and marshal the object, so it can be unmarshalled
             # by the bootloader. For that, we need to know target optimization level, which is stored in typecode.
@@ -229,9 +380,100 @@ def _write_entry(self, fp, entry):
             # Symbolic link; store target name (as NULL-terminated string)
             data = src_name.encode('utf-8') + b'\x00'
             return self._write_blob(fp, data, dest_name, typecode, compress=compress)
+        elif self._deduplicate and typecode in self._DEDUPLICABLE_TYPECODES:
+            return self._write_file_deduplicated(fp, src_name, dest_name, typecode, compress=compress)
         else:
             return self._write_file(fp, src_name, dest_name, typecode, compress=compress)
 
+    def _check_collected_name(self, dest_name, typecode):
+        # Strict pack/collect mode: keep track of the destination names, and raise an error if we try to add a duplicate
+        # (a file with same destination name, subject to OS case normalization rules).
+        if strict_collect_mode:
+            normalized_dest = None
+            if typecode in {'s', 's1', 's2', 'm', 'M'}:
+                # Exempt python source scripts and modules from the check.
+                pass
+            else:
+                # Everything else; normalize the case
+                normalized_dest = os.path.normcase(dest_name)
+            # Check for existing entry, if applicable
+            if normalized_dest:
+                if normalized_dest in self._collected_names:
+                    raise ValueError(
+                        f"Attempting to collect a duplicated file into CArchive: {normalized_dest} (type: {typecode})"
+                    )
+                self._collected_names.add(normalized_dest)
+
+    def _get_layout_key(self, entry):
+        """
+        Compute the key under which the entry's data blob is recorded in the archive layout; the key changes whenever
+        the source file is modified. Returns None for entries whose data is not read from a source file.
+        """
+        dest_name, src_name, compress, typecode = entry
+        if typecode not in self._REUSABLE_TYPECODES:
+            return None
+        try:
+            stat = os.stat(src_name)
+        except OSError:
+            return None
+        return (dest_name, src_name, typecode, compress, stat.st_mtime_ns, stat.st_size)
+
+    def _load_layout(self, layout_file, filename, settings):
+        """
+        Load the layout of the previously-written archive. Returns None if the layout is unavailable, or if it does not
+        match the existing archive (e.g., because the archive was modified or written with different settings).
+        """
+        try:
+            with open(layout_file, 'rb') as fp:
+                layout = marshal.load(fp)
+            stat = os.stat(filename)
+        except (OSError, EOFError, ValueError, TypeError):
+            return None
+        if not isinstance(layout, dict) or layout.get('version') != self._LAYOUT_VERSION:
+            return None
+        if layout.get('settings') != settings or layout.get('archive') != (stat.st_size, stat.st_mtime_ns):
+            return None
+        return layout
+
+    def _plan_in_place_update(self, layout, entry_keys, max_waste):
+        """
+        Determine which of the previously-written data blobs can be reused. Returns the dictionary of reusable TOC
+        entries, and the end offset of previously-written data. If the stale data blobs would take more than
+        `max_waste` fraction of the archive's data, no entries are reused, and the archive is re-written from scratch.
+        """
+        reusable_entries = {}
+        for key in entry_keys:
+            toc_entry = layout['entries'].get(key) if key is not None else None
+            if toc_entry is not None and toc_entry[4] != 'h':
+                reusable_entries[key] = toc_entry
+
+        # Aliases (and empty entries) share their data blobs with other entries; count each blob only once.
+        data_end = layout['data_end']
+        live_blobs = {(toc_entry[0], toc_entry[1]) for toc_entry in reusable_entries.values()}
+        live_length = sum(length for _, length in live_blobs)
+        if not reusable_entries or (data_end - live_length) > max_waste * data_end:
+            return {}, 0
+        return reusable_entries, data_end
+
+    def _save_layout(self, layout_file, filename, settings, layout_entries, data_end):
+        # Record the de-duplication keys of the written data blobs, so that the entries written during a subsequent
+        # in-place update can be de-duplicated against the reused blobs.
+        dedup_keys = {toc_entry: dedup_key for dedup_key, toc_entry in self._written_files.items()}
+        stat = os.stat(filename)
+        layout = {
+            'version': self._LAYOUT_VERSION,
+            'settings': settings,
+            'archive': (stat.st_size, stat.st_mtime_ns),
+            'data_end': data_end,
+            'entries': layout_entries,
+            'dedup_keys': {
+                key: dedup_keys[toc_entry]
+                for key, toc_entry in layout_entries.items() if toc_entry in dedup_keys
+            },
+        }
+        with open(layout_file, 'wb') as fp:
+            marshal.dump(layout, fp)
+
     def _write_blob(self, out_fp, blob: bytes, dest_name, typecode, compress=False):
         """
         Write the binary contents (**blob**) of a small file to the archive and return the corresponding CArchive TOC
@@ -239,38 +481,142 @@ def _write_blob(self, out_fp, blob: bytes, dest_name, typecode, compress=False):
         """
         data_offset = out_fp.tell()
         data_length = len(blob)
-        if compress:
-            blob = zlib.compress(blob, level=self._COMPRESSION_LEVEL)
+        digest = zlib.crc32(blob)
+        compression_level = self._get_compression_level(compress)
+        if compression_level:
+            compressed_blob = zlib.compress(blob, level=compression_level)
+            if self._is_worth_compressing(data_length, len(compressed_blob)):
+                blob = compressed_blob
+            else:
+                compression_level = 0
         out_fp.write(blob)
 
-        return (data_offset, len(blob), data_length, int(compress), typecode, dest_name)
+        return (data_offset, len(blob), data_length, int(compression_level > 0), typecode, dest_name, digest)
 
     def _write_file(self, out_fp, src_name, dest_name, typecode, compress=False):
         """
         Stream copy a large file into the archive and return the corresponding CArchive TOC entry.
         """
-        data_offset = out_fp.tell()
         data_length = os.stat(src_name).st_size
+        compression_level = self._get_compression_level(compress)
+
+        # With adaptive compression enabled, small files are compressed in memory, so the decision is based on the
+        # actual size reduction. For large files, the size reduction is estimated from samples.
+        if compression_level and self._compression_threshold is not None:
+            if data_length <= self._SAMPLE_COUNT * self._SAMPLE_SIZE:
+                with open(src_name, 'rb') as in_fp:
+                    data = in_fp.read()
+                compressed_data = zlib.compress(data, level=compression_level)
+                if self._is_worth_compressing(data_length, len(compressed_data)):
+                    data_offset = out_fp.tell()
+                    out_fp.write(compressed_data)
+                    return (data_offset, len(compressed_data), data_length, 1, typecode, dest_name, zlib.crc32(data))
+                compression_level = 0
+            elif not self._is_worth_compressing(*self._estimate_compressed_length(src_name, data_length)):
+                compression_level = 0
+
+        # Pad the archive so that data of uncompressed extractable entries starts at aligned offset.
+        if self._alignment and not compression_level and typecode in self._ALIGNABLE_TYPECODES:
+            padding_length = -out_fp.tell() % self._alignment
+            out_fp.write(b'\0' * padding_length)
+
+        data_offset = out_fp.tell()
+        digest = 0
         with open(src_name, 'rb') as in_fp:
-            if compress:
+            if compression_level:
                 tmp_buffer = bytearray(16 * 1024)
-                compressor = zlib.compressobj(self._COMPRESSION_LEVEL)
+                compressor = zlib.compressobj(compression_level)
                 while True:
                     num_read = in_fp.readinto(tmp_buffer)
                     if not num_read:
                         break
-                    out_fp.write(compressor.compress(tmp_buffer[:num_read]))
+                    chunk = memoryview(tmp_buffer)[:num_read]
+                    digest = zlib.crc32(chunk, digest)
+                    out_fp.write(compressor.compress(chunk))
                 out_fp.write(compressor.flush())
+
+                # If the estimate was overly optimistic, discard the compressed data and store the file as-is.
+                if self._compression_threshold is not None and \
+                        not self._is_worth_compressing(data_length, out_fp.tell() - data_offset):
+                    out_fp.seek(data_offset, os.SEEK_SET)
+                    out_fp.truncate()
+                    return self._write_file(out_fp, src_name, dest_name, typecode, compress=False)
             else:
-                shutil.copyfileobj(in_fp, out_fp)
+                for chunk in iter(lambda: in_fp.read(1024 * 1024), b''):
+                    digest = zlib.crc32(chunk, digest)
+                    out_fp.write(chunk)
+
+        return (
+            data_offset, out_fp.tell() - data_offset, data_length, int(compression_level > 0), typecode, dest_name,
+            digest
+        )
+
+    def _get_compression_level(self, compress):
+        """
+        Translate the entry's compression setting (boolean flag or explicit zlib compression level) into compression
+        level, with 0 meaning no compression.
+        """
+        if isinstance(compress, bool):
+            return self._COMPRESSION_LEVEL if compress else 0
+        return int(compress or 0)
+
+    def _is_worth_compressing(self, data_length, compressed_length):
+        """
+        Check whether the (estimated) size reduction meets the compression threshold. Without threshold, compression
+        is always considered worthwhile.
+        """
+        if self._compression_threshold is None:
+            return True
+        if data_length == 0:
+            return False
+        return (data_length - compressed_length) / data_length >= self._compression_threshold
 
-        return (data_offset, out_fp.tell() - data_offset, data_length, int(compress), typecode, dest_name)
+    def _estimate_compressed_length(self, src_name, data_length):
+        """
+        Compress evenly-spaced data samples of the given file using the fastest compression level, and return the
+        combined (uncompressed, compressed) length of the samples.
+        """
+        sample_stride = (data_length - self._SAMPLE_SIZE) // (self._SAMPLE_COUNT - 1)
+        sample_length = 0
+        compressed_length = 0
+        with open(src_name, 'rb') as in_fp:
+            for sample_idx in range(self._SAMPLE_COUNT):
+                in_fp.seek(sample_idx * sample_stride, os.SEEK_SET)
+                sample = in_fp.read(self._SAMPLE_SIZE)
+                sample_length += len(sample)
+                compressed_length += len(zlib.compress(sample, level=1))
+        return sample_length, compressed_length
+
+    def _write_file_deduplicated(self, out_fp, src_name, dest_name, typecode, compress=False):
+        """
+        Stream copy a large file into the archive, unless a file with identical contents has already been written. In
+        the latter case, return an alias TOC entry that refers to the already-written data blob.
+        """
+        # Empty files are not worth de-duplicating; and since their data blobs have zero length, the aliased entry could
+        # not be unambiguously identified by its data offset.
+        if os.stat(src_name).st_size == 0:
+            return self._write_file(out_fp, src_name, dest_name, typecode, compress=compress)
+
+        digest = hashlib.sha256()
+        with open(src_name, 'rb') as in_fp:
+            for chunk in iter(lambda: in_fp.read(64 * 1024), b''):
+                digest.update(chunk)
+        key = (typecode, bool(compress), digest.digest())
+
+        written_entry = self._written_files.get(key)
+        if written_entry is not None:
+            data_offset, compressed_length, data_length, compress, _, _, digest = written_entry
+            return (data_offset, compressed_length, data_length, compress, 'h', dest_name, digest)
+
+        toc_entry = self._write_file(out_fp, src_name, dest_name, typecode, compress=compress)
+        self._written_files[key] = toc_entry
+        return toc_entry
 
     @classmethod
     def _serialize_toc(cls, toc):
         serialized_toc = []
         for toc_entry in toc:
-            data_offset, compressed_length, data_length, compress, typecode, name = toc_entry
+            data_offset, compressed_length, data_length, compress, typecode, name, _ = toc_entry
 
             # Encode names as UTF-8. This should be safe as standard python modules only contain ASCII-characters (and
             # standard shared libraries should have the same), and thus the C-code still can handle this correctly.
@@ -300,6 +646,67 @@ def _serialize_toc(cls, toc):
 
         return b''.join(serialized_toc)
 
+    @classmethod
+    def _serialize_toc_v2(cls, toc):
+        """
+        Serialize the TOC in archive format version 2. Returns serialized TOC data, number of entries, and number of
+        sections.
+        """
+        string_pool = bytearray()
+        name_offsets = {}  # Identical names (for example, of repeated OPTION entries) are stored only once.
+
+        serialized_entries = []
+        for toc_entry in toc:
+            data_offset, compressed_length, data_length, compress, typecode, name, digest = toc_entry
+
+            # Encode names as UTF-8; see the comment in `_serialize_toc`.
+            name = name.encode('utf-8')
+            name_offset = name_offsets.get(name)
+            if name_offset is None:
+                name_offset = name_offsets[name] = len(string_pool)
+                string_pool += name + b'\0'
+
+            serialized_entries.append(
+                struct.pack(
+                    cls._TOC_ENTRY_V2_FORMAT,
+                    data_offset,
+                    compressed_length,
+                    data_length,
+                    name_offset,
+                    digest,
+                    compress,
+                    typecode.encode('ascii'),
+                )
+            )
+
+        # The string pool must not be empty; the bootloader requires it to be NULL-terminated.
+        if not string_pool:
+            string_pool += b'\0'
+
+        # Group the entries by typecode, preserving their order within each group (`sorted` is stable); the section
+        # table is sorted by typecode as well, allowing the bootloader to look up sections using binary search.
+        entry_index = sorted(range(len(toc)), key=lambda idx: toc[idx][4].encode('ascii'))
+        serialized_sections = []
+        index_start = 0
+        while index_start < len(entry_index):
+            typecode = toc[entry_index[index_start]][4]
+            count = 1
+            while index_start + count < len(entry_index) and toc[entry_index[index_start + count]][4] == typecode:
+                count += 1
+            serialized_sections.append(
+                struct.pack(cls._TOC_SECTION_FORMAT, typecode.encode('ascii'), index_start, count)
+            )
+            index_start += count
+
+        toc_data = b''.join([
+            *serialized_entries,
+            *serialized_sections,
+            struct.pack(f'!{len(entry_index)}I', *entry_index),
+            string_pool,
+        ])
+
+        return toc_data, len(serialized_entries), len(serialized_sections)
+
 
 class SplashWriter:
     """
@@ -15,15 +15,21 @@
 is a way how PyInstaller does the dependency analysis and creates executable.
 """
 
+import fnmatch
+import hashlib
+import itertools
+import marshal
 import os
 import subprocess
 import time
 import pathlib
 import shutil
+import struct
 from operator import itemgetter
 
 from PyInstaller import HOMEPATH, PLATFORM
 from PyInstaller import log as logging
+from PyInstaller.archive.readers import CArchiveReader
 from PyInstaller.archive.writers import CArchiveWriter, ZlibArchiveWriter
 from PyInstaller.building.datastruct import Target, _check_guts_eq, normalize_pyz_toc, normalize_toc
 from PyInstaller.building.utils import (
@@ -49,6 +55,8 @@ class PYZ(Target):
     """
     Creates a zlib-based PYZ archive that contains byte-compiled pure Python modules.
     """
+    _deferrable = True
+
     def __init__(self, *tocs, **kwargs):
         """
         tocs
@@ -104,12 +112,17 @@ def __init__(self, *tocs, **kwargs):
         bootstrap_module_names = set(name for name, _, typecode in self.dependencies if typecode == 'PYMODULE')
         self.toc = []
         self.code_dict = {}
+        lazy_modules = set()
         for toc in tocs:
             # Check if code cache association exists for the given TOC list
             code_cache = CONF['code_cache'].get(id(toc))
             if code_cache is not None:
                 self.code_dict.update(code_cache)
 
+            # Check if the set of modules with deferred execution (see the `lazy_imports` option of Analysis) is
+            # associated with the given TOC list.
+            lazy_modules.update(CONF.get('lazy_imports', {}).get(id(toc), ()))
+
             for entry in toc:
                 name, _, typecode = entry
                 # PYZ expects only PYMODULE entries (python code objects).
@@ -125,12 +138,15 @@ def __init__(self, *tocs, **kwargs):
         # Alphabetically sort the TOC to enable reproducible builds.
         self.toc.sort()
 
+        self.lazy_modules = sorted(lazy_modules.intersection(name for name, *_ in self.toc))
+
         self.__postinit__()
 
     _GUTS = (
         # input parameters
         ('name', _check_guts_eq),
         ('toc', _check_guts_toc),
+        ('lazy_modules', _check_guts_eq),
         # no calculated/analysed values
     )
 
@@ -156,7 +172,7 @@ def assemble(self):
         self.code_dict = {name: strip_paths_in_code(code) for name, code in self.code_dict.items()}
 
         # Create the archive
-        ZlibArchiveWriter(self.name, archive_toc, code_dict=self.code_dict)
+        ZlibArchiveWriter(self.name, archive_toc, code_dict=self.code_dict, lazy_modules=self.lazy_modules)
         logger.info("Building PYZ (ZlibArchive) %s completed successfully.", self.name)
 
 
@@ -165,6 +181,8 @@ class PKG(Target):
     Creates a CArchive. CArchive is the data structure that is embedded into the executable. This data structure allows
     to include various read-only data in a single-file deployment.
     """
+    _deferrable = True
+
     xformdict = {
         # PYMODULE entries are already byte-compiled, so we do not need to encode optimization level in the low-level
         # typecodes. PYSOURCE entries are byte-compiled by the underlying writer, so we need to pass the optimization
@@ -183,6 +201,7 @@ class PKG(Target):
         'ZIPFILE': 'Z',
         'EXECUTABLE': 'b',
         'DEPENDENCY': 'd',
+        'SHARED_PYZ': 'y',
         'SPLASH': 'l',
         'SYMLINK': 'n',
     }
@@ -199,7 +218,14 @@ def __init__(
         upx_exclude=None,
         target_arch=None,
         codesign_identity=None,
-        entitlements_file=None
+        entitlements_file=None,
+        align_uncompressed=False,
+        deduplicate=False,
+        compression_threshold=None,
+        lazy_extensions=False,
+        lazy_data=None,
+        incremental=False,
+        format_version=None,
     ):
         """
         toc
@@ -211,13 +237,39 @@ def __init__(
         cdict
             Dictionary that specifies compression by typecode. For Example, PYZ is left uncompressed so that it
             can be accessed inside the PKG. The default uses sensible values. If zlib is not available, no
-            compression is used.
+            compression is used. Instead of a boolean flag, the value may also be an integer zlib compression level
+            (1 to 9; 0 disables compression).
         exclude_binaries
             If True, EXTENSIONs and BINARYs will be left out of the PKG, and forwarded to its container (usually
             a COLLECT).
         strip_binaries
             If True, use 'strip' command to reduce the size of binary files.
         upx_binaries
+        align_uncompressed
+            If True, data of uncompressed entries that are extracted at run-time is aligned to the filesystem block
+            size (4 KiB), which allows the bootloader to clone it into extracted files on copy-on-write filesystems.
+        deduplicate
+            If True, files with identical contents are stored in the PKG only once, and are extracted as hard links.
+        compression_threshold
+            Minimal relative size reduction (e.g., 0.02) that compression must achieve for an entry to be stored
+            compressed. If None, entries are always compressed according to ``cdict``.
+        lazy_extensions
+            Either True or a list of `fnmatch`-style patterns that are matched against destination names of extension
+            modules. The extension modules (except for those from python's `lib-dynload` directory) and the shared
+            libraries that only they depend on are stored as on-demand entries, which are extracted at run-time only
+            when the corresponding extension module is imported.
+        lazy_data
+            Either True or a list of `fnmatch`-style patterns that are matched against destination names of DATA
+            entries. The matching entries are stored as on-demand entries, which are read directly from the archive at
+            run-time, and extracted only if opened in a mode other than read-only mode.
+        incremental
+            If True, the PKG is updated in-place when re-built: the data of entries whose source files did not change
+            is kept, and only the data of changed and new entries is written. The PKG is compacted when its stale data
+            exceeds `PKG_INCREMENTAL_MAX_WASTE` fraction of its size.
+        format_version
+            Version of the PKG format. Version 2 supports archives larger than 4 GiB, and stores digests of entries'
+            data (see `CArchiveWriter`), but can be read only by the bootloaders that were built with its support. If
+            None, `PKG_FORMAT_VERSION` is used.
         """
         super().__init__()
 
@@ -234,6 +286,21 @@ def __init__(
         self.target_arch = target_arch
         self.codesign_identity = codesign_identity
         self.entitlements_file = entitlements_file
+        self.align_uncompressed = align_uncompressed
+        self.deduplicate = deduplicate
+        self.compression_threshold = compression_threshold
+        self.lazy_extensions = lazy_extensions
+        self.lazy_data = lazy_data
+        self.incremental = incremental
+        self.format_version = format_version or PKG_FORMAT_VERSION
+
+        # In onedir mode (`exclude_binaries` is set), the binaries and data files are not collected into the PKG, but
+        # are passed on to the parent container (the COLLECT) via `dependencies` (see `assemble()` for details).
+        # Determine them here rather than in `assemble()`, because EXE and COLLECT read them when they are constructed,
+        # which precedes the assembly of PKG if the assembly is deferred to a worker process (see `--jobs`).
+        if self.exclude_binaries:
+            self.dependencies = [(dest_name, src_name, typecode) for dest_name, src_name, typecode in self.toc
+                                 if typecode in ('BINARY', 'EXTENSION', 'DATA', 'ZIPFILE')]
 
         # This dict tells PyInstaller what items embedded in the executable should be compressed.
         if self.cdict is None:
@@ -265,6 +332,13 @@ def __init__(
         ('target_arch', _check_guts_eq),
         ('codesign_identity', _check_guts_eq),
         ('entitlements_file', _check_guts_eq),
+        ('align_uncompressed', _check_guts_eq),
+        ('deduplicate', _check_guts_eq),
+        ('compression_threshold', _check_guts_eq),
+        ('lazy_extensions', _check_guts_eq),
+        ('lazy_data', _check_guts_eq),
+        ('incremental', _check_guts_eq),
+        ('format_version', _check_guts_eq),
         # no calculated/analysed values
     )
 
@@ -275,6 +349,7 @@ def assemble(self):
 
         bootstrap_toc = []  # TOC containing bootstrap scripts and modules, which must not be sorted.
         archive_toc = []  # TOC containing all other elements. Sorted to enable reproducible builds.
+        extension_names = set()  # Names of collected EXTENSION entries; candidates for on-demand extraction.
 
         for dest_name, src_name, typecode in self.toc:
             # Ensure that the source file exists, if necessary. Skip the check for OPTION entries, where 'src_name' is
@@ -307,7 +382,9 @@ def assemble(self):
                     # keep code simple, we now also do it for BINARY entries. In a sane world, we do not expect to
                     # encounter them here; but if they do happen to pass through here and we pass them on, the
                     # container's TOC de-duplication should take care of them (same as with EXTENSION ones, really).
-                    self.dependencies.append((dest_name, src_name, typecode))
+                    #
+                    # The entries are added to `dependencies` in `__init__()`.
+                    continue
                 else:
                     # This is onefile-specific codepath. The binaries (both EXTENSION and BINARY entries) need to be
                     # processed using `process_collected_binary` helper.
@@ -322,6 +399,8 @@ def assemble(self):
                         entitlements_file=self.entitlements_file,
                         strict_arch_validation=(typecode == 'EXTENSION'),
                     )
+                    if typecode == 'EXTENSION':
+                        extension_names.add(dest_name)
                     archive_toc.append((dest_name, src_name, self.cdict.get(typecode, False), self.xformdict[typecode]))
             elif typecode in ('DATA', 'ZIPFILE'):
                 # Same logic as above for BINARY and EXTENSION; if `exclude_binaries` is set, we are in onedir mode;
@@ -329,12 +408,14 @@ def assemble(self):
                 # prevents a onedir application from becoming a broken onefile one if user accidentally passes datas
                 # and binaries TOCs to EXE instead of COLLECT.
                 if self.exclude_binaries:
-                    self.dependencies.append((dest_name, src_name, typecode))
+                    continue  # The entries are added to `dependencies` in `__init__()`.
                 else:
                     if typecode == 'DATA' and os.access(src_name, os.X_OK):
                         # DATA with executable bit set (e.g., shell script); turn into binary so that executable bit is
                         # restored on the extracted file.
                         carchive_typecode = 'b'
+                    elif typecode == 'DATA' and self._is_lazy_data(dest_name):
+                        carchive_typecode = 'r'
                     else:
                         carchive_typecode = self.xformdict[typecode]
                     archive_toc.append((dest_name, src_name, self.cdict.get(typecode, False), carchive_typecode))
@@ -344,22 +425,163 @@ def assemble(self):
                 # Collect python script and modules in a TOC that will not be sorted.
                 bootstrap_toc.append((dest_name, src_name, self.cdict.get(typecode, False), self.xformdict[typecode]))
             else:
-                # PYZ, PKG, DEPENDENCY, SPLASH, SYMLINK
+                # PYZ, PKG, DEPENDENCY, SHARED_PYZ, SPLASH, SYMLINK
                 archive_toc.append((dest_name, src_name, self.cdict.get(typecode, False), self.xformdict[typecode]))
 
+        if self.lazy_extensions and extension_names:
+            archive_toc = self._defer_extension_modules(archive_toc, extension_names)
+
         # Sort content alphabetically by type and name to enable reproducible builds.
         archive_toc.sort(key=itemgetter(3, 0))
         # Do *not* sort modules and scripts, as their order is important.
         # TODO: Think about having all modules first and then all scripts.
-        CArchiveWriter(self.name, bootstrap_toc + archive_toc, pylib_name=self.python_lib_name)
+        writer = CArchiveWriter(
+            self.name,
+            bootstrap_toc + archive_toc,
+            pylib_name=self.python_lib_name,
+            alignment=PKG_DATA_ALIGNMENT if self.align_uncompressed else None,
+            deduplicate=self.deduplicate,
+            compression_threshold=self.compression_threshold,
+            layout_file=self.name + '.layout' if self.incremental else None,
+            max_waste=PKG_INCREMENTAL_MAX_WASTE,
+            format_version=self.format_version,
+        )
+        if writer.num_reused_entries:
+            logger.info("Updated PKG in-place, reusing the data of %d entries", writer.num_reused_entries)
 
         logger.info("Building PKG (CArchive) %s completed successfully.", os.path.basename(self.name))
 
+    def _is_lazy_data(self, dest_name):
+        """
+        Check whether the DATA entry with given destination name should be stored as on-demand entry, as per the
+        `lazy_data` setting.
+        """
+        if not self.lazy_data:
+            return False
+        if self.lazy_data is True:
+            return True
+        dest_name = pathlib.PurePath(dest_name).as_posix()
+        return any(fnmatch.fnmatch(dest_name, pattern) for pattern in self.lazy_data)
+
+    def _is_lazy_extension(self, dest_name):
+        """
+        Check whether the extension module with given destination name should be stored as on-demand entry, as per the
+        `lazy_extensions` setting.
+        """
+        if self.lazy_extensions is True:
+            return True
+        dest_name = pathlib.PurePath(dest_name).as_posix()
+        return any(fnmatch.fnmatch(dest_name, pattern) for pattern in self.lazy_extensions)
+
+    def _defer_extension_modules(self, archive_toc, extension_names):
+        """
+        Turn the collected extension modules into on-demand entries (typecode 'e'), along with the shared libraries
+        that are required only by them. Extension modules from python's `lib-dynload` directory are exempt, because
+        they might be needed before the frozen importer is set up.
+
+        The link-time dependencies of all collected binaries are resolved against the names of collected binaries (and
+        symbolic links), and their transitive closure is computed. Shared libraries that are not in the closure of
+        the eagerly-extracted binaries (the python shared library, executables, exempt extension modules, and shared
+        libraries that are not required by any of the deferred extension modules; for example, libraries loaded via
+        `ctypes`) are deferred as well. The index that maps each deferred extension module onto the deferred shared
+        libraries in its dependency closure is stored in the PKG (typecode 'i'), and is used at run-time to extract the
+        libraries before the extension module.
+
+        Returns the modified TOC.
+        """
+        binaries = {dest_name: src_name for dest_name, src_name, _, typecode in archive_toc if typecode == 'b'}
+        symlinks = {
+            dest_name: os.path.normpath(os.path.join(os.path.dirname(dest_name), src_name))
+            for dest_name, src_name, _, typecode in archive_toc if typecode == 'n'
+        }
+
+        # Index the collected binaries and symbolic links by their base name, which is what link-time dependencies are
+        # resolved against (via library search path or rpath).
+        binaries_by_basename = {}
+        for dest_name in (*binaries, *symlinks):
+            binaries_by_basename.setdefault(os.path.basename(dest_name), []).append(dest_name)
+
+        dependencies_cache = {}
+
+        def _get_dependencies(dest_name):
+            dependencies = dependencies_cache.get(dest_name)
+            if dependencies is not None:
+                return dependencies
+            dependencies = set()
+            try:
+                imported_libs = bindepend.get_imports(binaries[dest_name])
+            except Exception as e:
+                logger.warning("Failed to obtain the link-time dependencies of %r: %s", dest_name, e)
+                imported_libs = []
+            for lib_name, _ in imported_libs:
+                for candidate in binaries_by_basename.get(os.path.basename(lib_name), []):
+                    # Follow symbolic links to the actual binary.
+                    seen_symlinks = set()
+                    while candidate in symlinks and candidate not in seen_symlinks:
+                        seen_symlinks.add(candidate)
+                        candidate = symlinks[candidate]
+                    if candidate in binaries and candidate != dest_name:
+                        dependencies.add(candidate)
+            dependencies_cache[dest_name] = dependencies
+            return dependencies
+
+        def _get_closure(roots):
+            closure = set()
+            pending = list(roots)
+            while pending:
+                dest_name = pending.pop()
+                for dependency in _get_dependencies(dest_name):
+                    if dependency not in closure:
+                        closure.add(dependency)
+                        pending.append(dependency)
+            return closure
+
+        deferred_extensions = {
+            dest_name
+            for dest_name in extension_names
+            if dest_name in binaries and pathlib.PurePath(dest_name).parts[0] != 'lib-dynload'
+            and self._is_lazy_extension(dest_name)
+        }
+        if not deferred_extensions:
+            return archive_toc
+
+        extensions_closure = _get_closure(deferred_extensions)
+        eager_roots = set(binaries) - deferred_extensions - extensions_closure
+        eager_binaries = eager_roots | _get_closure(eager_roots)
+        deferred_binaries = (deferred_extensions | extensions_closure) - eager_binaries
+        if not deferred_binaries:
+            return archive_toc
+
+        index = {
+            dest_name: sorted(_get_closure([dest_name]) & deferred_binaries)
+            for dest_name in sorted(deferred_extensions & deferred_binaries)
+        }
+
+        logger.info(
+            "Deferring extraction of %d extension module(s) and %d shared library file(s) to run-time.",
+            len(index),
+            len(deferred_binaries) - len(index),
+        )
+
+        index_file = os.path.splitext(self.name)[0] + '-lazy-binaries.dat'
+        with open(index_file, 'wb') as fp:
+            marshal.dump(index, fp)
+
+        archive_toc = [
+            (dest_name, src_name, compress, 'e' if dest_name in deferred_binaries else typecode)
+            for dest_name, src_name, compress, typecode in archive_toc
+        ]
+        archive_toc.append(('pyi-lazy-binaries', index_file, True, 'i'))
+
+        return archive_toc
+
 
 class EXE(Target):
     """
     Creates the final executable of the frozen app. This bundles all necessary files together.
     """
+    _deferrable = True
+
     def __init__(self, *args, **kwargs):
         """
         args
@@ -372,6 +594,44 @@ def __init__(self, *args, **kwargs):
                 it will forward all signals to the child process. Useful in situations where for example a supervisor
                 process signals both the bootloader and the child (e.g., via a process group) to avoid signalling the
                 child twice.
+            deferred_cleanup
+                Non-Windows onefile mode only. If True, the bootloader's parent process does not wait for the removal
+                of the application's temporary directory after the child process exits. Instead, the directory is
+                renamed (to a name with ``.deleted`` suffix), and removed by a detached, low-priority helper process.
+                If strict unpack mode is enabled (``PYINSTALLER_STRICT_UNPACK_MODE`` environment variable), the
+                directory is removed synchronously, so that failure to remove it can be reported.
+            fast_exit
+                If True, the process that runs the frozen application's code does not finalize the Python interpreter
+                before exiting. Instead, it waits for non-daemon threads, runs the `atexit` handlers, flushes the
+                standard streams, and terminates immediately, leaving the reclamation of resources to the OS. This
+                speeds up the exit of short-lived applications with many loaded modules; however, it skips the
+                destruction of module objects (and thus their `__del__` methods and C-level finalizers). The exit code
+                is preserved (and propagated by the parent process in onefile mode).
+            io_uring_extraction
+                Linux onefile mode only. If True, the bootloader's parent process extracts the application's files
+                using batched io_uring requests instead of a series of blocking system calls for each file. Requires
+                Linux 5.18 or later; if io_uring is unavailable (for example, disabled via sysctl or forbidden by a
+                seccomp filter), the files are extracted using the regular code path.
+            onefile_exec_waiter
+                Non-Windows onefile mode only. If True, the bootloader's parent process replaces itself (via ``exec``)
+                with a fresh, minimal instance of the bootloader after starting the child process. The new instance
+                keeps forwarding signals to the child process and removes the temporary directory after the child
+                exits, but does not retain any memory that the parent process used during extraction. This reduces the
+                memory footprint of idle parent processes on hosts that run many instances of the application. Not
+                applicable if the splash screen is used.
+            usage_recorder
+                If True, the frozen application records the modules and files that it uses at run-time into the
+                usage profile file named by the ``PYINSTALLER_USAGE_PROFILE`` environment variable (see
+                `Analysis.apply_usage_profile`). Meant for dedicated profiling builds; if False (the default), the
+                environment variable is ignored.
+            readahead_binaries
+                Either an integer N, or a list of destination names of shared libraries (relative to the application's
+                top-level directory). If specified, the bootloader starts a low-priority background thread that reads
+                the listed files into the OS page cache while the Python interpreter is being initialized, so that
+                the subsequent loading of large extension modules and their dependencies does not need to wait for
+                the disk. If an integer is given, the N largest binaries and extension modules are selected among
+                those collected by the `Analysis` whose `scripts` are passed to the EXE (in both onefile and onedir
+                mode), and among those passed to the EXE directly.
             console
                 On Windows or macOS governs whether to use the console executable or the windowed executable. Always
                 True on Linux/Unix (always console executable - it does not matter there).
@@ -389,6 +649,11 @@ def __init__(self, *args, **kwargs):
             debug
                 Setting to True gives you progress messages from the executable (for console=False there will be
                 annoying MessageBoxes on Windows).
+            optimized_bootloader
+                Use the optimized variant of the bootloader, which is built with link-time and/or profile-guided
+                optimization. The optimized variants are not included in the pre-compiled bootloaders; they need to
+                be built by configuring the bootloader build with ``--lto`` and/or ``--pgo`` options. Ignored if
+                ``debug`` is enabled.
             name
                 The filename for the executable. On Windows suffix '.exe' is appended.
             exclude_binaries
@@ -421,6 +686,55 @@ def __init__(self, *args, **kwargs):
             contents_directory
                 Onedir mode only. Specifies the name of the directory where all files par the executable will be placed.
                 Setting the name to '.' (or '' or None) re-enables old onedir layout without contents directory.
+            align_uncompressed
+                Onefile mode only; effective only on Linux. Align data of uncompressed entries in the PKG (and the PKG
+                itself within the executable) to the filesystem block size, so that the bootloader can extract them by
+                sharing data extents with the executable (FICLONERANGE) on copy-on-write filesystems such as btrfs or
+                XFS. Requires the entries to be stored uncompressed (see ``cdict``).
+            deduplicate
+                Onefile mode only. Store the binaries and data files with identical contents in the PKG only once. At
+                run-time, the duplicates are extracted as hard links to the first extracted copy (or as copies, if hard
+                links cannot be created). Note that modifying an extracted file at run-time thus also modifies its
+                duplicates.
+            cdict
+                Dictionary that specifies compression of PKG entries by their typecode (for example, ``'DATA'`` or
+                ``'BINARY'``); the values are either boolean flags, or integer zlib compression levels (0 to 9).
+            lazy_extensions
+                Onefile mode only. Defer the extraction of extension modules (other than those from python's
+                `lib-dynload` directory) and of the shared libraries that are required only by them; either True (all
+                extension modules) or a list of `fnmatch`-style patterns (for example, ``'mypackage/*'``) matched
+                against the destination names of extension modules. The parent process extracts only the remaining
+                files, and the deferred binaries are extracted into the temporary directory when the corresponding
+                extension module is imported for the first time. This speeds up the start-up of applications that
+                bundle large packages with many extension modules, of which only a few are used in a given run. The
+                dependencies of extension modules are determined from their link-time dependencies; shared libraries
+                that are also loaded by other means (for example, via `ctypes`) while being required by a deferred
+                extension module might not be available until that extension module is imported.
+            lazy_data
+                Onefile mode only. Either True or a list of `fnmatch`-style patterns (for example,
+                ``'mypackage/data/*'``) that select the data files that are not extracted by the parent process.
+                Instead, the frozen application reads them directly from the executable when they are accessed via
+                `importlib.resources`, the `get_data()` method of the module's loader, or opened for reading with
+                `open()` (using the path under `sys._MEIPASS`). Opening such file in any other mode extracts it first.
+                The files do not exist on the filesystem until then, so checks such as `os.path.exists()` and directory
+                listings (including the legacy `importlib.resources.contents()` and `is_resource()` functions) do not
+                see them.
+            compression_threshold
+                Minimal relative size reduction that compression must achieve for a PKG entry to be stored compressed.
+                Entries that do not meet it (for example, already-compressed archives, images, or UPX-compressed
+                binaries) are stored uncompressed, which saves time both at build time and at run-time. The size
+                reduction of large files is estimated from data samples. A threshold of 0.02 (2%) is a reasonable
+                choice. The default is None, in which case the entries are always compressed according to ``cdict``.
+            incremental_pkg
+                Update the PKG in-place on re-builds, instead of re-writing it from scratch: the data of entries whose
+                source files did not change stays in place, and only the data of changed and new entries is compressed
+                and appended to the PKG. This speeds up the edit-build-run cycle with large PKGs (especially in onefile
+                mode), at the cost of the PKG containing stale data, up to a quarter of its size; once that is exceeded,
+                the PKG is re-written from scratch. Intended for development builds; the resulting builds are not
+                reproducible.
+            pkg_format_version
+                Version of the PKG format (see the `format_version` option of PKG). Version 2 requires a bootloader
+                that supports it; the default is `PKG_FORMAT_VERSION`.
         """
         from PyInstaller.config import CONF
 
@@ -429,10 +743,17 @@ def __init__(self, *args, **kwargs):
         # Available options for EXE in .spec files.
         self.exclude_binaries = kwargs.get('exclude_binaries', False)
         self.bootloader_ignore_signals = kwargs.get('bootloader_ignore_signals', False)
+        self.deferred_cleanup = kwargs.get('deferred_cleanup', False)
+        self.fast_exit = kwargs.get('fast_exit', False)
+        self.io_uring_extraction = kwargs.get('io_uring_extraction', False)
+        self.onefile_exec_waiter = kwargs.get('onefile_exec_waiter', False)
+        self.usage_recorder = kwargs.get('usage_recorder', False)
+        self.readahead_binaries = kwargs.get('readahead_binaries', None)
         self.console = kwargs.get('console', True)
         self.hide_console = kwargs.get('hide_console', None)
         self.disable_windowed_traceback = kwargs.get('disable_windowed_traceback', False)
         self.debug = kwargs.get('debug', False)
+        self.optimized_bootloader = kwargs.get('optimized_bootloader', False)
         self.name = kwargs.get('name', None)
         self.icon = kwargs.get('icon', None)
         self.versrsrc = kwargs.get('version', None)
@@ -444,6 +765,13 @@ def __init__(self, *args, **kwargs):
         self.contents_directory = kwargs.get("contents_directory", "_internal")
         # If ``append_pkg`` is false, the archive will not be appended to the exe, but copied beside it.
         self.append_pkg = kwargs.get('append_pkg', True)
+        self.align_uncompressed = kwargs.get('align_uncompressed', False)
+        self.deduplicate = kwargs.get('deduplicate', False)
+        self.compression_threshold = kwargs.get('compression_threshold', None)
+        self.lazy_extensions = kwargs.get('lazy_extensions', False)
+        self.lazy_data = kwargs.get('lazy_data', None)
+        self.incremental_pkg = kwargs.get('incremental_pkg', False)
+        self.pkg_format_version = kwargs.get('pkg_format_version', PKG_FORMAT_VERSION)
 
         # On Windows allows the exe to request admin privileges.
         self.uac_admin = kwargs.get('uac_admin', False)
@@ -533,6 +861,7 @@ def __init__(self, *args, **kwargs):
         self.pkgname = os.path.join(CONF['workpath'], base_name + '.pkg')
 
         self.toc = []
+        collected_binaries = []  # Binaries collected by Analysis instances whose `scripts` are passed to EXE.
 
         for arg in args:
             # Valid arguments: PYZ object, Splash object, and TOC-list iterables
@@ -546,6 +875,7 @@ def __init__(self, *args, **kwargs):
             elif miscutils.is_iterable(arg):
                 # TOC-like iterable
                 self.toc.extend(arg)
+                collected_binaries.extend(CONF.get('collected_binaries', {}).get(id(arg), []))
             else:
                 raise TypeError(f"Invalid argument type for EXE: {type(arg)!r}")
 
@@ -561,6 +891,30 @@ def __init__(self, *args, **kwargs):
             # no value; presence means "true"
             self.toc.append(("pyi-bootloader-ignore-signals", "", "OPTION"))
 
+        if self.deferred_cleanup:
+            # no value; presence means "true"
+            self.toc.append(("pyi-deferred-cleanup", "", "OPTION"))
+
+        if self.fast_exit:
+            # no value; presence means "true"
+            self.toc.append(("pyi-fast-exit", "", "OPTION"))
+
+        if self.io_uring_extraction:
+            # no value; presence means "true"
+            self.toc.append(("pyi-io-uring-extraction", "", "OPTION"))
+
+        if self.onefile_exec_waiter:
+            # no value; presence means "true"
+            self.toc.append(("pyi-onefile-exec-waiter", "", "OPTION"))
+
+        if self.usage_recorder:
+            # no value; presence means "true"
+            self.toc.append(("pyi-usage-recorder", "", "OPTION"))
+
+        if self.readahead_binaries:
+            for dest_name in self._select_readahead_binaries(self.readahead_binaries, collected_binaries):
+                self.toc.append(("pyi-readahead " + dest_name, "", "OPTION"))
+
         if self.disable_windowed_traceback:
             # no value; presence means "true"
             self.toc.append(("pyi-disable-windowed-traceback", "", "OPTION"))
@@ -647,7 +1001,14 @@ def __init__(self, *args, **kwargs):
             upx_exclude=self.upx_exclude,
             target_arch=self.target_arch,
             codesign_identity=self.codesign_identity,
-            entitlements_file=self.entitlements_file
+            entitlements_file=self.entitlements_file,
+            align_uncompressed=self.align_uncompressed,
+            deduplicate=self.deduplicate,
+            compression_threshold=self.compression_threshold,
+            lazy_extensions=self.lazy_extensions,
+            lazy_data=self.lazy_data,
+            incremental=self.incremental_pkg,
+            format_version=self.pkg_format_version,
         )
         self.dependencies = self.pkg.dependencies
 
@@ -669,6 +1030,13 @@ def __init__(self, *args, **kwargs):
         ('uac_uiaccess', _check_guts_eq),
         ('manifest', _check_guts_eq),
         ('append_pkg', _check_guts_eq),
+        ('align_uncompressed', _check_guts_eq),
+        ('deduplicate', _check_guts_eq),
+        ('compression_threshold', _check_guts_eq),
+        ('lazy_extensions', _check_guts_eq),
+        ('lazy_data', _check_guts_eq),
+        ('incremental_pkg', _check_guts_eq),
+        ('pkg_format_version', _check_guts_eq),
         ('argv_emulation', _check_guts_eq),
         ('target_arch', _check_guts_eq),
         ('codesign_identity', _check_guts_eq),
@@ -717,6 +1085,38 @@ def _makeabs(path):
         else:
             return os.path.join(CONF['specpath'], path)
 
+    def _select_readahead_binaries(self, readahead_binaries, collected_binaries):
+        """
+        Resolve the `readahead_binaries` option into list of destination names of binaries. If an integer is given,
+        the binaries are selected among the BINARY and EXTENSION entries of EXE's TOC and `collected_binaries` (the
+        binaries collected by the associated Analysis, which, in onedir mode, are passed only to COLLECT).
+        """
+        if isinstance(readahead_binaries, bool) or not isinstance(readahead_binaries, int):
+            return [os.path.normpath(dest_name) for dest_name in readahead_binaries]
+
+        # The python shared library is loaded before the readahead thread is started, so there is no point in
+        # selecting it.
+        python_lib = bindepend.get_python_library_path()
+        python_lib_name = os.path.basename(python_lib) if python_lib else None
+
+        binaries = {}
+        for dest_name, src_name, typecode in itertools.chain(self.toc, collected_binaries):
+            if typecode not in ('BINARY', 'EXTENSION') or dest_name == python_lib_name:
+                continue
+            if not os.path.isfile(src_name):
+                continue
+            binaries.setdefault(os.path.normpath(dest_name), src_name)
+
+        binaries = sorted(binaries.items(), key=lambda entry: os.path.getsize(entry[1]), reverse=True)
+        selected = [dest_name for dest_name, src_name in binaries[:readahead_binaries]]
+        if not selected:
+            logger.warning(
+                "EXE: readahead_binaries=%d did not select any binaries; make sure that the `scripts` TOC of the "
+                "Analysis is passed to EXE, or list the binaries explicitly.", readahead_binaries
+            )
+        logger.debug("EXE: selected binaries for readahead: %r", selected)
+        return selected
+
     def _bootloader_file(self, exe, extension=None):
         """
         Pick up the right bootloader file - debug, console, windowed.
@@ -728,11 +1128,19 @@ def _bootloader_file(self, exe, extension=None):
         # There are two types of bootloaders:
         # run     - release, no verbose messages in console.
         # run_d   - contains verbose messages in console.
+        # run_o   - release, built with link-time and/or profile-guided optimization.
         if self.debug:
             exe = exe + '_d'
+        elif self.optimized_bootloader:
+            exe = exe + '_o'
         if extension:
             exe = exe + extension
         bootloader_file = os.path.join(HOMEPATH, 'PyInstaller', 'bootloader', PLATFORM, exe)
+        if self.optimized_bootloader and not self.debug and not os.path.exists(bootloader_file):
+            raise SystemExit(
+                f"Optimized bootloader {bootloader_file!r} does not exist! Build it by configuring the bootloader "
+                "build with --lto and/or --pgo options (e.g., 'python ./waf --lto --pgo all')."
+            )
         logger.info('Bootloader %s' % bootloader_file)
         return bootloader_file
 
@@ -804,11 +1212,18 @@ def assemble(self):
             # slightly different from the stock bootloader executables, which should prevent antivirus programs from
             # flagging our stock bootloaders due to sideload-enabled applications in the wild.
 
+            # The signature also contains the digest of the PKG file, which the bootloader verifies before loading the
+            # side-loaded PKG. This ensures that the executable runs only with the PKG that it was built with.
+            pkg_digest, pkg_length = _compute_pkg_digest(self.pkg.name, PKG_DIGEST_CHUNK_SIZE)
+
             # Write to temporary file
             pkgsig_file = self.pkg.name + '.sig'
             with open(pkgsig_file, "wb") as f:
                 # 8-byte MAGIC; slightly changed PKG MAGIC pattern
                 f.write(b'MEI\015\013\012\013\016')
+                # Chunk size (32-bit), PKG length (64-bit), and 32-byte digest; see `_compute_pkg_digest`.
+                f.write(struct.pack('!IQ', PKG_DIGEST_CHUNK_SIZE, pkg_length))
+                f.write(pkg_digest)
 
             append_file = pkgsig_file  # Append PKG-SIG
             append_type = 'PKG sideload signature'  # For debug messages
@@ -816,10 +1231,24 @@ def assemble(self):
         if is_linux:
             # Linux: append data into custom ELF section using objcopy.
             logger.info("Appending %s to custom ELF section in EXE", append_type)
-            cmd = ['objcopy', '--add-section', f'pydata={append_file}', build_name]
-            p = subprocess.run(cmd, stderr=subprocess.STDOUT, stdout=subprocess.PIPE, encoding='utf-8')
-            if p.returncode:
-                raise SystemError(f"objcopy Failure: {p.returncode} {p.stdout}")
+            self._append_data_to_elf_section(build_name, append_file)
+
+            # If requested, ensure that the PKG is placed at block-aligned offset, so that the block alignment of its
+            # entries is preserved within the executable. The offset of the custom section is determined by preceding
+            # sections, so we can re-create the executable with the PKG data prefixed by the required padding.
+            if self.append_pkg and self.align_uncompressed:
+                pkg_offset = CArchiveReader(build_name).start_offset
+                padding_length = -pkg_offset % PKG_DATA_ALIGNMENT
+                if padding_length:
+                    logger.info("Re-appending %s with %d bytes of alignment padding", append_type, padding_length)
+                    padded_file = self.pkg.name + '.aligned'
+                    with open(padded_file, 'wb') as outf:
+                        outf.write(b'\0' * padding_length)
+                        with open(append_file, 'rb') as inf:
+                            shutil.copyfileobj(inf, outf, length=64 * 1024)
+                    shutil.copyfile(bootloader_exe, build_name)
+                    self._append_data_to_elf_section(build_name, padded_file)
+                    os.remove(padded_file)
 
         elif is_darwin:
             # macOS: remove signature, append data, and fix-up headers so that the appended data appears to be part of
@@ -980,6 +1409,13 @@ def _to_int(value):
             except Exception as e:
                 raise IOError(f"Failed to embed data file {src_filename!r} as Windows resource") from e
 
+    @staticmethod
+    def _append_data_to_elf_section(build_name, append_file):
+        cmd = ['objcopy', '--add-section', f'pydata={append_file}', build_name]
+        p = subprocess.run(cmd, stderr=subprocess.STDOUT, stdout=subprocess.PIPE, encoding='utf-8')
+        if p.returncode:
+            raise SystemError(f"objcopy Failure: {p.returncode} {p.stdout}")
+
     def _append_data_to_exe(self, build_name, append_file):
         with open(build_name, 'ab') as outf:
             with open(append_file, 'rb') as inf:
@@ -1056,6 +1492,8 @@ class COLLECT(Target):
     """
     In one-dir mode creates the output folder with all necessary files.
     """
+    _deferrable = True
+
     def __init__(self, *args, **kwargs):
         """
         args
@@ -1213,7 +1651,7 @@ class MERGE:
     MERGE-processed Analysis gains onefile semantics, because it needs to extract its referenced dependencies from other
     executables into temporary directory before they can run.
     """
-    def __init__(self, *args):
+    def __init__(self, *args, shared_pyz=None):
         """
         args
             Dependencies as a list of (analysis, identifier, path_to_exe) tuples. `analysis` is an instance of
@@ -1222,9 +1660,19 @@ def __init__(self, *args):
             filename component). For onefile executables, `path_to_exe` is usually just executable's base name
             (e.g., `myexecutable`). For onedir executables, `path_to_exe` usually comprises both the application's
             directory name and executable name (e.g., `myapp/myexecutable`).
+        shared_pyz
+            Optional path to the PYZ archive that is shared by the executables, relative to the `dist` directory
+            (e.g., `shared.pyz`). If specified, the python modules that are collected by more than one of the given
+            analyses (same module name and source file) are removed from their `pure` TOCs, and are collected into the
+            shared PYZ archive instead. Each executable references the shared archive, and looks up the modules in it
+            after looking them up in its own PYZ archive. This avoids storing multiple copies of the same byte-compiled
+            modules, and allows the executables that run concurrently to share the archive in the page cache. The
+            shared archive must not be placed into the directory of a onedir application, as `COLLECT` clears the
+            directory.
         """
         self._dependencies = {}
         self._symlinks = set()
+        self.shared_pyz = None
 
         # Process all given (analysis, identifier, path_to_exe) tuples
         for analysis, identifier, path_to_exe in args:
@@ -1245,6 +1693,58 @@ def __init__(self, *args):
             analysis.datas = normalize_toc(datas)
             analysis.dependencies += binaries_refs + datas_refs
 
+        if shared_pyz:
+            self._create_shared_pyz(args, shared_pyz)
+
+    def _create_shared_pyz(self, args, shared_pyz):
+        from PyInstaller.config import CONF
+
+        # Find the modules that are collected by more than one analysis.
+        occurrences = {}
+        for analysis, _, _ in args:
+            for entry in analysis.pure:
+                occurrences[entry] = occurrences.get(entry, 0) + 1
+        shared_entries = {entry for entry, count in occurrences.items() if count > 1}
+        if not shared_entries:
+            logger.info("MERGE: no python modules are shared by the executables; not creating shared PYZ archive.")
+            return
+
+        # Move the shared modules from the `pure` TOCs into the shared TOC, along with their code objects. The modules
+        # are deferred (see the `lazy_imports` option of Analysis) only if they are deferred by all executables.
+        shared_names = {name for name, *_ in shared_entries}
+        shared_pyz_path = os.path.join(CONF['distpath'], shared_pyz)
+        self.shared_toc = sorted(shared_entries)
+        shared_code_cache = {}
+        shared_lazy_modules = None
+        for analysis, _, path_to_exe in args:
+            if not any(entry in shared_entries for entry in analysis.pure):
+                continue
+
+            code_cache = CONF['code_cache'].get(id(analysis.pure)) or {}
+            shared_code_cache.update({name: code for name, code in code_cache.items() if name in shared_names})
+
+            lazy_modules = set(CONF.get('lazy_imports', {}).get(id(analysis.pure), ()))
+            if shared_lazy_modules is None:
+                shared_lazy_modules = lazy_modules
+            else:
+                shared_lazy_modules &= lazy_modules
+
+            # Modify the TOC in-place, to preserve the association with the code cache (and the set of modules with
+            # deferred execution).
+            analysis.pure[:] = [entry for entry in analysis.pure if entry not in shared_entries]
+
+            # Reference to the shared PYZ archive; the path is relative to the executable's parent directory.
+            shared_pyz_ref = os.path.relpath(shared_pyz, os.path.dirname(path_to_exe) or '.')
+            logger.debug("Referencing shared PYZ archive %s from %s as %s", shared_pyz, path_to_exe, shared_pyz_ref)
+            analysis.dependencies.append((shared_pyz_ref, shared_pyz_path, 'SHARED_PYZ'))
+
+        CONF['code_cache'][id(self.shared_toc)] = shared_code_cache
+        if shared_lazy_modules:
+            CONF.setdefault('lazy_imports', {})[id(self.shared_toc)] = shared_lazy_modules
+
+        logger.info("MERGE: collecting %d shared python module(s) into %s", len(self.shared_toc), shared_pyz_path)
+        self.shared_pyz = PYZ(self.shared_toc, name=shared_pyz_path)
+
     def _process_toc(self, toc, path_to_exe):
         # NOTE: unfortunately, these need to keep two separate lists. See the comment in the calling code on why this
         # is so.
@@ -1304,6 +1804,36 @@ def _process_toc(self, toc, path_to_exe):
 UNCOMPRESSED = False
 COMPRESSED = True
 
+# Alignment of uncompressed PKG entries' data, if enabled; corresponds to the most common filesystem block size.
+PKG_DATA_ALIGNMENT = 4096
+
+# Maximal fraction of the PKG data that may be taken by stale data blobs when the PKG is updated in-place (see the
+# `incremental` option of PKG); if exceeded, the PKG is compacted.
+PKG_INCREMENTAL_MAX_WASTE = 0.25
+
+# Default version of the PKG format. Version 2 can be read only by bootloaders built from sources that support it; the
+# default remains at version 1 until the prebuilt bootloaders are rebuilt.
+PKG_FORMAT_VERSION = 1
+
+# Chunk size for the digest of side-loaded PKG file.
+PKG_DIGEST_CHUNK_SIZE = 4 * 1024 * 1024
+
+
+def _compute_pkg_digest(filename, chunk_size):
+    """
+    Compute the chunked digest of the given file: the SHA-256 digest of concatenated SHA-256 digests of file's
+    consecutive chunks. In contrast to plain SHA-256 digest of the whole file, the chunks' digests can be computed
+    (and verified by the bootloader) in parallel. Returns the digest and the file length.
+    """
+    chunk_digests = hashlib.sha256()
+    file_length = 0
+    with open(filename, 'rb') as fp:
+        for chunk in iter(lambda: fp.read(chunk_size), b''):
+            chunk_digests.update(hashlib.sha256(chunk).digest())
+            file_length += len(chunk)
+    return chunk_digests.digest(), file_length
+
+
 _MISSING_BOOTLOADER_ERRORMSG = """Fatal error: PyInstaller does not include a pre-compiled bootloader for your
 platform. For more details and instructions how to build the bootloader see
 <https://pyinstaller.readthedocs.io/en/stable/bootloader-building.html>"""
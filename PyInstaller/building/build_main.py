@@ -14,6 +14,7 @@
 NOTE: All global variables, classes and imported modules create API for .spec files.
 """
 
+import fnmatch
 import glob
 import os
 import pathlib
@@ -30,6 +31,7 @@
     TOC, Target, Tree, _check_guts_eq, normalize_toc, normalize_pyz_toc, toc_process_symbolic_links
 )
 from PyInstaller.building.osx import BUNDLE
+from PyInstaller.building import scheduler
 from PyInstaller.building.splash import Splash
 from PyInstaller.building.utils import (
     _check_guts_toc, _check_guts_toc_mtime, _should_include_system_binary, format_binaries_and_datas, compile_pymodule,
@@ -82,6 +84,55 @@
 
 """
 
+LAZY_IMPORTS_REPORT_HEADER = """\
+
+This file lists the modules whose execution is deferred until their first
+attribute access at run-time (the `lazy_imports` option of Analysis), and
+the modules that match the `lazy_imports` patterns but are loaded eagerly,
+together with the reason.
+
+"""
+
+# The first line of the usage profile, written by the usage recorder in the frozen application's importer (which
+# defines the same constant in `pyimod02_importers`).
+USAGE_PROFILE_FILE_HEADER = '# PyInstaller usage profile, version 1'
+
+USAGE_PROFILE_REPORT_HEADER = """\
+
+This file lists the modules, data files, and extension modules that were not
+used in the recording run(s) of the frozen application, as determined by the
+`apply_usage_profile()` method of Analysis (mode: %(mode)s). In 'exclude'
+mode, these entries were removed from the bundle; in 'lazy' mode, the data
+files and extension modules are meant to be extracted on demand.
+
+"""
+
+# Modules and packages that are never loaded lazily, because they need to be executed at import time in order to work
+# as expected; for example, because they register codecs, import hooks, or monkey-patch other modules, or because they
+# are used by the lazy-loading machinery itself.
+_LAZY_IMPORTS_EXCLUDES = {
+    '__future__',
+    '_distutils_hack',
+    'codecs',
+    'encodings',
+    'eventlet',
+    'gevent',
+    'importlib',
+    'pkg_resources',
+    'site',
+    'sitecustomize',
+    'six',
+    'usercustomize',
+}
+
+
+def _matches_module_patterns(name, patterns):
+    """
+    Check whether the given module name matches any of the given module/package names (i.e., whether it is one of them,
+    or a submodule of one of them).
+    """
+    return any(name == pattern or name.startswith(pattern + '.') for pattern in patterns)
+
 
 @isolated.decorate
 def discover_hook_directories():
@@ -414,6 +465,8 @@ def __init__(
         noarchive=False,
         module_collection_mode=None,
         optimize=-1,
+        lazy_imports=None,
+        lazy_runtime_hooks=False,
         **_kwargs,
     ):
         """
@@ -450,6 +503,15 @@ def __init__(
         optimize
                 Optimization level for collected bytecode. If not specified or set to -1, it is set to the value of
                 `sys.flags.optimize` of the running build process.
+        lazy_imports
+                An optional list of module or package names whose execution should be deferred until the first
+                attribute access on the module object at run-time. Names prefixed with `!` exclude the matching
+                modules from deferred execution. Only modules collected into the PYZ archive can be deferred.
+        lazy_runtime_hooks
+                If True, the standard run-time hooks that apply to a specific module (e.g., `pkg_resources`,
+                `multiprocessing`, or the Qt bindings) are not executed at start-up, but when their trigger module is
+                imported for the first time. May also be a list of trigger module names, to defer only their hooks.
+                Custom run-time hooks are always executed at start-up.
         """
         if cipher is not None:
             from PyInstaller.exceptions import RemovedCipherFeatureError
@@ -514,6 +576,10 @@ def __init__(
         # that calls `build_main.main()` with custom `pyi_config` dictionary that contains `hiddenimports`.
         self.hiddenimports.extend(CONF.get('hiddenimports', []))
 
+        # The lazy loading of modules at run-time is implemented using `importlib.util.LazyLoader`.
+        if lazy_imports:
+            self.hiddenimports.append('importlib.util')
+
         for modnm in self.hiddenimports:
             if re.search(r"[\\/]", modnm):
                 raise SystemExit(
@@ -553,6 +619,10 @@ def __init__(
         self._python_version = sys.version
         self.noarchive = noarchive
         self.module_collection_mode = module_collection_mode or {}
+        self.lazy_imports = lazy_imports or []
+        self.lazy_runtime_hooks = lazy_runtime_hooks
+        if not isinstance(lazy_runtime_hooks, bool):
+            self.lazy_runtime_hooks = list(lazy_runtime_hooks or [])
         self.optimize = sys.flags.optimize if optimize in {-1, None} else optimize
 
         # Validate the optimization level to avoid errors later on...
@@ -581,6 +651,16 @@ def __init__(
 
         self.__postinit__()
 
+        # Associate the collected binaries with the `scripts` TOC list, which is passed to EXE in both onefile and
+        # onedir mode. This allows EXE to resolve its `readahead_binaries` option even in onedir mode, where the
+        # binaries are passed only to COLLECT.
+        CONF['collected_binaries'][id(self.scripts)] = self.binaries
+
+        # Resolve the modules with deferred execution. This is done regardless of whether the analysis was re-run or
+        # its results were loaded from the previous build, because the `lazy_imports` setting is not part of guts (it
+        # does not affect the analysis itself).
+        self._resolve_lazy_imports()
+
     _GUTS = (  # input parameters
         ('inputs', _check_guts_eq),  # parameter `scripts`
         ('pathex', _check_guts_eq),
@@ -592,6 +672,7 @@ def __init__(
         ('noarchive', _check_guts_eq),
         ('module_collection_mode', _check_guts_eq),
         ('optimize', _check_guts_eq),
+        ('lazy_runtime_hooks', _check_guts_eq),
 
         ('_input_binaries', _check_guts_toc),
         ('_input_datas', _check_guts_toc),
@@ -607,6 +688,125 @@ def __init__(
         # TODO: Need to add "dependencies"?
     )
 
+    def _split_deferred_runtime_hooks(self, rthook_toc):
+        """
+        Split the run-time hooks whose execution is deferred until the first import of their trigger module (based on
+        the `lazy_runtime_hooks` setting) from the given TOC list of run-time hooks. Returns the TOC list of hooks that
+        are executed at start-up, and the TOC list of deferred hooks, to be collected into the PYZ archive as modules.
+        The former is prepended with a generated script, which registers the deferred hooks with the importer.
+        """
+        from PyInstaller.config import CONF
+
+        if not self.lazy_runtime_hooks:
+            return rthook_toc, []
+        if self.noarchive:
+            logger.warning("lazy_runtime_hooks: run-time hooks cannot be deferred in noarchive mode!")
+            return rthook_toc, []
+
+        eager_toc = []
+        deferred_toc = []
+        triggers = {}  # trigger module name -> list of (hook module name, point of execution)
+        for name, src_path, typecode in rthook_toc:
+            trigger, when = self.graph.deferrable_rthooks.get(src_path, (None, None))
+            if trigger is None or (self.lazy_runtime_hooks is not True and trigger not in self.lazy_runtime_hooks):
+                eager_toc.append((name, src_path, typecode))
+                continue
+            logger.info("Deferring run-time hook %r until the first import of %r", name, trigger)
+            deferred_toc.append((name, src_path, 'PYMODULE'))
+            triggers.setdefault(trigger, []).append((name, when))
+
+        if not deferred_toc:
+            return rthook_toc, []
+
+        # The generated script is executed before all other run-time hooks (including the custom ones), so that the
+        # deferred hooks are run even if one of the other hooks imports their trigger module.
+        registrar_file = os.path.join(CONF['workpath'], 'pyi_rth__deferred_hooks.py')
+        with open(registrar_file, 'w', encoding='utf-8') as fp:
+            fp.write(
+                "# Generated by PyInstaller: registers the run-time hooks that are executed when their trigger module\n"
+                "# is imported for the first time.\n"
+                "def _pyi_rthook():\n"
+                "    import pyimod02_importers\n"
+                f"    pyimod02_importers.install_deferred_runtime_hooks({triggers!r})\n"
+                "\n"
+                "\n"
+                "_pyi_rthook()\n"
+                "del _pyi_rthook\n"
+            )
+
+        return [('pyi_rth__deferred_hooks', registrar_file, 'PYSOURCE')] + eager_toc, deferred_toc
+
+    def _resolve_lazy_imports(self):
+        """
+        Determine which of the modules collected into the PYZ archive should have their execution deferred (based on
+        the `lazy_imports` setting), associate the resulting set with the `pure` TOC list for the PYZ writer, and write
+        the lazy imports report.
+        """
+        from PyInstaller.config import CONF
+
+        if not self.lazy_imports:
+            return
+
+        includes = [name for name in self.lazy_imports if not name.startswith('!')]
+        excludes = [name[1:] for name in self.lazy_imports if name.startswith('!')]
+
+        deferred = []
+        eager = []  # (name, reason) tuples
+        matched_patterns = set()
+
+        for name, src_path, typecode in self.pure:
+            patterns = [pattern for pattern in includes if _matches_module_patterns(name, [pattern])]
+            if not patterns:
+                continue
+            matched_patterns.update(patterns)
+            if _matches_module_patterns(name, excludes):
+                eager.append((name, "excluded in the spec file"))
+            elif _matches_module_patterns(name, _LAZY_IMPORTS_EXCLUDES):
+                eager.append((name, "needs to be executed at import time"))
+            elif src_path in (None, '-'):
+                eager.append((name, "namespace package"))
+            else:
+                deferred.append(name)
+
+        # Extension modules are loaded by the fallback finder, and cannot be deferred.
+        for dest_name, src_name, typecode in self.binaries:
+            if typecode != 'EXTENSION':
+                continue
+            parts = pathlib.PurePath(dest_name).parts
+            if parts[0] == 'lib-dynload':
+                parts = parts[1:]
+            name = '.'.join(parts[:-1] + (parts[-1].split('.')[0],))
+            patterns = [pattern for pattern in includes if _matches_module_patterns(name, [pattern])]
+            if patterns:
+                matched_patterns.update(patterns)
+                eager.append((name, "extension module"))
+
+        for pattern in includes:
+            if pattern not in matched_patterns:
+                logger.warning(
+                    "lazy_imports: no collected module matches %r; note that only the modules collected into the PYZ "
+                    "archive can be deferred.", pattern
+                )
+
+        # Associate the set of deferred modules with the `pure` TOC list; this is used by the `PYZ` writer (similarly
+        # to the association of the code cache in `assemble()`).
+        CONF['lazy_imports'][id(self.pure)] = set(deferred)
+
+        report_file = os.path.join(CONF['workpath'], 'lazy-imports-%s-%02d.txt' % (CONF['specnm'], self.invcnum))
+        with open(report_file, 'w', encoding='utf-8') as fh:
+            fh.write(LAZY_IMPORTS_REPORT_HEADER)
+            fh.write("Deferred modules:\n")
+            for name in sorted(deferred):
+                fh.write(f"  {name}\n")
+            fh.write("\nEagerly-loaded modules:\n")
+            for name, reason in sorted(eager):
+                fh.write(f"  {name} ({reason})\n")
+
+        logger.info(
+            "Deferring execution of %d module(s); %d matching module(s) are loaded eagerly. Lazy imports report "
+            "written to %s", len(deferred), len(eager), report_file
+        )
+
     def _extend_pathex(self, spec_pathex, scripts):
         """
         Normalize additional paths where PyInstaller will look for modules and add paths with scripts to the list of
@@ -797,6 +997,10 @@ def assemble(self):
         # We do not optimize bytecode of run-time hooks.
         rthook_toc = self.graph.nodes_to_toc(rhtook_scripts)
 
+        # Split off the run-time hooks whose execution is deferred until the first import of their trigger module; these
+        # are collected into the PYZ archive (see below).
+        rthook_toc, deferred_rthooks_toc = self._split_deferred_runtime_hooks(rthook_toc)
+
         # Override the typecode of program script(s) to include bytecode optimization level.
         program_toc = self.graph.nodes_to_toc(program_scripts)
         optim_typecode = {0: 'PYSOURCE', 1: 'PYSOURCE-1', 2: 'PYSOURCE-2'}[self.optimize]
@@ -927,6 +1131,9 @@ def assemble(self):
 
                 self.datas.append((dest_path, obj_path, "DATA"))
 
+        # Collect the deferred run-time hooks as (non-optimized) modules.
+        self.pure += deferred_rthooks_toc
+
         # Construct base_library.zip, if applicable (the only scenario where it is not is if we are building with
         # noarchive mode). Always remove the file before the build.
         base_library_zip = os.path.join(CONF['workpath'], 'base_library.zip')
@@ -1111,6 +1318,123 @@ def exclude_system_libraries(self, list_of_exceptions=None):
             entry for entry in self.binaries if _should_include_system_binary(entry, list_of_exceptions or [])
         ]
 
+    def apply_usage_profile(self, profiles, keep=None, mode='exclude'):
+        """
+        This method may be optionally called from the spec file to slim down the bundle based on usage profile(s)
+        recorded by running the frozen application with the `PYINSTALLER_USAGE_PROFILE` environment variable set.
+
+        profiles
+                Path to the usage profile file, or a list of paths (the recorded usage is merged).
+        keep
+                An optional list of shell-style wildcards that are matched against module names (for modules collected
+                into the PYZ archive) and destination names of data files and extension modules; the matching entries
+                are always kept, regardless of the recorded usage.
+        mode
+                'exclude' (the default) removes the modules from the PYZ archive, and the data files and extension
+                modules that were not used during the recording run(s). 'lazy' keeps all entries; the returned list of
+                unused data files and extension modules is meant to be passed as `lazy_data` and `lazy_extensions`
+                arguments to the onefile `EXE`, so that they are extracted only if needed.
+
+        Shared libraries (other than extension modules) and the files that are used before the frozen importer is set
+        up are never excluded. Returns the sorted list of destination names of unused data files and extension modules.
+        """
+        from PyInstaller.config import CONF
+
+        if mode not in ('exclude', 'lazy'):
+            raise ValueError(f"Invalid usage profile mode: {mode!r}! Allowed values: 'exclude', 'lazy'.")
+        if isinstance(profiles, (str, os.PathLike)):
+            profiles = [profiles]
+        keep = keep or []
+
+        used_modules = set()
+        used_files = set()
+        spec_dir = os.path.dirname(CONF['spec'])
+        for profile_file in profiles:
+            profile_file = os.path.join(spec_dir, profile_file)  # Relative paths are relative to the .spec file.
+            try:
+                with open(profile_file, 'r', encoding='utf-8') as fp:
+                    lines = fp.read().splitlines()
+            except (OSError, ValueError) as e:
+                raise SystemExit(f"Error: failed to load usage profile {profile_file!r}: {e}")
+            if not lines or lines[0] != USAGE_PROFILE_FILE_HEADER:
+                raise SystemExit(f"Error: {profile_file!r} is not a usage profile, or its version is not supported!")
+            for line in lines[1:]:
+                kind, _, value = line.partition(' ')
+                if kind == 'module':
+                    used_modules.add(value)
+                elif kind == 'file':
+                    used_files.add(value)
+
+        def _is_kept(name):
+            return any(fnmatch.fnmatch(name, pattern) for pattern in keep)
+
+        # Importing a module implies importing its parent packages; those are recorded as well, but do not rely on it.
+        required_modules = set()
+        for name in used_modules:
+            parts = name.split('.')
+            required_modules.update('.'.join(parts[:idx]) for idx in range(1, len(parts) + 1))
+
+        unused_modules = [
+            name for name, src_path, typecode in self.pure if name not in required_modules and not _is_kept(name)
+        ]
+
+        # Files are recorded relative to the top-level application directory, using forward slashes. Files inside
+        # archives (for example, `base_library.zip`) are recorded as paths under the archive.
+        def _is_used_file(dest_name):
+            if dest_name in used_files:
+                return True
+            prefix = dest_name + '/'
+            return any(path.startswith(prefix) for path in used_files)
+
+        unused_files = []
+        for dest_name, src_name, typecode in self.datas:
+            dest_name = pathlib.PurePath(dest_name).as_posix()
+            if dest_name == 'base_library.zip' or _is_used_file(dest_name) or _is_kept(dest_name):
+                continue
+            unused_files.append(dest_name)
+        for dest_name, src_name, typecode in self.binaries:
+            if typecode != 'EXTENSION':
+                continue  # Shared libraries are loaded by the dynamic linker, and their usage cannot be recorded.
+            dest_name = pathlib.PurePath(dest_name).as_posix()
+            if _is_used_file(dest_name) or _is_kept(dest_name):
+                continue
+            unused_files.append(dest_name)
+        unused_files.sort()
+
+        # Write the report.
+        report_file = os.path.join(CONF['workpath'], 'usage-profile-%s-%02d.txt' % (CONF['specnm'], self.invcnum))
+        with open(report_file, 'w', encoding='utf-8') as fh:
+            fh.write(USAGE_PROFILE_REPORT_HEADER % {'mode': mode})
+            fh.write("Unused modules:\n")
+            for name in unused_modules:
+                fh.write(f"  {name}\n")
+            fh.write("\nUnused data files and extension modules:\n")
+            for name in unused_files:
+                fh.write(f"  {name}\n")
+
+        if mode == 'exclude':
+            # NOTE: modify the `pure` list in-place, to preserve its association with the code cache (see `assemble()`).
+            unused_modules = set(unused_modules)
+            self.pure[:] = [entry for entry in self.pure if entry[0] not in unused_modules]
+            unused_files_set = set(unused_files)
+            self.datas = [
+                entry for entry in self.datas if pathlib.PurePath(entry[0]).as_posix() not in unused_files_set
+            ]
+            self.binaries = [
+                entry for entry in self.binaries if pathlib.PurePath(entry[0]).as_posix() not in unused_files_set
+            ]
+            logger.info(
+                "Usage profile: excluded %d unused module(s) and %d unused data file(s) and extension module(s); "
+                "report written to %s", len(unused_modules), len(unused_files), report_file
+            )
+        else:
+            logger.info(
+                "Usage profile: found %d unused data file(s) and extension module(s) to be extracted on demand; report "
+                "written to %s", len(unused_files), report_file
+            )
+
+        return unused_files
+
 
 class ExecutableBuilder:
     """
@@ -1119,7 +1443,7 @@ class ExecutableBuilder:
     # TODO wrap the 'main' and 'build' function into this class.
 
 
-def build(spec, distpath, workpath, clean_build):
+def build(spec, distpath, workpath, clean_build, jobs=1):
     """
     Build the executable according to the created SPEC file.
     """
@@ -1150,6 +1474,8 @@ def build(spec, distpath, workpath, clean_build):
     CONF['xref-file'] = os.path.join(workpath, 'xref-%s.html' % CONF['specnm'])
 
     CONF['code_cache'] = dict()
+    CONF['lazy_imports'] = dict()
+    CONF['collected_binaries'] = dict()
 
     # Clean PyInstaller cache (CONF['cachedir']) and temporary files (workpath) to be able start a clean build.
     if clean_build:
@@ -1205,7 +1531,19 @@ def build(spec, distpath, workpath, clean_build):
             code = compile(f.read(), spec, 'exec')
     except FileNotFoundError:
         raise SystemExit(f'Spec file "{spec}" not found!')
-    exec(code, spec_namespace)
+
+    # With more than one job, the assembly of PYZ, PKG, EXE, COLLECT, BUNDLE, and Splash targets is deferred until the
+    # whole spec file has been executed, so that the independent targets can be assembled concurrently.
+    if jobs > 1:
+        target_scheduler = scheduler.TargetScheduler(jobs)
+        scheduler.active = target_scheduler
+        try:
+            exec(code, spec_namespace)
+        finally:
+            scheduler.active = None
+        target_scheduler.run()
+    else:
+        exec(code, spec_namespace)
 
     logger.info("Build complete! The results are available in: %s", CONF['distpath'])
 
@@ -1242,6 +1580,17 @@ def __add_options(parser):
         default=False,
         help="Clean PyInstaller cache and remove temporary files before building.",
     )
+    parser.add_argument(
+        '-j',
+        '--jobs',
+        type=int,
+        default=1,
+        metavar='N',
+        help="Assemble independent targets of the spec file (e.g., multiple executables, or PYZ and Splash) "
+        "concurrently using up to N worker processes. With N > 1, the targets are assembled after the whole spec file "
+        "has been executed, so the spec file must not access the output of a target (e.g., the built executable) "
+        "itself. Use 0 to use as many processes as there are CPUs (default: 1)",
+    )
 
 
 def main(
@@ -1267,4 +1616,8 @@ def main(
     CONF['ui_admin'] = kw.get('ui_admin', False)
     CONF['ui_access'] = kw.get('ui_uiaccess', False)
 
-    build(specfile, distpath, workpath, clean_build)
+    jobs = kw.get('jobs', 1)
+    if jobs == 0:
+        jobs = os.cpu_count() or 1
+
+    build(specfile, distpath, workpath, clean_build, jobs)
@@ -165,7 +165,24 @@ def __postinit__(self):
 
         `__postinit__` is to be called at the end of `__init__` of every subclass of Target. `__init__` is meant to
         setup the parameters and `__postinit__` is checking if rebuild is required and in case calls `assemble()`
+
+        If a target scheduler is active (i.e., the build runs with more than one job) and the target supports deferred
+        assembly, the target is registered with the scheduler, which performs the check and assembly after the .spec
+        file has been executed.
         """
+        from PyInstaller.building import scheduler
+
+        if self._deferrable and scheduler.active is not None:
+            scheduler.active.add(self)
+            return
+
+        self._check_and_assemble()
+
+    # Whether the assembly of the target can be deferred to (and run in a worker process by) the target scheduler.
+    # Requires that nothing in the .spec file depends on attributes set by `assemble()`.
+    _deferrable = False
+
+    def _check_and_assemble(self):
         logger.info("checking %s", self.__class__.__name__)
         data = None
         last_build = misc.mtime(self.tocfilename)
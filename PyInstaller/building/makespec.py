@@ -379,6 +379,15 @@ def __add_options(parser):
         'executed before any other code or module to set up special features of the runtime environment. This option '
         'can be used multiple times.',
     )
+    g.add_argument(
+        '--lazy-runtime-hooks',
+        dest='lazy_runtime_hooks',
+        action='store_true',
+        default=False,
+        help='Execute the standard runtime hooks that apply to a specific module (e.g., those for pkg_resources, '
+        'multiprocessing, matplotlib, or Qt bindings) when that module is imported for the first time, instead of at '
+        'start-up. Custom runtime hooks are always executed at start-up.',
+    )
     g.add_argument(
         '--exclude-module',
         dest='excludes',
@@ -387,6 +396,18 @@ def __add_options(parser):
         help='Optional module or package (the Python name, not the path name) that will be ignored (as though it was '
         'not found). This option can be used multiple times.',
     )
+    g.add_argument(
+        '--lazy-import',
+        dest='lazy_imports',
+        action='append',
+        default=[],
+        metavar='MODULENAME',
+        help='Module or package (the Python name) whose execution should be deferred until its first attribute '
+        'access at run-time. Prefix the name with "!" to exclude the module or package (e.g., a sub-package of a '
+        'deferred package) from deferred execution. Modules with import-time side effects (such as registration of '
+        'import hooks or codecs) and extension modules are always loaded eagerly; see the lazy imports report in the '
+        'build directory. This option can be used multiple times.',
+    )
     g.add_argument(
         '--key',
         dest='key',
@@ -688,6 +709,8 @@ def main(
     hookspath=[],
     runtime_hooks=[],
     excludes=[],
+    lazy_imports=[],
+    lazy_runtime_hooks=False,
     uac_admin=False,
     uac_uiaccess=False,
     collect_submodules=[],
@@ -867,6 +890,10 @@ def main(
         'runtime_hooks': runtime_hooks or [],
         # List of modules/packages to ignore.
         'excludes': excludes or [],
+        # List of modules/packages with deferred execution.
+        'lazy_imports': lazy_imports or [],
+        # Deferred execution of run-time hooks.
+        'lazy_runtime_hooks': lazy_runtime_hooks,
         # only Windows and macOS distinguish windowed and console apps
         'console': console,
         'disable_windowed_traceback': disable_windowed_traceback,
@@ -31,6 +31,8 @@
 
 
 class BUNDLE(Target):
+    _deferrable = True
+
     def __init__(self, *args, **kwargs):
         from PyInstaller.config import CONF
 
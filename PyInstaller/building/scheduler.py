@@ -0,0 +1,256 @@
+#-----------------------------------------------------------------------------
+# Copyright (c) 2023, PyInstaller Development Team.
+#
+# Distributed under the terms of the GNU General Public License (version 2
+# or later) with exception for distributing the bootloader.
+#
+# The full license is in the file COPYING.txt, distributed with this software.
+#
+# SPDX-License-Identifier: (GPL-2.0-or-later WITH Bootloader-exception)
+#-----------------------------------------------------------------------------
+"""
+Dependency-aware scheduling of target assembly.
+
+When the build is run with more than one job (see the ``--jobs`` option), the targets that support deferred assembly
+(PYZ, PKG, EXE, COLLECT, BUNDLE, Splash) do not assemble themselves at the end of their construction. Instead, they
+register with the active scheduler, which assembles them after the .spec file has been fully executed. Targets whose
+dependencies are satisfied are assembled concurrently, in separate worker processes.
+
+A target depends on a previously-registered target if it refers to that target directly (e.g., EXE and its PKG), or
+if its TOC contains an entry whose source path is the output (file or directory) of that target (e.g., the PYZ in the
+TOC of PKG, or the executable in the TOC of COLLECT).
+
+The log messages emitted during the assembly in a worker process are captured, and re-emitted by the main process,
+grouped per target and in the order in which the targets were declared in the .spec file, so that the build log (as
+well as the build output) is deterministic regardless of the order in which the assembly steps complete.
+"""
+
+import copyreg
+import io
+import logging as _logging
+import marshal
+import os
+import pickle
+import types
+
+from PyInstaller import log as logging
+
+logger = logging.getLogger(__name__)
+
+# The active scheduler; set by `build_main.build` for the duration of the .spec file execution (when running with
+# more than one job), and queried by `Target.__postinit__`.
+active = None
+
+
+def _reduce_code(code):
+    return marshal.loads, (marshal.dumps(code),)
+
+
+class _Pickler(pickle.Pickler):
+    """
+    Pickler that supports code objects (e.g., in the code dictionary of the PYZ target), by (un)marshalling them.
+    """
+    dispatch_table = copyreg.dispatch_table.copy()
+    dispatch_table[types.CodeType] = _reduce_code
+
+
+def _dumps(obj):
+    buf = io.BytesIO()
+    _Pickler(buf, protocol=pickle.HIGHEST_PROTOCOL).dump(obj)
+    return buf.getvalue()
+
+
+class _RecordCollector(_logging.Handler):
+    """
+    Logging handler that collects log records for transfer to the main process.
+    """
+    def __init__(self):
+        super().__init__()
+        self.records = []
+
+    def emit(self, record):
+        # Pre-format the message and the exception info, so that the record can be pickled.
+        record.msg = record.getMessage()
+        record.args = None
+        if record.exc_info:
+            record.exc_text = _logging.Formatter().formatException(record.exc_info)
+            record.exc_info = None
+        self.records.append(record)
+
+
+def _worker_init(conf_data, log_level):
+    from PyInstaller.config import CONF
+    CONF.update(pickle.loads(conf_data))
+
+    logging.getLogger('PyInstaller').setLevel(log_level)
+
+
+def _worker_assemble(target_data):
+    """
+    Assemble a target in a worker process. Returns the captured log records and the raised exception (if any).
+    """
+    root_logger = _logging.getLogger()
+    saved_handlers = root_logger.handlers[:]
+    collector = _RecordCollector()
+    root_logger.handlers = [collector]
+    try:
+        target = pickle.loads(target_data)
+        target._check_and_assemble()
+    except BaseException as e:
+        error = e
+    else:
+        error = None
+    finally:
+        root_logger.handlers = saved_handlers
+
+    # Ensure the exception can be transferred to the main process.
+    if error is not None:
+        try:
+            pickle.dumps(error)
+        except Exception:
+            error = RuntimeError(f"{type(error).__name__}: {error}")
+
+    return collector.records, error
+
+
+def _target_outputs(target):
+    outputs = []
+    for attr in ('name', 'pkgname'):
+        value = getattr(target, attr, None)
+        if isinstance(value, (str, os.PathLike)):
+            outputs.append(os.path.normcase(os.path.abspath(value)))
+    return outputs
+
+
+class TargetScheduler:
+    """
+    Collects the targets declared in the .spec file, and assembles them in dependency order using up to `jobs` worker
+    processes.
+    """
+    def __init__(self, jobs):
+        self.jobs = jobs
+        self.targets = []
+        self.dependencies = []
+
+    def add(self, target):
+        """
+        Register the target for deferred assembly and determine its dependencies among the already-registered targets.
+        """
+        from PyInstaller.building.datastruct import Target
+
+        # Targets referred to directly.
+        referenced = {id(value) for value in vars(target).values() if isinstance(value, Target)}
+
+        # Source paths in the TOC.
+        src_paths = set()
+        for entry in getattr(target, 'toc', None) or []:
+            if isinstance(entry, tuple) and len(entry) == 3 and isinstance(entry[1], str) and entry[1]:
+                src_paths.add(os.path.normcase(os.path.abspath(entry[1])))
+
+        dependencies = set()
+        for idx, other in enumerate(self.targets):
+            if id(other) in referenced:
+                dependencies.add(idx)
+                continue
+            for output in _target_outputs(other):
+                if output in src_paths or any(path.startswith(output + os.sep) for path in src_paths):
+                    dependencies.add(idx)
+                    break
+
+        self.targets.append(target)
+        self.dependencies.append(dependencies)
+
+    def _has_independent_targets(self):
+        # Determine the "depth" of each target in the dependency graph; if no two targets share the same depth, the
+        # targets form a chain and there is nothing to gain from concurrent assembly.
+        depths = []
+        for deps in self.dependencies:
+            depths.append(1 + max((depths[idx] for idx in deps), default=0))
+        return len(set(depths)) != len(depths)
+
+    def run(self):
+        """
+        Assemble all registered targets.
+        """
+        if not self.targets:
+            return
+
+        if self.jobs > 1 and self._has_independent_targets():
+            try:
+                payloads = self._prepare_payloads()
+            except Exception as e:
+                logger.debug("Cannot assemble targets in worker processes (%s); assembling them sequentially.", e)
+            else:
+                self._run_parallel(*payloads)
+                return
+
+        for target in self.targets:
+            target._check_and_assemble()
+
+    def _prepare_payloads(self):
+        from PyInstaller.config import CONF
+
+        # The code cache is consumed by PYZ at construction time, and is not needed by the assembly steps.
+        conf_data = _dumps({key: value for key, value in CONF.items() if key != 'code_cache'})
+        target_data = [_dumps(target) for target in self.targets]
+        return conf_data, target_data
+
+    def _run_parallel(self, conf_data, target_data):
+        import concurrent.futures
+
+        num_targets = len(self.targets)
+        max_workers = min(self.jobs, num_targets)
+        logger.info("Assembling %d targets using up to %d worker processes", num_targets, max_workers)
+
+        results = [None] * num_targets
+        submitted = set()
+        next_to_emit = 0
+        failed = False
+
+        with concurrent.futures.ProcessPoolExecutor(
+            max_workers=max_workers,
+            initializer=_worker_init,
+            initargs=(conf_data, logging.getLogger('PyInstaller').getEffectiveLevel()),
+        ) as executor:
+            futures = {}
+            while next_to_emit < num_targets:
+                # Submit all targets whose dependencies have been assembled.
+                if not failed:
+                    for idx in range(num_targets):
+                        if idx in submitted:
+                            continue
+                        if all(results[dep] is not None and results[dep][1] is None for dep in self.dependencies[idx]):
+                            futures[executor.submit(_worker_assemble, target_data[idx])] = idx
+                            submitted.add(idx)
+
+                if not futures:
+                    break  # Nothing left to wait for (after a failure).
+
+                done, _ = concurrent.futures.wait(futures, return_when=concurrent.futures.FIRST_COMPLETED)
+                for future in done:
+                    idx = futures.pop(future)
+                    results[idx] = future.result()
+                    if results[idx][1] is not None:
+                        failed = True
+
+                # Emit the logs of finished targets, in declaration order.
+                while next_to_emit < num_targets and results[next_to_emit] is not None:
+                    records, error = results[next_to_emit]
+                    for record in records:
+                        _logging.getLogger(record.name).handle(record)
+                    if error is not None:
+                        raise error
+                    next_to_emit += 1
+
+        # After a failure, the dependent targets are not submitted, and the loop stops once the pending targets are
+        # done; the failed target might come after them in declaration order, so its logs and error have not been
+        # emitted yet.
+        for records, error in (result for result in results[next_to_emit:] if result is not None):
+            for record in records:
+                _logging.getLogger(record.name).handle(record)
+            if error is not None:
+                raise error
+
+        unassembled = [self.targets[idx] for idx in range(num_targets) if results[idx] is None]
+        if unassembled:
+            raise RuntimeError(f"Targets were not assembled: {', '.join(map(repr, unassembled))}")
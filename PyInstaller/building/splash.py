@@ -55,6 +55,8 @@ class Splash(Target):
     A Splash has two outputs, one is itself and one is stored in splash.binaries. Both need to be passed to other
     build targets in order to enable the splash screen.
     """
+    _deferrable = True
+
     def __init__(self, image_file, binaries, datas, **kwargs):
         """
         :param str image_file:
@@ -86,6 +86,11 @@
 splash_canvas_setup = r"""
 package require Tk
 
+# Byte-based progress of the extraction in onefile mode, as a fraction
+# between 0.0 and 1.0. It is updated via C right before status_text, so
+# a trace on status_text can use it (e.g., to draw a progress bar).
+set status_progress 0.0
+
 set image_width [image width splash_image]
 set image_height [image height splash_image]
 set display_width [winfo screenwidth .]
@@ -25,6 +25,8 @@
     hooksconfig={},
     runtime_hooks=%(runtime_hooks)r,
     excludes=%(excludes)s,
+    lazy_imports=%(lazy_imports)s,
+    lazy_runtime_hooks=%(lazy_runtime_hooks)r,
     noarchive=%(noarchive)s,
     optimize=%(optimize)r,
 )
@@ -65,6 +67,8 @@
     hooksconfig={},
     runtime_hooks=%(runtime_hooks)r,
     excludes=%(excludes)s,
+    lazy_imports=%(lazy_imports)s,
+    lazy_runtime_hooks=%(lazy_runtime_hooks)r,
     noarchive=%(noarchive)s,
     optimize=%(optimize)r,
 )
@@ -63,6 +63,26 @@
 HOOK_PRIORITY_UPSTREAM_HOOKS = 0  # Hooks provided by packages themselves, via entry-points.
 HOOK_PRIORITY_USER_HOOKS = 1000  # User-supplied hooks (command-line / spec file). Highest priority.
 
+# Run-time hooks from PyInstaller's own registry whose execution can be deferred until their trigger module (the module
+# the hook is registered for) is imported for the first time; see the `lazy_runtime_hooks` option of Analysis. The value
+# denotes whether the hook needs to run before the trigger module is executed (hooks that only set up the environment
+# for the module), or after it (hooks that import and patch the module, or import its sub-modules; for example, the
+# Qt bindings hooks import the `QtCore` extension, which requires the package's `__init__` to be executed first). The
+# remaining hooks are global (e.g., they set up the environment for shared libraries or for the other packages), and
+# are always executed at start-up.
+DEFERRABLE_RTHOOKS = {
+    'pyi_rth_django.py': 'after',
+    'pyi_rth_inspect.py': 'after',
+    'pyi_rth_mplconfig.py': 'before',
+    'pyi_rth_multiprocessing.py': 'after',
+    'pyi_rth_pkgres.py': 'after',
+    'pyi_rth_pkgutil.py': 'after',
+    'pyi_rth_pyqt5.py': 'after',
+    'pyi_rth_pyqt6.py': 'after',
+    'pyi_rth_pyside2.py': 'after',
+    'pyi_rth_pyside6.py': 'after',
+}
+
 
 class PyiModuleGraph(ModuleGraph):
     """
@@ -700,9 +720,15 @@ def analyze_runtime_hooks(self, custom_runhooks):
         """
         Analyze custom run-time hooks and run-time hooks implied by found modules.
 
+        The run-time hooks that can be deferred until the first import of their trigger module (see
+        `DEFERRABLE_RTHOOKS`) are recorded in the `deferrable_rthooks` dictionary, which maps the hook's path onto the
+        tuple of trigger module name and the point of execution ('before' or 'after' the trigger module).
+
         :return : list of Graph nodes.
         """
         rthooks_nodes = []
+        self.deferrable_rthooks = {}
+        builtin_rthooks_dir = os.path.join(PACKAGEPATH, 'hooks', 'rthooks')
         logger.info('Analyzing run-time hooks ...')
         # Process custom runtime hooks (from --runtime-hook options). The runtime hooks are order dependent. First hooks
         # in the list are executed first. Put their graph nodes at the head of the priority_scripts list Pyinstaller
@@ -726,6 +752,8 @@ def analyze_runtime_hooks(self, custom_runhooks):
                     hook_path, hook_basename = os.path.split(abs_path)
                     logger.info("Including run-time hook %r from %r", hook_basename, hook_path)
                     rthooks_nodes.append(self.add_script(abs_path))
+                    if hook_basename in DEFERRABLE_RTHOOKS and hook_path == builtin_rthooks_dir:
+                        self.deferrable_rthooks[abs_path] = (mod_name, DEFERRABLE_RTHOOKS[hook_basename])
 
         return rthooks_nodes
 
@@ -17,6 +17,7 @@
 import os
 import struct
 import marshal
+import time
 import zlib
 
 # In Python3, the MAGIC_NUMBER value is available in the importlib module. However, in the bootstrap phase we cannot use
@@ -43,12 +44,34 @@ class ZlibArchiveReader:
     """
     _PYZ_MAGIC_PATTERN = b'PYZ\0'
 
+    # Separator of paths in the chain of PYZ archives, as passed by the bootloader via `sys._pyinstaller_pyz` (see
+    # the `shared_pyz` option of MERGE).
+    _CHAIN_SEPARATOR = '\0'
+
     def __init__(self, filename, start_offset=None, check_pymagic=False):
+        # The filename might be followed by the paths to the archives whose TOC should be chained after the TOC of this
+        # archive.
+        chained_filenames = []
+        if start_offset is None and self._CHAIN_SEPARATOR in filename:
+            filename, *chained_filenames = filename.split(self._CHAIN_SEPARATOR)
+
         self._filename = filename
         self._start_offset = start_offset
 
+        # Optional import profiler (see `pyimod02_importers._ImportProfiler`), which records the time spent reading,
+        # decompressing, and unmarshaling the entries.
+        self._profiler = None
+
         self.toc = {}
 
+        # Names of modules whose execution should be deferred until first attribute access (see the `lazy_imports`
+        # option of Analysis).
+        self.lazy_modules = frozenset()
+
+        # Entries from chained archives that are not shadowed by the entries of this archive; maps entry names to the
+        # chained archive readers.
+        self._chained_entries = {}
+
         # If no offset is given, try inferring it from filename
         if start_offset is None:
             self._filename, self._start_offset = self._parse_offset_from_filename(filename)
@@ -69,13 +92,33 @@ def __init__(self, filename, start_offset=None, check_pymagic=False):
             if check_pymagic and pymagic != PYTHON_MAGIC_NUMBER:
                 raise ArchiveReadError("Python magic pattern mismatch!")
 
-            # Read TOC offset
-            toc_offset, *_ = struct.unpack('!i', fp.read(4))
+            # Read TOC offset, and the offset of the list of modules with deferred execution (0 if not available).
+            toc_offset, lazy_modules_offset = struct.unpack('!ii', fp.read(8))
 
             # Load TOC
             fp.seek(self._start_offset + toc_offset, os.SEEK_SET)
             self.toc = dict(marshal.load(fp))
 
+            # Load the list of modules with deferred execution
+            if lazy_modules_offset:
+                fp.seek(self._start_offset + lazy_modules_offset, os.SEEK_SET)
+                self.lazy_modules = frozenset(marshal.load(fp))
+
+        for chained_filename in chained_filenames:
+            self.chain(ZlibArchiveReader(chained_filename, check_pymagic=check_pymagic))
+
+    def chain(self, archive):
+        """
+        Chain the TOC of the given archive reader after the TOC of this archive. The entries from the chained archive
+        become available through this reader, unless they are shadowed by the entries of this archive (or of the
+        previously chained archives).
+        """
+        for name, entry in archive.toc.items():
+            if name not in self.toc:
+                self.toc[name] = entry
+                self._chained_entries[name] = archive
+        self.lazy_modules = self.lazy_modules.union(archive.lazy_modules)
+
     @staticmethod
     def _parse_offset_from_filename(filename):
         """
@@ -103,12 +146,22 @@ def extract(self, name, raw=False):
         If the entry belongs to a module or a package, the data is loaded (unmarshaled) into code object. To retrieve
         raw data, set `raw` flag to True.
         """
+        # Entries from chained archives are read by the corresponding reader.
+        chained_archive = self._chained_entries.get(name)
+        if chained_archive is not None:
+            chained_archive._profiler = self._profiler
+            return chained_archive.extract(name, raw)
+
         # Look up entry
         entry = self.toc.get(name)
         if entry is None:
             return None
         typecode, entry_offset, entry_length = entry
 
+        profiler = self._profiler
+        if profiler is not None:
+            time_start = time.perf_counter_ns()
+
         # Read data blob
         try:
             with open(self._filename, "rb") as fp:
@@ -125,11 +178,25 @@ def extract(self, name, raw=False):
                 "Continouation from this state is impossible. Exiting now."
             )
 
+        if profiler is not None:
+            time_read = time.perf_counter_ns()
+
         try:
             obj = zlib.decompress(obj)
+            if profiler is not None:
+                time_decompress = time.perf_counter_ns()
             if typecode in (PYZ_ITEM_MODULE, PYZ_ITEM_PKG, PYZ_ITEM_NSPKG) and not raw:
                 obj = marshal.loads(obj)
         except EOFError as e:
             raise ImportError(f"Failed to unmarshal PYZ entry {name!r}!") from e
 
+        if profiler is not None:
+            time_end = time.perf_counter_ns()
+            profiler.record_extract(
+                name,
+                time_read - time_start,
+                time_decompress - time_read,
+                time_end - time_decompress,
+            )
+
         return obj
@@ -20,6 +20,7 @@
 import sys
 import os
 import io
+import time
 
 import _frozen_importlib
 import _thread
@@ -103,6 +104,228 @@ def get_pyz_toc_tree():
         _TOP_LEVEL_DIRECTORY_PATHS.append(_RESOLVED_ALTERNATIVE_TOP_LEVEL_DIRECTORY)
 
 
+# On-demand access to PKG archive entries in onefile builds (see `lazy_extensions` and `lazy_data` options of EXE). The
+# bootloader provides the path to the PKG archive, the indices of on-demand entries, and the function that extracts an
+# on-demand binary from the PKG archive. Initialized by install().
+#
+# The index of on-demand binaries maps the name of each deferred extension module onto the list of deferred shared
+# libraries it depends on. The index of on-demand data files maps their names onto tuples of (offset, length,
+# uncompressed length, compression flag).
+_archive_filename = None
+_archive_offset = 0
+_lazy_binaries = {}
+_lazy_extension_modules = {}  # Maps path of deferred extension module without the suffix onto its name in the index.
+_lazy_data = {}  # Maps case-normalized name of on-demand data file onto (name, *index entry).
+_lazy_entries_lock = _thread.RLock()
+_extract_lazy_binary = None
+
+# Original `open()` implementation; used by our override, which is installed if there are on-demand data files.
+_io_open = io.open
+
+
+def _setup_lazy_entries():
+    global _archive_filename, _archive_offset, _lazy_binaries, _extract_lazy_binary
+
+    archive_filename, _, archive_offset = sys._pyi_archive.rpartition('?')
+    _archive_filename = archive_filename
+    _archive_offset = int(archive_offset)
+    _extract_lazy_binary = sys._pyi_extract_lazy_binary
+    _lazy_binaries = getattr(sys, '_pyi_lazy_binaries', {})
+    lazy_data = getattr(sys, '_pyi_lazy_data', {})
+    for attr_name in ('_pyi_archive', '_pyi_extract_lazy_binary', '_pyi_lazy_binaries', '_pyi_lazy_data'):
+        if hasattr(sys, attr_name):
+            delattr(sys, attr_name)
+
+    import _imp  # built-in
+    extension_suffixes = _imp.extension_suffixes()
+    for entry_name in _lazy_binaries:
+        for suffix in extension_suffixes:
+            if entry_name.endswith(suffix):
+                _lazy_extension_modules[entry_name[:-len(suffix)]] = entry_name
+                break
+
+    for entry_name, index_entry in lazy_data.items():
+        _lazy_data[os.path.normcase(entry_name)] = (entry_name, *index_entry)
+
+    if _lazy_data:
+        import builtins
+        builtins.open = io.open = _open
+
+
+def _move_extracted_file(tmp_filename, filename):
+    """
+    Move the file that was extracted under a temporary name into its final location. Extracting into a temporary file
+    ensures that concurrent processes of the same application never observe a partially-written file.
+    """
+    try:
+        os.replace(tmp_filename, filename)
+    except OSError:
+        # On Windows, the replacement fails if the file has been extracted (and loaded) by another process meanwhile.
+        os.remove(tmp_filename)
+        if not os.path.exists(filename):
+            raise
+
+
+def _extract_lazy_binary_file(entry_name):
+    """
+    Extract the deferred binary into the top-level application directory, unless it already exists there (for example,
+    because it was already extracted by another process of the same application).
+    """
+    filename = os.path.join(sys._MEIPASS, entry_name)
+    if os.path.exists(filename):
+        return
+
+    trace(f"PyInstaller: extracting on-demand binary {entry_name!r}")
+    os.makedirs(os.path.dirname(filename), mode=0o700, exist_ok=True)
+    tmp_entry_name = f"{entry_name}.{os.getpid()}.tmp"
+    if _extract_lazy_binary(entry_name, tmp_entry_name) != 0:
+        raise ImportError(f"Failed to extract on-demand binary {entry_name!r} from the executable!")
+    _move_extracted_file(os.path.join(sys._MEIPASS, tmp_entry_name), filename)
+
+
+def _extract_lazy_extension_module(module_path):
+    """
+    If the given path (relative to the top-level application directory, and without the suffix) corresponds to
+    a deferred extension module, extract the module along with the deferred shared libraries it depends on. Returns
+    True if the module was extracted.
+    """
+    entry_name = _lazy_extension_modules.get(module_path)
+    if entry_name is None:
+        return False
+
+    with _lazy_entries_lock:
+        dependencies = _lazy_binaries.get(entry_name)
+        if dependencies is None:
+            return False  # Already extracted.
+        for dependency in dependencies:
+            _extract_lazy_binary_file(dependency)
+        _extract_lazy_binary_file(entry_name)
+        del _lazy_binaries[entry_name]
+
+    return True
+
+
+_PATH_SEPARATORS = (os.path.sep, os.path.altsep) if os.path.altsep else (os.path.sep,)
+
+
+def _get_top_level_relative_path(path):
+    """
+    Return the given absolute path relative to the top-level application directory, or None if it is not located under
+    the top-level application directory.
+    """
+    if not isinstance(path, str):
+        try:
+            path = os.fspath(path)
+        except TypeError:
+            return None
+        if not isinstance(path, str):
+            return None
+
+    for top_level_path in _TOP_LEVEL_DIRECTORY_PATHS:
+        if path.startswith(top_level_path) and path[len(top_level_path):len(top_level_path) + 1] in _PATH_SEPARATORS:
+            return os.path.normpath(path[len(top_level_path) + 1:])
+
+    return None
+
+
+def _get_lazy_data_entry(path):
+    """
+    Look up the on-demand data file that corresponds to the given path, and has not been extracted yet. Returns the
+    index entry, or None.
+    """
+    relative_path = _get_top_level_relative_path(path)
+    if relative_path is None:
+        return None
+    return _lazy_data.get(os.path.normcase(relative_path))
+
+
+def _list_lazy_data(directory):
+    """
+    Return the names of the on-demand data files (and the directories containing them) that have not been extracted
+    yet, and are located directly in the given directory (specified relative to the top-level application directory).
+    """
+    prefix = os.path.normcase(directory) + os.path.sep if directory not in ('', '.') else ''
+    names = set()
+    for key, (entry_name, *_) in list(_lazy_data.items()):
+        if key.startswith(prefix):
+            names.add(entry_name[len(prefix):].split(os.path.sep, 1)[0])
+    return names
+
+
+def _read_lazy_data(index_entry):
+    """
+    Read the contents of the on-demand data file directly from the PKG archive.
+    """
+    entry_name, offset, length, uncompressed_length, compression_flag = index_entry
+    with _io_open(_archive_filename, 'rb') as fp:
+        fp.seek(_archive_offset + offset, os.SEEK_SET)
+        data = fp.read(length)
+    if compression_flag:
+        import zlib
+        data = zlib.decompress(data)
+    return data
+
+
+def _extract_lazy_data_file(index_entry):
+    """
+    Extract the on-demand data file into the top-level application directory. After extraction, the file is accessed
+    from the filesystem.
+    """
+    entry_name = index_entry[0]
+    key = os.path.normcase(entry_name)
+    with _lazy_entries_lock:
+        if key not in _lazy_data:
+            return  # Already extracted.
+
+        filename = os.path.join(sys._MEIPASS, entry_name)
+        if not os.path.exists(filename):
+            trace(f"PyInstaller: extracting on-demand data file {entry_name!r}")
+            os.makedirs(os.path.dirname(filename), mode=0o700, exist_ok=True)
+            tmp_filename = f"{filename}.{os.getpid()}.tmp"
+            try:
+                with _io_open(tmp_filename, 'wb') as fp:
+                    fp.write(_read_lazy_data(index_entry))
+                _move_extracted_file(tmp_filename, filename)
+            except BaseException:
+                # Keep serving the file from the archive, and do not leave the partially-written file behind.
+                try:
+                    os.remove(tmp_filename)
+                except OSError:
+                    pass
+                raise
+
+        # Remove the entry only once the file is available on the filesystem.
+        del _lazy_data[key]
+
+
+class _LazyDataFile(io.BytesIO):
+    """
+    In-memory file object for on-demand data file that is opened for reading.
+    """
+    def __init__(self, data, name, mode):
+        super().__init__(data)
+        self.name = name
+        self.mode = mode
+
+
+def _open(file, mode='r', buffering=-1, encoding=None, errors=None, newline=None, closefd=True, opener=None):
+    """
+    Override for `open()` that serves the on-demand data files that have not been extracted yet. If opened for reading,
+    the file's contents are read directly from the PKG archive; otherwise, the file is extracted first.
+    """
+    if _lazy_data:
+        index_entry = _get_lazy_data_entry(file)
+        if index_entry is not None:
+            if opener is None and not set(mode) - {'r', 'b', 't'}:
+                fp = _LazyDataFile(_read_lazy_data(index_entry), file, mode)
+                if 'b' in mode:
+                    return fp
+                return io.TextIOWrapper(fp, encoding, errors, newline)
+            _extract_lazy_data_file(index_entry)
+
+    return _io_open(file, mode, buffering, encoding, errors, newline, closefd, opener)
+
+
 # Helper for computing PYZ prefix tree
 def _build_pyz_prefix_tree(pyz_archive):
     tree = dict()
@@ -176,8 +399,10 @@ def __init__(self, path):
 
         if relative_path == '.':
             self._pyz_entry_prefix = ''
+            self._relative_path_prefix = ''
         else:
             self._pyz_entry_prefix = '.'.join(relative_path.split(os.path.sep))
+            self._relative_path_prefix = relative_path + os.path.sep
 
     def _compute_pyz_entry_name(self, fullname):
         """
@@ -279,6 +504,12 @@ def find_spec(self, fullname, target=None):
             # resources, such as extension modules and modules that are collected only as source .py files.
             trace(f"{self}: find_spec: {fullname!r} not found in PYZ...")
 
+            # If the module is a deferred extension module, extract it now, so that the fallback finder can find it.
+            if _lazy_extension_modules:
+                module_path = self._relative_path_prefix + fullname.rpartition('.')[2]
+                if _extract_lazy_extension_module(module_path) and self.fallback_finder is not None:
+                    self.fallback_finder.invalidate_caches()
+
             if self.fallback_finder is not None:
                 trace(f"{self}: find_spec: attempting resolve using fallback finder {self.fallback_finder!r}.")
                 fallback_spec = self.fallback_finder.find_spec(fullname, target)
@@ -337,6 +568,14 @@ def find_spec(self, fullname, target=None):
         if is_package:
             spec.submodule_search_locations = [os.path.dirname(origin)]
 
+        # Defer the execution of the module until the first attribute access on the module object, if requested at
+        # build time (see the `lazy_imports` option of Analysis). The `importlib.util` module is collected into the
+        # PYZ archive whenever there are modules with deferred execution.
+        if pyz_entry_name in self._pyz_archive.lazy_modules:
+            trace(f"{self}: find_spec: deferring execution of {fullname!r} until first attribute access.")
+            import importlib.util
+            spec.loader = importlib.util.LazyLoader(loader)
+
         return spec
 
     # The following methods are part of legacy PEP302 finder interface. They have been deprecated since python 3.4,
@@ -541,6 +780,12 @@ def get_data(self, path):
 
         https://docs.python.org/3/library/importlib.html#importlib.abc.ResourceLoader.get_data
         """
+        # On-demand data files are read directly from the PKG archive.
+        if _lazy_data:
+            index_entry = _get_lazy_data_entry(path)
+            if index_entry is not None:
+                return _read_lazy_data(index_entry)
+
         # Try to fetch the data from the filesystem. Since __file__ attribute works properly, just try to open the file
         # and read it.
         with open(path, 'rb') as fp:
@@ -600,10 +845,17 @@ def resource_path(self, resource):
         return str(self.path.joinpath(resource))
 
     def is_resource(self, path):
-        return self.files().joinpath(path).is_file()
+        resource_path = self.files().joinpath(path)
+        return resource_path.is_file() or (bool(_lazy_data) and _get_lazy_data_entry(resource_path) is not None)
 
     def contents(self):
-        return (item.name for item in self.files().iterdir())
+        names = [item.name for item in self.files().iterdir()] if self.path.is_dir() else []
+        # Include on-demand data files that have not been extracted yet.
+        if _lazy_data:
+            relative_path = _get_top_level_relative_path(self.path)
+            if relative_path is not None:
+                names += sorted(_list_lazy_data(relative_path) - set(names))
+        return iter(names)
 
     def files(self):
         return self.path
@@ -625,6 +877,345 @@ def get_code(self, fullname):
         raise ImportError(f'{self} cannot handle module {fullname!r}')
 
 
+# Per-module import profiler, activated by the PYINSTALLER_IMPORT_PROFILE environment variable. Unlike python's
+# `-X importtime`, it separates the costs that are specific to PyInstaller's frozen importer (finding the module,
+# reading its entry from the PYZ archive, decompressing and unmarshaling it) from the execution of the module's code.
+class _ImportProfiler:
+    _FIELDS = ('find_spec', 'fallback_find_spec', 'read', 'decompress', 'unmarshal', 'exec', 'exec_self')
+
+    def __init__(self, output):
+        self._output = output
+        self._stats = {}
+        self._lock = _thread.allocate_lock()
+        # Stacks of nested `exec_module` calls (per thread), used to compute the self-time of module execution.
+        self._exec_stacks = {}
+
+    def _add(self, name, **times):
+        with self._lock:
+            stats = self._stats.get(name)
+            if stats is None:
+                stats = self._stats[name] = dict.fromkeys(self._FIELDS, 0)
+            for field, value in times.items():
+                stats[field] += value
+
+    def record_extract(self, name, time_read, time_decompress, time_unmarshal):
+        # Called by `ZlibArchiveReader.extract`; `name` is the PYZ entry name.
+        self._add(name, read=time_read, decompress=time_decompress, unmarshal=time_unmarshal)
+
+    def install(self, archive):
+        import atexit
+
+        archive._profiler = self
+        profiler = self
+
+        _orig_find_spec = PyiFrozenFinder.find_spec
+        _orig_exec_module = PyiFrozenLoader.exec_module
+
+        def _find_spec(self, fullname, target=None):
+            time_start = time.perf_counter_ns()
+            spec = _orig_find_spec(self, fullname, target)
+            elapsed = time.perf_counter_ns() - time_start
+            # Specs for modules in the PYZ archive are resolved from its TOC; anything else (including failed look-ups)
+            # involves the fallback finder and its filesystem probes.
+            if spec is not None and (spec.loader is None or isinstance(spec.loader, PyiFrozenLoader)):
+                profiler._add(fullname, find_spec=elapsed)
+            else:
+                profiler._add(fullname, fallback_find_spec=elapsed)
+            return spec
+
+        def _exec_module(self, module):
+            stack = profiler._exec_stacks.setdefault(_thread.get_ident(), [])
+            stack.append(0)  # Accumulated time of nested module executions
+            time_start = time.perf_counter_ns()
+            try:
+                _orig_exec_module(self, module)
+            finally:
+                elapsed = time.perf_counter_ns() - time_start
+                nested = stack.pop()
+                if stack:
+                    stack[-1] += elapsed
+                profiler._add(self.name, exec=elapsed, exec_self=elapsed - nested)
+
+        PyiFrozenFinder.find_spec = _find_spec
+        PyiFrozenLoader.exec_module = _exec_module
+
+        atexit.register(self.dump)
+
+    def dump(self):
+        with self._lock:
+            stats = {name: dict(values) for name, values in self._stats.items()}
+
+        def _total(values):
+            return sum(values[field] for field in self._FIELDS if field != 'exec')
+
+        if self._output.endswith('.json'):
+            import json
+            report = {
+                name: {field: value / 1e6 for field, value in values.items()}
+                for name, values in sorted(stats.items(), key=lambda item: _total(item[1]), reverse=True)
+            }
+            with open(self._output, 'w', encoding='utf-8') as fp:
+                json.dump({'unit': 'ms', 'modules': report}, fp, indent=1)
+            return
+
+        columns = ('total',) + self._FIELDS
+        lines = [
+            "PyInstaller import profile (times in milliseconds; exec is cumulative, exec_self excludes nested "
+            "imports):",
+            " ".join(f"{column:>18}" for column in columns) + "  module",
+        ]
+        totals = dict.fromkeys(self._FIELDS, 0)
+        for name, values in sorted(stats.items(), key=lambda item: _total(item[1]), reverse=True):
+            row = (_total(values),) + tuple(values[field] for field in self._FIELDS)
+            lines.append(" ".join(f"{value / 1e6:18.3f}" for value in row) + "  " + name)
+            for field in self._FIELDS:
+                totals[field] += values[field]
+        totals['exec'] = 0  # Cumulative times cannot be summed.
+        row = (_total(totals),) + tuple(totals[field] for field in self._FIELDS)
+        lines.append(" ".join(f"{value / 1e6:18.3f}" for value in row) + "  <total>")
+        report = "\n".join(lines) + "\n"
+
+        if self._output == '1':
+            if sys.stderr:
+                sys.stderr.write(report)
+        else:
+            with open(self._output, 'w', encoding='utf-8') as fp:
+                fp.write(report)
+
+
+def _setup_import_profiler(archive):
+    output = os.environ.get('PYINSTALLER_IMPORT_PROFILE', '')
+    if not output or output == '0':
+        return
+
+    # Allow each process (e.g., multiprocessing workers) to write its own report.
+    output = output.replace('{pid}', str(os.getpid()))
+
+    _ImportProfiler(output).install(archive)
+
+
+# The first line of the usage profile. This module cannot be imported at build time, so the same constant is defined
+# in `PyInstaller.building.build_main` for `Analysis.apply_usage_profile()`; a unit test keeps the two in sync.
+USAGE_PROFILE_FILE_HEADER = '# PyInstaller usage profile, version 1'
+
+
+class _UsageRecorder:
+    """
+    Usage recorder, activated by the `PYINSTALLER_USAGE_PROFILE` environment variable in applications that were built
+    with the `usage_recorder` option of EXE. Records the modules from the
+    PYZ archive that are imported, and the files under the top-level application directory that are used (extension
+    modules and other modules loaded from the filesystem, and files that are opened or read via the loader's
+    `get_data()`), and writes them into a usage profile at exit. If the profile file already exists, the recorded
+    entries are merged into it, so that the profile can accumulate the usage from multiple runs. The profile is
+    consumed at build time by `Analysis.apply_usage_profile()`.
+    """
+    def __init__(self, output):
+        self._output = output
+        self._lock = _thread.allocate_lock()
+        self._modules = set()
+        self._files = set()
+
+    def record_module(self, pyz_entry_name):
+        with self._lock:
+            self._modules.add(pyz_entry_name)
+
+    def record_file(self, path):
+        if isinstance(path, int):
+            return  # File descriptor
+        try:
+            path = os.path.abspath(path)
+        except (TypeError, ValueError):
+            return
+        relative_path = _get_top_level_relative_path(path)
+        if relative_path is not None:
+            with self._lock:
+                self._files.add(relative_path.replace(os.path.sep, '/'))
+
+    def _record_loaded_modules(self):
+        # NOTE: use `object.__getattribute__` to avoid triggering the execution of modules with deferred execution.
+        for module in list(sys.modules.values()):
+            try:
+                loader = getattr(object.__getattribute__(module, '__spec__'), 'loader', None)
+            except AttributeError:
+                loader = None
+            loader = getattr(loader, 'loader', loader)  # Unwrap `importlib.util.LazyLoader`.
+            if isinstance(loader, PyiFrozenLoader):
+                self.record_module(loader._pyz_entry_name)
+                continue
+            try:
+                module_file = object.__getattribute__(module, '__file__')
+            except AttributeError:
+                continue
+            if module_file:
+                self.record_file(module_file)
+
+    def install(self, archive):
+        import atexit
+        import builtins
+
+        recorder = self
+
+        _orig_find_spec = PyiFrozenFinder.find_spec
+        _orig_get_data = PyiFrozenLoader.get_data
+        _orig_open = io.open  # NOTE: might be our override for on-demand data files.
+
+        def _find_spec(self, fullname, target=None):
+            spec = _orig_find_spec(self, fullname, target)
+            if spec is not None:
+                pyz_entry_name = self._compute_pyz_entry_name(fullname)
+                if pyz_entry_name in self._pyz_archive.toc:
+                    recorder.record_module(pyz_entry_name)
+                elif spec.origin:
+                    recorder.record_file(spec.origin)
+            return spec
+
+        def _get_data(self, path):
+            recorder.record_file(path)
+            return _orig_get_data(self, path)
+
+        def _open(file, *args, **kwargs):
+            recorder.record_file(file)
+            return _orig_open(file, *args, **kwargs)
+
+        PyiFrozenFinder.find_spec = _find_spec
+        PyiFrozenLoader.get_data = _get_data
+        builtins.open = io.open = _open
+
+        # Extension modules (e.g., `zlib`) might have been loaded before our importer was set up.
+        self._record_loaded_modules()
+
+        atexit.register(self.dump)
+
+    def dump(self):
+        self._record_loaded_modules()
+        with self._lock:
+            entries = {('module', name) for name in self._modules}
+            entries.update(('file', path) for path in self._files)
+
+        # Merge with the existing profile. NOTE: the profile uses a simple line-based format, so that recording does
+        # not require `json` to be collected into the frozen application.
+        try:
+            with _io_open(self._output, 'r', encoding='utf-8') as fp:
+                lines = fp.read().splitlines()
+            if lines and lines[0] == USAGE_PROFILE_FILE_HEADER:
+                for line in lines[1:]:
+                    kind, _, value = line.partition(' ')
+                    if kind in ('module', 'file') and value:
+                        entries.add((kind, value))
+        except (OSError, ValueError):
+            pass
+
+        with _io_open(self._output, 'w', encoding='utf-8') as fp:
+            fp.write(USAGE_PROFILE_FILE_HEADER + '\n')
+            for kind, value in sorted(entries):
+                if '\n' not in value and '\r' not in value:
+                    fp.write(f"{kind} {value}\n")
+
+
+def _setup_usage_recorder(archive):
+    # The bootloader signals that the application was built with the `usage_recorder` option of EXE; without it, the
+    # environment variable is ignored, so that it cannot be used to make regular builds write files.
+    if not hasattr(sys, '_pyi_usage_recorder'):
+        return
+    delattr(sys, '_pyi_usage_recorder')
+
+    output = os.environ.get('PYINSTALLER_USAGE_PROFILE', '')
+    if not output:
+        return
+
+    # Allow each process (e.g., multiprocessing workers) to write its own profile.
+    output = output.replace('{pid}', str(os.getpid()))
+
+    _UsageRecorder(output).install(archive)
+
+
+# Run-time hooks whose execution is deferred until the first import of their trigger module (see the
+# `lazy_runtime_hooks` option of Analysis). The hooks are collected into the PYZ archive as modules, and registered by
+# a generated run-time hook script, which calls `install_deferred_runtime_hooks`.
+def _run_runtime_hooks(hooks, when=None):
+    for hook_name, hook_when in hooks:
+        if when is None or hook_when == when:
+            trace("PyInstaller: running deferred run-time hook %s", hook_name)
+            __import__(hook_name)
+
+
+class _DeferredRuntimeHooksLoader:
+    """
+    Wrapper for the loader of a trigger module, which runs the deferred run-time hooks before and after the execution
+    of the module. The original loader is restored on the module (and its spec) before the module is executed.
+    """
+    def __init__(self, loader, hooks):
+        self._loader = loader
+        self._hooks = hooks
+
+    def create_module(self, spec):
+        return self._loader.create_module(spec)
+
+    def exec_module(self, module):
+        module.__spec__.loader = self._loader
+        module.__loader__ = self._loader
+
+        _run_runtime_hooks(self._hooks, 'before')
+        self._loader.exec_module(module)
+        _run_runtime_hooks(self._hooks, 'after')
+
+
+class _DeferredRuntimeHooksFinder:
+    """
+    Meta-path finder that intercepts the first import of trigger modules. The module spec is obtained from the
+    subsequent finders in `sys.meta_path`, and its loader is wrapped with `_DeferredRuntimeHooksLoader`. Once all
+    trigger modules have been imported, the finder removes itself from `sys.meta_path`.
+    """
+    def __init__(self, hooks):
+        self._hooks = hooks
+
+    def find_spec(self, fullname, path=None, target=None):
+        hooks = self._hooks.pop(fullname, None)
+        if hooks is None:
+            return None
+
+        if not self._hooks:
+            try:
+                sys.meta_path.remove(self)
+            except ValueError:
+                pass
+
+        spec = None
+        for finder in sys.meta_path:
+            if finder is self or not hasattr(finder, 'find_spec'):
+                continue
+            spec = finder.find_spec(fullname, path, target)
+            if spec is not None:
+                break
+        if spec is None:
+            return None
+
+        if hasattr(spec.loader, 'exec_module'):
+            spec.loader = _DeferredRuntimeHooksLoader(spec.loader, hooks)
+        else:
+            # Namespace package or legacy loader; run the hooks right away.
+            _run_runtime_hooks(hooks)
+        return spec
+
+
+def install_deferred_runtime_hooks(hooks):
+    """
+    Register run-time hooks whose execution is deferred until the first import of their trigger module. The `hooks`
+    dictionary maps trigger module names onto lists of (hook module name, point of execution) tuples, where the point
+    of execution is either 'before' or 'after' the execution of the trigger module.
+    """
+    pending = {}
+    for trigger, trigger_hooks in hooks.items():
+        if trigger in sys.modules:
+            # Already imported during bootstrap; run the hooks right away.
+            _run_runtime_hooks(trigger_hooks)
+        else:
+            pending[trigger] = trigger_hooks
+
+    if pending:
+        sys.meta_path.insert(0, _DeferredRuntimeHooksFinder(pending))
+
+
 def install():
     """
     Install PyInstaller's frozen finders/loaders/importers into python's import machinery.
@@ -633,7 +1224,8 @@ def install():
     #
     # The bootloader should store the path to PYZ archive (the path to the PKG archive and the offset within it; for
     # executable-embedded archive, this is for example /path/executable_name?117568) into _pyinstaller_pyz
-    # attribute of the sys module.
+    # attribute of the sys module. For executables from a MERGE-d multi-package suite with shared PYZ archive, the path
+    # is followed by the path to the shared archive, whose TOC is chained by the reader.
     global pyz_archive
 
     if not hasattr(sys, '_pyinstaller_pyz'):
@@ -646,6 +1238,17 @@ def install():
 
     delattr(sys, '_pyinstaller_pyz')
 
+    # Set up import profiler, if requested.
+    _setup_import_profiler(pyz_archive)
+
+    # Set up on-demand access to archive entries, if the bootloader provided the corresponding indices.
+    if hasattr(sys, '_pyi_archive'):
+        _setup_lazy_entries()
+
+    # Set up usage recorder, if requested. Must be done after the set-up of on-demand entries, so that the recorder's
+    # `open()` override wraps the override for on-demand data files.
+    _setup_usage_recorder(pyz_archive)
+
     # On Windows, there is finder called `_frozen_importlib.WindowsRegistryFinder`, which looks for Python module
     # locations in Windows registry. The frozen application should not look for those, so remove this finder
     # from `sys.meta_path`.
@@ -15,11 +15,30 @@
  * Functions related to PyInstaller archive embedded in executable.
  */
 
+#if defined(__linux__)
+    #define _GNU_SOURCE  /* fallocate */
+#endif
+
 #include <stdio.h>
 #include <stddef.h>  /* ptrdiff_t */
 #include <stdlib.h>  /* malloc */
 #include <string.h>  /* strncmp, strcpy, strcat */
 #include <sys/stat.h>  /* fchmod */
+#include <fcntl.h>  /* open, fallocate */
+
+#ifdef _WIN32
+    #include <io.h>  /* _write, _close */
+    #define O_CLOEXEC _O_NOINHERIT
+#else
+    #include <errno.h>
+    #include <unistd.h>  /* write, close, lseek */
+#endif
+
+#if defined(__linux__)
+    #include <sys/ioctl.h>  /* ioctl */
+    #include <linux/fs.h>  /* FICLONERANGE */
+    #include <linux/falloc.h>  /* FALLOC_FL_KEEP_SIZE */
+#endif
 
 /* PyInstaller headers. */
 #include "zlib.h"
@@ -36,20 +55,150 @@
 const struct TOC_ENTRY *
 pyi_archive_next_toc_entry(const struct ARCHIVE *archive, const struct TOC_ENTRY *toc_entry)
 {
-    return (const struct TOC_ENTRY *)((const char *)toc_entry + toc_entry->entry_length);
+    return toc_entry + 1;
 }
 
+/*
+ * Return pointer to the array of (pointers to) TOC entries with the given
+ * typecode, in their original order, and store their number into count.
+ * Returns NULL (and sets count to 0) if there are no such entries.
+ */
+const struct TOC_ENTRY *const *
+pyi_archive_get_entries_by_typecode(const struct ARCHIVE *archive, char typecode, uint32_t *count)
+{
+    uint32_t low = 0;
+    uint32_t high = archive->section_count;
+
+    /* Binary search in the section table, which is sorted by typecode */
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        const struct TOC_SECTION *section = &archive->sections[mid];
+
+        if ((unsigned char)section->typecode == (unsigned char)typecode) {
+            *count = section->count;
+            return &archive->toc_index[section->index_start];
+        }
+        if ((unsigned char)section->typecode < (unsigned char)typecode) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    *count = 0;
+    return NULL;
+}
+
+
+/*
+ * Size of I/O buffers used during extraction. Large buffers reduce the
+ * number of read/write system calls for big shared libraries; the buffers
+ * are aligned to the file system block size, so that the writes (which are
+ * issued at buffer-sized offsets) cover whole blocks.
+ */
+#define ARCHIVE_EXTRACT_CHUNK_SIZE (1024 * 1024)
+
+/* Entries smaller than this are not preallocated; the extra system call
+ * would cost more than it saves. */
+#define ARCHIVE_PREALLOCATE_THRESHOLD (64 * 1024)
+
+/*
+ * Allocate/free an I/O buffer of ARCHIVE_EXTRACT_CHUNK_SIZE bytes, aligned
+ * to ARCHIVE_DATA_ALIGNMENT.
+ */
+static unsigned char *
+_pyi_archive_alloc_io_buffer(void)
+{
+#ifdef _WIN32
+    return (unsigned char *)_aligned_malloc(ARCHIVE_EXTRACT_CHUNK_SIZE, ARCHIVE_DATA_ALIGNMENT);
+#else
+    void *buffer = NULL;
+    if (posix_memalign(&buffer, ARCHIVE_DATA_ALIGNMENT, ARCHIVE_EXTRACT_CHUNK_SIZE) != 0) {
+        return NULL;
+    }
+    return (unsigned char *)buffer;
+#endif
+}
+
+static void
+_pyi_archive_free_io_buffer(unsigned char *buffer)
+{
+#ifdef _WIN32
+    _aligned_free(buffer);
+#else
+    free(buffer);
+#endif
+}
+
+/*
+ * Write the whole buffer into the file descriptor, retrying on partial
+ * writes and interrupted system calls. Returns 0 on success, -1 on error.
+ */
+static int
+_pyi_archive_write_fd(int fd, const unsigned char *buffer, size_t length)
+{
+    while (length > 0) {
+#ifdef _WIN32
+        int written = _write(fd, buffer, (unsigned int)length);
+#else
+        ssize_t written = write(fd, buffer, length);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+#endif
+        if (written <= 0) {
+            return -1;
+        }
+        buffer += written;
+        length -= (size_t)written;
+    }
+    return 0;
+}
+
+/* Flag indicating that an earlier attempt at preallocating space failed
+ * due to file system not supporting it; used to avoid repeating the
+ * futile call for each extracted entry. */
+static bool _pyi_archive_preallocate_unsupported = false;
+
+/*
+ * Inform the file system about the final size of the output file, so that
+ * it can allocate the space in as few extents as possible. On Linux, we
+ * use fallocate() with FALLOC_FL_KEEP_SIZE, which reserves the blocks
+ * without changing the file size (so a failed extraction does not leave
+ * behind a zero-padded file of full size). Elsewhere, posix_fallocate()
+ * is used, if available. Failure to preallocate is not an error.
+ */
+static void
+_pyi_archive_preallocate(int fd, uint64_t offset, uint64_t length)
+{
+    if (_pyi_archive_preallocate_unsupported || length < ARCHIVE_PREALLOCATE_THRESHOLD) {
+        return;
+    }
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+    if (fallocate(fd, FALLOC_FL_KEEP_SIZE, (off_t)offset, (off_t)length) < 0) {
+        PYI_DEBUG("LOADER: failed to preallocate space for extracted file (errno %d).\n", errno);
+        _pyi_archive_preallocate_unsupported = true;
+    }
+#elif defined(HAVE_POSIX_FALLOCATE)
+    if (posix_fallocate(fd, (off_t)offset, (off_t)length) != 0) {
+        _pyi_archive_preallocate_unsupported = true;
+    }
+#else
+    (void)fd;
+    (void)offset;
+    _pyi_archive_preallocate_unsupported = true;
+#endif
+}
 
 /*
  * Helper for pyi_archive_extract/pyi_archive_extract2fs that extracts a
  * compressed file from the archive, and writes it into the provided
- * file handle or data buffer. Exactly one of out_fp or out_ptr needs
- * to be valid.
+ * file descriptor or data buffer. Exactly one of out_fd (-1 if not used)
+ * or out_ptr needs to be valid.
  */
 static int
-_pyi_archive_extract_compressed(FILE *archive_fp, const struct TOC_ENTRY *toc_entry, FILE *out_fp, unsigned char *out_ptr)
+_pyi_archive_extract_compressed(FILE *archive_fp, const struct TOC_ENTRY *toc_entry, int out_fd, unsigned char *out_ptr)
 {
-    const size_t CHUNK_SIZE = 8192;
     unsigned char *buffer_in = NULL;
     unsigned char *buffer_out = NULL;
     uint64_t remaining_size;
@@ -68,23 +217,26 @@ _pyi_archive_extract_compressed(FILE *archive_fp, const struct TOC_ENTRY *toc_en
         return -1;
     }
 
-    /* Allocate I/O buffers */
-    buffer_in = (unsigned char *)malloc(CHUNK_SIZE);
+    /* Allocate I/O buffers; when extracting into data buffer, we inflate
+     * directly into it. */
+    buffer_in = _pyi_archive_alloc_io_buffer();
     if (buffer_in == NULL) {
         PYI_PERROR("malloc", "Failed to extract %s: failed to allocate temporary input buffer!\n", toc_entry->name);
         goto cleanup;
     }
-    buffer_out = (unsigned char *)malloc(CHUNK_SIZE);
-    if (buffer_out == NULL) {
-        PYI_PERROR("malloc", "Failed to extract %s: failed to allocate temporary output buffer!\n", toc_entry->name);
-        goto cleanup;
+    if (out_fd >= 0) {
+        buffer_out = _pyi_archive_alloc_io_buffer();
+        if (buffer_out == NULL) {
+            PYI_PERROR("malloc", "Failed to extract %s: failed to allocate temporary output buffer!\n", toc_entry->name);
+            goto cleanup;
+        }
     }
 
     /* Decompress until deflate stream ends or end of file is reached */
     remaining_size = toc_entry->length;
     do {
         /* Read chunk to input buffer */
-        size_t chunk_size = (CHUNK_SIZE < remaining_size) ? CHUNK_SIZE : (size_t)remaining_size;
+        size_t chunk_size = (ARCHIVE_EXTRACT_CHUNK_SIZE < remaining_size) ? ARCHIVE_EXTRACT_CHUNK_SIZE : (size_t)remaining_size;
         if (fread(buffer_in, 1, chunk_size, archive_fp) != chunk_size || ferror(archive_fp)) {
             rc = -1;
             goto cleanup;
@@ -94,10 +246,16 @@ _pyi_archive_extract_compressed(FILE *archive_fp, const struct TOC_ENTRY *toc_en
         /* Run inflate() on input until output buffer is not full. */
         zstream.avail_in = (uInt)chunk_size;
         zstream.next_in = buffer_in;
-        do {
-            size_t out_len;
-            zstream.avail_out = (uInt)CHUNK_SIZE;
-            zstream.next_out = buffer_out;
+        for (;;) {
+            if (buffer_out) {
+                zstream.avail_out = (uInt)ARCHIVE_EXTRACT_CHUNK_SIZE;
+                zstream.next_out = buffer_out;
+            } else {
+                /* Inflate directly into the remaining space of the data buffer */
+                uint64_t space = toc_entry->uncompressed_length - zstream.total_out;
+                zstream.avail_out = (uInt)((space < ARCHIVE_EXTRACT_CHUNK_SIZE) ? space : ARCHIVE_EXTRACT_CHUNK_SIZE);
+                zstream.next_out = out_ptr + zstream.total_out;
+            }
             rc = inflate(&zstream, Z_NO_FLUSH);
             switch (rc) {
                 case Z_NEED_DICT:
@@ -107,20 +265,30 @@ _pyi_archive_extract_compressed(FILE *archive_fp, const struct TOC_ENTRY *toc_en
                 case Z_STREAM_ERROR:
                     goto decompress_end;
             }
-            /* Copy the extracted data */
-            out_len = CHUNK_SIZE - zstream.avail_out;
-            if (out_fp) {
-                /* Write to output file */
-                if (fwrite(buffer_out, 1, out_len, out_fp) != out_len || ferror(out_fp)) {
+            /* Write the extracted data */
+            if (buffer_out) {
+                size_t out_len = ARCHIVE_EXTRACT_CHUNK_SIZE - zstream.avail_out;
+                if (_pyi_archive_write_fd(out_fd, buffer_out, out_len) < 0) {
                     rc = Z_ERRNO;
                     goto decompress_end;
                 }
-            } else if (out_ptr) {
-                /* Copy to output data buffer */
-                memcpy(out_ptr, buffer_out, out_len);
-                out_ptr += out_len;
             }
-        } while (zstream.avail_out == 0);
+            if (rc == Z_STREAM_END) {
+                break;
+            }
+            if (rc == Z_BUF_ERROR) {
+                /* No progress possible; if there is unconsumed input left,
+                 * the data does not fit into the data buffer. */
+                if (!buffer_out && zstream.avail_in > 0) {
+                    rc = Z_DATA_ERROR;
+                    goto decompress_end;
+                }
+                break;
+            }
+            if (zstream.avail_out != 0) {
+                break; /* Input chunk consumed */
+            }
+        }
         /* Done when inflate() says it's done */
     } while (rc != Z_STREAM_END && remaining_size > 0);
 
@@ -134,48 +302,133 @@ _pyi_archive_extract_compressed(FILE *archive_fp, const struct TOC_ENTRY *toc_en
 
 cleanup:
     inflateEnd(&zstream);
-    free(buffer_in);
-    free(buffer_out);
+    _pyi_archive_free_io_buffer(buffer_in);
+    _pyi_archive_free_io_buffer(buffer_out);
 
     return rc;
 }
 
+#if defined(__linux__) && defined(FICLONERANGE)
+
+/* Flag indicating that an earlier attempt at cloning data failed due to
+ * file system not supporting it; used to avoid repeating the futile
+ * ioctl() call for each extracted entry. */
+static bool _pyi_archive_reflink_unsupported = false;
+
+/*
+ * Helper for _pyi_archive_extract2fs_uncompressed that attempts to share
+ * data extents between the archive file and the output file, using the
+ * FICLONERANGE ioctl. This is supported only on copy-on-write file systems
+ * (e.g., btrfs, XFS with reflink support), and requires the source offset
+ * to be aligned to the file system block size; the entries are aligned
+ * at build time if `align_uncompressed` option is enabled.
+ *
+ * Only the block-aligned part of the data is cloned; the remaining tail
+ * needs to be copied by the caller. On success, both the archive file
+ * handle and the output file descriptor are positioned at the end of the
+ * cloned range.
+ *
+ * Returns the number of cloned bytes (0 if cloning was not possible).
+ */
+static uint64_t
+_pyi_archive_clone_uncompressed(FILE *archive_fp, const struct TOC_ENTRY *toc_entry, int out_fd)
+{
+    struct file_clone_range clone_range;
+    uint64_t data_offset;
+    uint64_t clone_length;
+
+    if (_pyi_archive_reflink_unsupported) {
+        return 0;
+    }
+
+    /* Source offset and cloned length must be block-aligned */
+    data_offset = (uint64_t)pyi_ftell(archive_fp);
+    if (data_offset % ARCHIVE_DATA_ALIGNMENT != 0) {
+        return 0;
+    }
+    clone_length = toc_entry->uncompressed_length - (toc_entry->uncompressed_length % ARCHIVE_DATA_ALIGNMENT);
+    if (clone_length == 0) {
+        return 0;
+    }
+
+    clone_range.src_fd = fileno(archive_fp);
+    clone_range.src_offset = data_offset;
+    clone_range.src_length = clone_length;
+    clone_range.dest_offset = 0;
+    if (ioctl(out_fd, FICLONERANGE, &clone_range) < 0) {
+        /* Not supported by (or across) the file system(s), or the file
+         * system block size is larger than our alignment. Fall back to
+         * copying, and do not try cloning again. */
+        PYI_DEBUG("LOADER: failed to clone data of %s (errno %d); falling back to copying.\n", toc_entry->name, errno);
+        _pyi_archive_reflink_unsupported = true;
+        return 0;
+    }
+
+    /* Move both file handles past the cloned range */
+    if (pyi_fseek(archive_fp, data_offset + clone_length, SEEK_SET) < 0 ||
+        lseek(out_fd, (off_t)clone_length, SEEK_SET) < 0) {
+        PYI_PERROR("fseek", "Failed to extract %s: failed to seek past cloned data!\n", toc_entry->name);
+        return (uint64_t)-1;
+    }
+
+    return clone_length;
+}
+
+#endif /* defined(__linux__) && defined(FICLONERANGE) */
+
 /*
  * Helper for pyi_archive_extract2fs that extracts an uncompressed file
- * from the archive into the provided file handle.
+ * from the archive into the provided file descriptor.
  */
 static int
-_pyi_archive_extract2fs_uncompressed(FILE *archive_fp, const struct TOC_ENTRY *toc_entry, FILE *out_fp)
+_pyi_archive_extract2fs_uncompressed(FILE *archive_fp, const struct TOC_ENTRY *toc_entry, int out_fd)
 {
-    const size_t CHUNK_SIZE = 8192;
     unsigned char *buffer;
     uint64_t remaining_size;
     int rc = 0;
 
+    remaining_size = toc_entry->uncompressed_length;
+
+#if defined(__linux__) && defined(FICLONERANGE)
+    /* Try to clone the (block-aligned part of) data first */
+    if (1) {
+        uint64_t cloned_size = _pyi_archive_clone_uncompressed(archive_fp, toc_entry, out_fd);
+        if (cloned_size == (uint64_t)-1) {
+            return -1;
+        }
+        remaining_size -= cloned_size;
+        if (remaining_size == 0) {
+            return 0;
+        }
+    }
+#endif
+
+    /* Preallocate space for the data that needs to be copied */
+    _pyi_archive_preallocate(out_fd, toc_entry->uncompressed_length - remaining_size, remaining_size);
+
     /* Allocate temporary buffer for a single chunk */
-    buffer = (unsigned char *)malloc(CHUNK_SIZE);
+    buffer = _pyi_archive_alloc_io_buffer();
     if (buffer == NULL) {
         PYI_PERROR("malloc", "Failed to extract %s: failed to allocate temporary buffer!\n", toc_entry->name);
         return -1;
     }
 
     /* ... and copy it, chunk by chunk */
-    remaining_size = toc_entry->uncompressed_length;
     while (remaining_size > 0) {
-        size_t chunk_size = (CHUNK_SIZE < remaining_size) ? CHUNK_SIZE : (size_t)remaining_size;
+        size_t chunk_size = (ARCHIVE_EXTRACT_CHUNK_SIZE < remaining_size) ? ARCHIVE_EXTRACT_CHUNK_SIZE : (size_t)remaining_size;
         if (fread(buffer, chunk_size, 1, archive_fp) < 1) {
             PYI_PERROR("fread", "Failed to extract %s: failed to read data chunk!\n", toc_entry->name);
             rc = -1;
             break;
         }
-        if (fwrite(buffer, chunk_size, 1, out_fp) < 1) {
-            PYI_PERROR("fwrite", "Failed to extract %s: failed to write data chunk!\n", toc_entry->name);
+        if (_pyi_archive_write_fd(out_fd, buffer, chunk_size) < 0) {
+            PYI_PERROR("write", "Failed to extract %s: failed to write data chunk!\n", toc_entry->name);
             rc = -1;
             break;
         }
         remaining_size -= chunk_size;
     }
-    free(buffer);
+    _pyi_archive_free_io_buffer(buffer);
     return rc;
 }
 
@@ -229,15 +482,19 @@ pyi_archive_extract(const struct ARCHIVE *archive, const struct TOC_ENTRY *toc_e
     }
 
     /* Allocate the data buffer */
-    data = (unsigned char *)malloc(toc_entry->uncompressed_length);
+    if (toc_entry->uncompressed_length > SIZE_MAX) {
+        PYI_ERROR("Failed to extract %s: entry is too large to be extracted into memory!\n", toc_entry->name);
+        goto cleanup;
+    }
+    data = (unsigned char *)malloc((size_t)toc_entry->uncompressed_length);
     if (data == NULL) {
-        PYI_PERROR("malloc", "Failed to extract %s: failed to allocate data buffer (%u bytes)!\n", toc_entry->name, toc_entry->uncompressed_length);
+        PYI_PERROR("malloc", "Failed to extract %s: failed to allocate data buffer (%" PRIu64 " bytes)!\n", toc_entry->name, toc_entry->uncompressed_length);
         goto cleanup;
     }
 
     /* Extract */
     if (toc_entry->compression_flag == 1) {
-        rc = _pyi_archive_extract_compressed(archive_fp, toc_entry, NULL, data);
+        rc = _pyi_archive_extract_compressed(archive_fp, toc_entry, -1, data);
     } else {
         rc = _pyi_archive_extract_uncompressed(archive_fp, toc_entry, data);
     }
@@ -283,7 +540,7 @@ int
 pyi_archive_extract2fs(const struct ARCHIVE *archive, const struct TOC_ENTRY *toc_entry, const char *output_filename)
 {
     FILE *archive_fp = NULL;
-    FILE *out_fp = NULL;
+    int out_fd = -1;
     int rc = 0;
 
     /* Handle symbolic links */
@@ -295,10 +552,25 @@ pyi_archive_extract2fs(const struct ARCHIVE *archive, const struct TOC_ENTRY *to
         return rc;
     }
 
+    /* Aliases share the data blob with an earlier entry; extract that
+     * entry's data (and apply its permissions) under the alias' name. */
+    if (toc_entry->typecode == ARCHIVE_ITEM_ALIAS) {
+        const struct TOC_ENTRY *alias_entry = toc_entry;
+        toc_entry = pyi_archive_resolve_alias(archive, alias_entry);
+        if (toc_entry == NULL) {
+            PYI_ERROR("Failed to extract %s: could not resolve aliased entry!\n", alias_entry->name);
+            return -1;
+        }
+    }
+
     /* Open target file */
-    out_fp = pyi_path_fopen(output_filename, "wb");
-    if (out_fp == NULL) {
-        PYI_PERROR("fopen", "Failed to extract %s: failed to open target file!\n", toc_entry->name);
+#ifdef _WIN32
+    out_fd = pyi_path_open(output_filename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, _S_IREAD | _S_IWRITE);
+#else
+    out_fd = pyi_path_open(output_filename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+#endif
+    if (out_fd < 0) {
+        PYI_PERROR("open", "Failed to extract %s: failed to open target file!\n", toc_entry->name);
         return -1;
     }
 
@@ -318,15 +590,16 @@ pyi_archive_extract2fs(const struct ARCHIVE *archive, const struct TOC_ENTRY *to
 
     /* Extract */
     if (toc_entry->compression_flag == 1) {
-        rc = _pyi_archive_extract_compressed(archive_fp, toc_entry, out_fp, NULL);
+        _pyi_archive_preallocate(out_fd, 0, toc_entry->uncompressed_length);
+        rc = _pyi_archive_extract_compressed(archive_fp, toc_entry, out_fd, NULL);
     } else {
-        rc = _pyi_archive_extract2fs_uncompressed(archive_fp, toc_entry, out_fp);
+        rc = _pyi_archive_extract2fs_uncompressed(archive_fp, toc_entry, out_fd);
     }
 #ifndef WIN32
-    if (toc_entry->typecode == ARCHIVE_ITEM_BINARY) {
-        fchmod(fileno(out_fp), S_IRUSR | S_IWUSR | S_IXUSR);
+    if (toc_entry->typecode == ARCHIVE_ITEM_BINARY || toc_entry->typecode == ARCHIVE_ITEM_LAZY_BINARY) {
+        fchmod(out_fd, S_IRUSR | S_IWUSR | S_IXUSR);
     } else {
-        fchmod(fileno(out_fp), S_IRUSR | S_IWUSR);
+        fchmod(out_fd, S_IRUSR | S_IWUSR);
     }
 #endif
 
@@ -335,7 +608,15 @@ pyi_archive_extract2fs(const struct ARCHIVE *archive, const struct TOC_ENTRY *to
     if (archive_fp) {
         fclose(archive_fp);
     }
-    fclose(out_fp);
+#ifdef _WIN32
+    _close(out_fd);
+#else
+    if (close(out_fd) < 0 && rc == 0) {
+        /* Delayed write errors (e.g., out of space on NFS) are reported by close() */
+        PYI_PERROR("close", "Failed to extract %s: failed to close target file!\n", toc_entry->name);
+        rc = -1;
+    }
+#endif
 
     return rc;
 }
@@ -370,7 +651,10 @@ _pyi_archive_is_extractable(char typecode)
         case ARCHIVE_ITEM_BINARY:
         case ARCHIVE_ITEM_DATA:
         case ARCHIVE_ITEM_ZIPFILE:
-        case ARCHIVE_ITEM_SYMLINK: {
+        case ARCHIVE_ITEM_SYMLINK:
+        case ARCHIVE_ITEM_ALIAS:
+        case ARCHIVE_ITEM_LAZY_BINARY:
+        case ARCHIVE_ITEM_LAZY_DATA: {
             return true;
         }
         /* MERGE mode */
@@ -385,6 +669,293 @@ _pyi_archive_is_extractable(char typecode)
     return false;
 }
 
+/*
+ * Load TOC in format version 1 from the given buffer, which is
+ * retained by the archive structure (entry names point into it).
+ */
+static int
+_pyi_archive_load_toc_v1(struct ARCHIVE *archive, char *toc_data, uint64_t toc_length)
+{
+    struct TOC_ENTRY_V1 *raw_entry;
+    const char *toc_data_end = toc_data + toc_length;
+    struct TOC_ENTRY *toc_entry;
+    uint32_t entry_count = 0;
+
+    /* First pass: fix up the endianness of the entry length fields,
+     * validate them, and count the entries. */
+    raw_entry = (struct TOC_ENTRY_V1 *)toc_data;
+    while ((const char *)raw_entry < toc_data_end) {
+        raw_entry->entry_length = pyi_be32toh(raw_entry->entry_length);
+        if (raw_entry->entry_length <= offsetof(struct TOC_ENTRY_V1, name) || raw_entry->entry_length > (uint64_t)(toc_data_end - (const char *)raw_entry)) {
+            PYI_ERROR("Invalid TOC entry length!\n");
+            return -1;
+        }
+        entry_count++;
+        raw_entry = (struct TOC_ENTRY_V1 *)((char *)raw_entry + raw_entry->entry_length);
+    }
+
+    archive->toc = (struct TOC_ENTRY *)calloc(entry_count ? entry_count : 1, sizeof(struct TOC_ENTRY));
+    if (archive->toc == NULL) {
+        PYI_PERROR("calloc", "Could not allocate buffer for TOC!\n");
+        return -1;
+    }
+    archive->toc_end = archive->toc + entry_count;
+
+    /* Second pass: convert the entries */
+    raw_entry = (struct TOC_ENTRY_V1 *)toc_data;
+    for (toc_entry = archive->toc; toc_entry < archive->toc_end; toc_entry++) {
+        toc_entry->offset = pyi_be32toh(raw_entry->offset);
+        toc_entry->length = pyi_be32toh(raw_entry->length);
+        toc_entry->uncompressed_length = pyi_be32toh(raw_entry->uncompressed_length);
+        toc_entry->compression_flag = raw_entry->compression_flag;
+        toc_entry->typecode = raw_entry->typecode;
+        toc_entry->name = raw_entry->name;
+
+        /* Ensure that name is NULL-terminated */
+        ((char *)raw_entry)[raw_entry->entry_length - 1] = '\0';
+
+        raw_entry = (struct TOC_ENTRY_V1 *)((char *)raw_entry + raw_entry->entry_length);
+    }
+
+    return 0;
+}
+
+/*
+ * Load TOC in format version 2 from the given buffer, which is
+ * retained by the archive structure (entry names point into it).
+ */
+static int
+_pyi_archive_load_toc_v2(struct ARCHIVE *archive, char *toc_data, uint64_t toc_length, uint32_t entry_count, uint32_t section_count)
+{
+    const struct TOC_ENTRY_V2 *raw_entries;
+    const struct TOC_SECTION *raw_sections;
+    const uint32_t *raw_index;
+    const char *string_pool;
+    uint64_t string_pool_length;
+    uint64_t header_length;
+    uint32_t i;
+
+    /* Validate the layout: entries, section table, and entry index,
+     * followed by a non-empty, NULL-terminated string pool. */
+    header_length = (uint64_t)entry_count * sizeof(struct TOC_ENTRY_V2) + (uint64_t)section_count * sizeof(struct TOC_SECTION) + (uint64_t)entry_count * sizeof(uint32_t);
+    if (header_length >= toc_length || toc_data[toc_length - 1] != '\0') {
+        PYI_ERROR("Invalid TOC layout!\n");
+        return -1;
+    }
+
+    raw_entries = (const struct TOC_ENTRY_V2 *)toc_data;
+    raw_sections = (const struct TOC_SECTION *)(raw_entries + entry_count);
+    raw_index = (const uint32_t *)(raw_sections + section_count);
+    string_pool = (const char *)(raw_index + entry_count);
+    string_pool_length = toc_length - header_length;
+
+    /* Convert the entries */
+    archive->toc = (struct TOC_ENTRY *)calloc(entry_count ? entry_count : 1, sizeof(struct TOC_ENTRY));
+    if (archive->toc == NULL) {
+        PYI_PERROR("calloc", "Could not allocate buffer for TOC!\n");
+        return -1;
+    }
+    archive->toc_end = archive->toc + entry_count;
+
+    for (i = 0; i < entry_count; i++) {
+        struct TOC_ENTRY *toc_entry = &archive->toc[i];
+        uint32_t name_offset = pyi_be32toh(raw_entries[i].name_offset);
+
+        if (name_offset >= string_pool_length) {
+            PYI_ERROR("Invalid TOC entry name offset!\n");
+            return -1;
+        }
+
+        toc_entry->offset = pyi_be64toh(raw_entries[i].offset);
+        toc_entry->length = pyi_be64toh(raw_entries[i].length);
+        toc_entry->uncompressed_length = pyi_be64toh(raw_entries[i].uncompressed_length);
+        toc_entry->digest = pyi_be32toh(raw_entries[i].digest);
+        toc_entry->compression_flag = raw_entries[i].compression_flag;
+        toc_entry->typecode = raw_entries[i].typecode;
+        toc_entry->name = string_pool + name_offset;
+    }
+
+    /* Load the section table and the entry index */
+    archive->sections = (struct TOC_SECTION *)calloc(section_count ? section_count : 1, sizeof(struct TOC_SECTION));
+    archive->toc_index = (const struct TOC_ENTRY **)calloc(entry_count ? entry_count : 1, sizeof(struct TOC_ENTRY *));
+    if (archive->sections == NULL || archive->toc_index == NULL) {
+        PYI_PERROR("calloc", "Could not allocate buffer for TOC index!\n");
+        return -1;
+    }
+    archive->section_count = section_count;
+
+    for (i = 0; i < section_count; i++) {
+        struct TOC_SECTION *section = &archive->sections[i];
+
+        section->typecode = raw_sections[i].typecode;
+        section->index_start = pyi_be32toh(raw_sections[i].index_start);
+        section->count = pyi_be32toh(raw_sections[i].count);
+
+        if (section->index_start > entry_count || section->count > entry_count - section->index_start) {
+            PYI_ERROR("Invalid TOC section!\n");
+            return -1;
+        }
+        if (i > 0 && (unsigned char)section->typecode <= (unsigned char)archive->sections[i - 1].typecode) {
+            PYI_ERROR("TOC section table is not sorted!\n");
+            return -1;
+        }
+    }
+
+    for (i = 0; i < entry_count; i++) {
+        uint32_t entry_idx = pyi_be32toh(raw_index[i]);
+
+        if (entry_idx >= entry_count) {
+            PYI_ERROR("Invalid TOC index entry!\n");
+            return -1;
+        }
+        archive->toc_index[i] = &archive->toc[entry_idx];
+    }
+
+    return 0;
+}
+
+/*
+ * Build the section table and the entry index for TOC that was loaded
+ * from archive in format version 1, which does not store them. Performs
+ * a stable counting sort of entries by typecode.
+ */
+static int
+_pyi_archive_build_toc_index(struct ARCHIVE *archive)
+{
+    uint32_t counts[256];
+    uint32_t positions[256];
+    uint32_t entry_count = (uint32_t)(archive->toc_end - archive->toc);
+    const struct TOC_ENTRY *toc_entry;
+    uint32_t section_count = 0;
+    uint32_t position = 0;
+    int typecode;
+
+    memset(counts, 0, sizeof(counts));
+    for (toc_entry = archive->toc; toc_entry < archive->toc_end; toc_entry++) {
+        if (counts[(unsigned char)toc_entry->typecode]++ == 0) {
+            section_count++;
+        }
+    }
+
+    archive->sections = (struct TOC_SECTION *)calloc(section_count ? section_count : 1, sizeof(struct TOC_SECTION));
+    archive->toc_index = (const struct TOC_ENTRY **)calloc(entry_count ? entry_count : 1, sizeof(struct TOC_ENTRY *));
+    if (archive->sections == NULL || archive->toc_index == NULL) {
+        PYI_PERROR("calloc", "Could not allocate buffer for TOC index!\n");
+        return -1;
+    }
+
+    for (typecode = 0; typecode < 256; typecode++) {
+        positions[typecode] = position;
+        if (counts[typecode] == 0) {
+            continue;
+        }
+        archive->sections[archive->section_count].typecode = (char)typecode;
+        archive->sections[archive->section_count].index_start = position;
+        archive->sections[archive->section_count].count = counts[typecode];
+        archive->section_count++;
+        position += counts[typecode];
+    }
+
+    for (toc_entry = archive->toc; toc_entry < archive->toc_end; toc_entry++) {
+        archive->toc_index[positions[(unsigned char)toc_entry->typecode]++] = toc_entry;
+    }
+
+    return 0;
+}
+
+/* Order the (pointers to) TOC entries by data offset and length; ties
+ * are ordered by entry position. */
+static int
+_pyi_archive_compare_data_blobs(const void *a, const void *b)
+{
+    const struct TOC_ENTRY *entry_a = *(const struct TOC_ENTRY *const *)a;
+    const struct TOC_ENTRY *entry_b = *(const struct TOC_ENTRY *const *)b;
+
+    if (entry_a->offset != entry_b->offset) {
+        return entry_a->offset < entry_b->offset ? -1 : 1;
+    }
+    if (entry_a->length != entry_b->length) {
+        return entry_a->length < entry_b->length ? -1 : 1;
+    }
+    if (entry_a != entry_b) {
+        return entry_a < entry_b ? -1 : 1;
+    }
+    return 0;
+}
+
+/*
+ * Resolve alias entries into the (earlier) entries that own the shared
+ * data blobs. Since non-empty data blobs are never shared between
+ * regular entries, the owner is identified by matching data offset and
+ * length; the candidate owners are sorted by these, so that each alias
+ * is resolved using binary search instead of a scan of the whole TOC.
+ */
+static int
+_pyi_archive_resolve_aliases(struct ARCHIVE *archive)
+{
+    static const char owner_typecodes[] = { ARCHIVE_ITEM_BINARY, ARCHIVE_ITEM_DATA, ARCHIVE_ITEM_ZIPFILE };
+    const struct TOC_ENTRY *const *alias_entries;
+    const struct TOC_ENTRY **owner_entries;
+    uint32_t num_aliases;
+    uint32_t num_owners = 0;
+    uint32_t i;
+
+    alias_entries = pyi_archive_get_entries_by_typecode(archive, ARCHIVE_ITEM_ALIAS, &num_aliases);
+    if (num_aliases == 0) {
+        return 0;
+    }
+
+    owner_entries = (const struct TOC_ENTRY **)calloc(archive->toc_end - archive->toc, sizeof(struct TOC_ENTRY *));
+    if (owner_entries == NULL) {
+        PYI_PERROR("calloc", "Could not allocate buffer for alias resolution!\n");
+        return -1;
+    }
+
+    for (i = 0; i < sizeof(owner_typecodes); i++) {
+        const struct TOC_ENTRY *const *entries;
+        uint32_t count;
+
+        entries = pyi_archive_get_entries_by_typecode(archive, owner_typecodes[i], &count);
+        if (count > 0) {
+            memcpy(owner_entries + num_owners, entries, count * sizeof(struct TOC_ENTRY *));
+            num_owners += count;
+        }
+    }
+    qsort(owner_entries, num_owners, sizeof(struct TOC_ENTRY *), _pyi_archive_compare_data_blobs);
+
+    for (i = 0; i < num_aliases; i++) {
+        struct TOC_ENTRY *alias_entry = &archive->toc[alias_entries[i] - archive->toc];
+        uint32_t low = 0;
+        uint32_t high = num_owners;
+
+        /* Find the first candidate whose data offset and length are not
+         * lower than those of the alias. */
+        while (low < high) {
+            uint32_t mid = low + (high - low) / 2;
+            const struct TOC_ENTRY *owner_entry = owner_entries[mid];
+
+            if (owner_entry->offset < alias_entry->offset || (owner_entry->offset == alias_entry->offset && owner_entry->length < alias_entry->length)) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+
+        /* Candidates with the same data blob are ordered by their position,
+         * so the first one is the owner, if it precedes the alias. */
+        if (low < num_owners) {
+            const struct TOC_ENTRY *owner_entry = owner_entries[low];
+
+            if (owner_entry->offset == alias_entry->offset && owner_entry->length == alias_entry->length && owner_entry < alias_entry) {
+                alias_entry->alias_owner = owner_entry;
+            }
+        }
+    }
+
+    free(owner_entries);
+    return 0;
+}
+
 /*
  * Open the archive.
  */
@@ -393,9 +964,17 @@ pyi_archive_open(const char *filename)
 {
     FILE *archive_fp = NULL;
     uint64_t cookie_pos = 0;
-    struct ARCHIVE_COOKIE archive_cookie;
+    union {
+        struct ARCHIVE_COOKIE_V1 v1;
+        struct ARCHIVE_COOKIE_V2 v2;
+    } archive_cookie;
     struct ARCHIVE *archive = NULL;
-    struct TOC_ENTRY *toc_entry;
+    const struct TOC_ENTRY *toc_entry;
+    uint64_t cookie_length;
+    uint64_t pkg_length;
+    uint64_t toc_offset;
+    uint64_t toc_length;
+    int rc = -1;
 
     PYI_DEBUG("LOADER: attempting to open archive %s\n", filename);
 
@@ -414,12 +993,25 @@ pyi_archive_open(const char *filename)
     }
     PYI_DEBUG("LOADER: cookie found at offset 0x%" PRIX64 "\n", cookie_pos);
 
-    /* Read the cookie */
+    /* Read the cookie; read the common part first, which allows us to
+     * determine the archive format version. */
     if (pyi_fseek(archive_fp, cookie_pos, SEEK_SET) < 0) {
         PYI_PERROR("fseek", "Failed to seek to cookie position!\n");
         goto cleanup;
     }
-    if (fread(&archive_cookie, sizeof(struct ARCHIVE_COOKIE), 1, archive_fp) < 1) {
+    if (fread(&archive_cookie, offsetof(struct ARCHIVE_COOKIE_V2, pkg_length), 1, archive_fp) < 1) {
+        PYI_PERROR("fread", "Failed to read cookie!\n");
+        goto cleanup;
+    }
+    if (archive_cookie.v2.v1_marker != 0) {
+        cookie_length = sizeof(struct ARCHIVE_COOKIE_V1);
+    } else if (pyi_be32toh(archive_cookie.v2.format_version) == 2) {
+        cookie_length = sizeof(struct ARCHIVE_COOKIE_V2);
+    } else {
+        PYI_ERROR("Unsupported archive format version: %u!\n", pyi_be32toh(archive_cookie.v2.format_version));
+        goto cleanup;
+    }
+    if (fread((char *)&archive_cookie + offsetof(struct ARCHIVE_COOKIE_V2, pkg_length), cookie_length - offsetof(struct ARCHIVE_COOKIE_V2, pkg_length), 1, archive_fp) < 1) {
         PYI_PERROR("fread", "Failed to read cookie!\n");
         goto cleanup;
     }
@@ -435,34 +1027,46 @@ pyi_archive_open(const char *filename)
      * bootloader, the string is guaranteed to be within PYI_PATH_MAX limit */
     snprintf(archive->filename, PYI_PATH_MAX, "%s", filename);
 
-    /* Fix endianness of cookie fields */
-    archive_cookie.pkg_length = pyi_be32toh(archive_cookie.pkg_length);
-    archive_cookie.toc_offset = pyi_be32toh(archive_cookie.toc_offset);
-    archive_cookie.toc_length = pyi_be32toh(archive_cookie.toc_length);
-    archive_cookie.python_version = pyi_be32toh(archive_cookie.python_version);
-
-    /* Copy python version and python shared library name from cookie */
-    archive->python_version = archive_cookie.python_version;
-    snprintf(archive->python_libname, 64, "%s", archive_cookie.python_libname);
+    /* Fix endianness of cookie fields, and copy python version and python
+     * shared library name from cookie */
+    if (cookie_length == sizeof(struct ARCHIVE_COOKIE_V1)) {
+        archive->format_version = 1;
+        pkg_length = pyi_be32toh(archive_cookie.v1.pkg_length);
+        toc_offset = pyi_be32toh(archive_cookie.v1.toc_offset);
+        toc_length = pyi_be32toh(archive_cookie.v1.toc_length);
+        archive->python_version = pyi_be32toh(archive_cookie.v1.python_version);
+        snprintf(archive->python_libname, 64, "%.*s", 63, archive_cookie.v1.python_libname);
+    } else {
+        archive->format_version = 2;
+        pkg_length = pyi_be64toh(archive_cookie.v2.pkg_length);
+        toc_offset = pyi_be64toh(archive_cookie.v2.toc_offset);
+        toc_length = pyi_be64toh(archive_cookie.v2.toc_length);
+        archive->python_version = pyi_be32toh(archive_cookie.v2.python_version);
+        snprintf(archive->python_libname, 64, "%.*s", 63, archive_cookie.v2.python_libname);
+    }
+    PYI_DEBUG("LOADER: archive format version: %d\n", archive->format_version);
 
     /* From the cookie position and declared archive size, calculate
      * the archive start position */
-    archive->pkg_offset = cookie_pos + sizeof(struct ARCHIVE_COOKIE) - archive_cookie.pkg_length;
+    if (pkg_length > cookie_pos + cookie_length || toc_offset + toc_length > pkg_length || toc_length > SIZE_MAX) {
+        PYI_ERROR("Invalid archive cookie!\n");
+        goto cleanup;
+    }
+    archive->pkg_offset = cookie_pos + cookie_length - pkg_length;
 
     /* Read the table of contents (TOC) */
-    pyi_fseek(archive_fp, archive->pkg_offset + archive_cookie.toc_offset, SEEK_SET);
-    archive->toc = (struct TOC_ENTRY *)malloc(archive_cookie.toc_length);
+    pyi_fseek(archive_fp, archive->pkg_offset + toc_offset, SEEK_SET);
+    archive->toc_data = (char *)malloc(toc_length ? (size_t)toc_length : 1);
 
-    if (archive->toc == NULL) {
+    if (archive->toc_data == NULL) {
         PYI_PERROR("malloc", "Could not allocate buffer for TOC!\n");
         goto cleanup;
     }
 
-    if (fread(archive->toc, archive_cookie.toc_length, 1, archive_fp) < 1) {
+    if (toc_length && fread(archive->toc_data, (size_t)toc_length, 1, archive_fp) < 1) {
         PYI_PERROR("fread", "Could not read full TOC!\n");
         goto cleanup;
     }
-    archive->toc_end = (const struct TOC_ENTRY *)(((const char *)archive->toc) + archive_cookie.toc_length);
 
     /* Check input file is still ok (should be). */
     if (ferror(archive_fp)) {
@@ -470,32 +1074,46 @@ pyi_archive_open(const char *filename)
         goto cleanup;
     }
 
-    /* Fix the endianness of the fields in the TOC entries. At the same
-     * time, check for extractable entries that imply onefile semantics. */
-    toc_entry = archive->toc;
-    while (toc_entry < archive->toc_end) {
-        /* Fixup the current TOC entry */
-        toc_entry->entry_length = pyi_be32toh(toc_entry->entry_length);
-        toc_entry->offset = pyi_be32toh(toc_entry->offset);
-        toc_entry->length = pyi_be32toh(toc_entry->length);
-        toc_entry->uncompressed_length = pyi_be32toh(toc_entry->uncompressed_length);
+    /* Convert TOC into in-memory representation */
+    if (archive->format_version == 1) {
+        rc = _pyi_archive_load_toc_v1(archive, archive->toc_data, toc_length);
+        if (rc == 0) {
+            rc = _pyi_archive_build_toc_index(archive);
+        }
+    } else {
+        archive->has_digests = true;
+        rc = _pyi_archive_load_toc_v2(
+            archive,
+            archive->toc_data,
+            toc_length,
+            pyi_be32toh(archive_cookie.v2.entry_count),
+            pyi_be32toh(archive_cookie.v2.section_count)
+        );
+    }
+    if (rc == 0) {
+        rc = _pyi_archive_resolve_aliases(archive);
+    }
+    if (rc < 0) {
+        goto cleanup;
+    }
 
-        /* Check if entry is extractable */
+    /* Check for extractable entries that imply onefile semantics, and
+     * for SPLASH entry. */
+    for (toc_entry = archive->toc; toc_entry < archive->toc_end; toc_entry++) {
         archive->contains_extractable_entries |= _pyi_archive_is_extractable(toc_entry->typecode);
 
-        /* Check if this is SPLASH entry */
         if (toc_entry->typecode == ARCHIVE_ITEM_SPLASH) {
             archive->toc_splash = toc_entry;
         }
-
-        /* Jump to next entry; with the current entry fixed up, we can
-         * use non-const equivalent of pyi_archive_next_toc_entry() */
-        toc_entry = (struct TOC_ENTRY *)((const char *)toc_entry + toc_entry->entry_length);
     }
 
 cleanup:
     fclose(archive_fp);
 
+    if (rc < 0) {
+        pyi_archive_free(&archive);
+    }
+
     return archive;
 }
 
@@ -516,8 +1134,11 @@ pyi_archive_free(struct ARCHIVE **archive_ref)
         return;
     }
 
-    /* Free the TOC buffer */
+    /* Free the TOC buffers */
     free(archive->toc);
+    free(archive->toc_index);
+    free(archive->sections);
+    free(archive->toc_data);
 
     /* Free the structure itself */
     free(archive);
@@ -554,3 +1175,16 @@ pyi_archive_find_entry_by_name(const struct ARCHIVE *archive, const char *name)
 
     return NULL;
 }
+
+
+/*
+ * Resolve an alias entry into the (earlier) entry that owns the shared
+ * data blob. The owners are resolved when the archive is opened (see
+ * _pyi_archive_resolve_aliases).
+ */
+const struct TOC_ENTRY *
+pyi_archive_resolve_alias(const struct ARCHIVE *archive, const struct TOC_ENTRY *toc_entry)
+{
+    (void)archive;
+    return toc_entry->alias_owner;
+}
@@ -34,9 +34,20 @@
 #define ARCHIVE_ITEM_RUNTIME_OPTION   'o'  /* runtime option */
 #define ARCHIVE_ITEM_SPLASH           'l'  /* splash resources */
 #define ARCHIVE_ITEM_SYMLINK          'n'  /* symbolic link */
-
-/* Entry in PKG/CArchive TOC */
-struct TOC_ENTRY
+#define ARCHIVE_ITEM_ALIAS            'h'  /* alias of an extractable entry with identical data */
+#define ARCHIVE_ITEM_LAZY_BINARY      'e'  /* binary that is extracted on demand */
+#define ARCHIVE_ITEM_LAZY_DATA        'r'  /* data file that is read from the archive or extracted on demand */
+#define ARCHIVE_ITEM_LAZY_INDEX       'i'  /* index of on-demand entries */
+#define ARCHIVE_ITEM_SHARED_PYZ       'y'  /* reference to PYZ archive shared by multiple executables (MERGE) */
+
+/* Alignment of uncompressed entries' data in archives built with
+ * `align_uncompressed` option; corresponds to common file system block
+ * size. Must match PKG_DATA_ALIGNMENT in PyInstaller/building/api.py. */
+#define ARCHIVE_DATA_ALIGNMENT 4096
+
+/* Entry in PKG/CArchive TOC, as stored in archive format version 1.
+ * The entries are of variable length, and must be walked sequentially. */
+struct TOC_ENTRY_V1
 {
     uint32_t entry_length; /* length of this TOC entry, including full length of the name field */
     uint32_t offset; /* position of entry's data blob, relative to the start of PKG archive */
@@ -47,8 +58,8 @@ struct TOC_ENTRY
     char name[1];  /* entry name; padded to multiple of 16 */
 };
 
-/* The PKG/CArchive cookie, from the end of the archive. */
-struct ARCHIVE_COOKIE
+/* The PKG/CArchive cookie (format version 1), from the end of the archive. */
+struct ARCHIVE_COOKIE_V1
 {
     char magic[8]; /* 'MEI\014\013\012\013\016' */
     uint32_t pkg_length; /* length of the entire PKG archive */
@@ -58,6 +69,70 @@ struct ARCHIVE_COOKIE
     char python_libname[64]; /* Name of the of Python shared library (e.g., "python3.10.dll"). */
 };
 
+/* Entry in PKG/CArchive TOC, as stored in archive format version 2.
+ * The entries are of fixed size, and names are stored in a separate
+ * string pool, which allows random access to entries. */
+struct TOC_ENTRY_V2
+{
+    uint64_t offset; /* position of entry's data blob, relative to the start of PKG archive */
+    uint64_t length; /* length of compressed data blob */
+    uint64_t uncompressed_length; /* length of uncompressed data blob */
+    uint32_t name_offset; /* position of NULL-terminated entry name in the string pool */
+    uint32_t digest; /* CRC-32 of uncompressed data */
+    unsigned char compression_flag; /* compression flag (1 = compressed, 0 = uncompressed) */
+    char typecode; /* type code - see ARCHIVE_ITEM_* definitions */
+    char reserved[6];
+};
+
+/* Section of TOC entries with the same typecode (format version 2). The
+ * section table is sorted by typecode, and each section refers to a
+ * contiguous range of the entry index, which lists the entries (in their
+ * original order) grouped by typecode. */
+struct TOC_SECTION
+{
+    char typecode; /* type code - see ARCHIVE_ITEM_* definitions */
+    char reserved[3];
+    uint32_t index_start; /* position of section's first entry in the entry index */
+    uint32_t count; /* number of entries in the section */
+};
+
+/* The PKG/CArchive cookie (format version 2), from the end of the archive.
+ *
+ * The TOC consists of the array of entries, followed by the section table,
+ * the entry index (array of uint32_t entry positions), and the string pool.
+ *
+ * The magic pattern is the same as in format version 1; the field after it
+ * (which corresponds to non-zero `pkg_length` in format version 1) is
+ * always zero, and is followed by the format version. */
+struct ARCHIVE_COOKIE_V2
+{
+    char magic[8]; /* 'MEI\014\013\012\013\016' */
+    uint32_t v1_marker; /* always 0 */
+    uint32_t format_version; /* 2 */
+    uint64_t pkg_length; /* length of the entire PKG archive */
+    uint64_t toc_offset; /* position of TOC relative to start of PKG archive */
+    uint64_t toc_length; /* length of TOC data, including string pool */
+    uint32_t entry_count; /* number of TOC entries */
+    uint32_t section_count; /* number of sections in the section table */
+    uint32_t python_version; /* integer representing python version */
+    uint32_t reserved;
+    char python_libname[64]; /* Name of the of Python shared library (e.g., "python3.10.dll"). */
+};
+
+/* Entry in PKG/CArchive TOC, as loaded into memory; regardless of the
+ * format version, the TOC is loaded into array of these structures. */
+struct TOC_ENTRY
+{
+    uint64_t offset; /* position of entry's data blob, relative to the start of PKG archive */
+    uint64_t length; /* length of compressed data blob */
+    uint64_t uncompressed_length; /* length of uncompressed data blob */
+    uint32_t digest; /* CRC-32 of uncompressed data; valid only if archive's has_digests flag is set */
+    unsigned char compression_flag; /* compression flag (1 = compressed, 0 = uncompressed) */
+    char typecode; /* type code - see ARCHIVE_ITEM_* definitions */
+    const char *name; /* entry name; points into the archive's TOC data buffer */
+    const struct TOC_ENTRY *alias_owner; /* for alias entries: the entry that owns the data blob; resolved when archive is opened */
+};
+
 /* The archive structure */
 struct ARCHIVE
 {
@@ -66,8 +141,25 @@ struct ARCHIVE
 
     uint64_t pkg_offset; /* Offset of the PKG archive in the file */
 
-    struct TOC_ENTRY *toc; /* Buffer containing all TOC entries */
-    const struct TOC_ENTRY *toc_end; /* The address at which the TOC buffer ends */
+    /* Format version of the archive (1 or 2) */
+    int format_version;
+
+    /* Flag indicating that TOC entries carry digests of their data
+     * (format version 2 and later) */
+    bool has_digests;
+
+    struct TOC_ENTRY *toc; /* Array of all TOC entries */
+    const struct TOC_ENTRY *toc_end; /* The address at which the TOC array ends */
+
+    /* TOC entries grouped by typecode (preserving their order within
+     * each group), and the corresponding section table sorted by
+     * typecode. */
+    const struct TOC_ENTRY **toc_index;
+    struct TOC_SECTION *sections;
+    uint32_t section_count;
+
+    /* Buffer with raw TOC data, which holds entry names */
+    char *toc_data;
 
     /* Flag indicating that the archive contains extractable files,
      * and thus has onefile semantics */
@@ -89,10 +181,12 @@ struct ARCHIVE *pyi_archive_open(const char *filename);
 void pyi_archive_free(struct ARCHIVE **archive_ref);
 
 const struct TOC_ENTRY *pyi_archive_next_toc_entry(const struct ARCHIVE *archive, const struct TOC_ENTRY *toc_entry);
+const struct TOC_ENTRY *const *pyi_archive_get_entries_by_typecode(const struct ARCHIVE *archive, char typecode, uint32_t *count);
 
 unsigned char *pyi_archive_extract(const struct ARCHIVE *archive, const struct TOC_ENTRY *toc_entry);
 int pyi_archive_extract2fs(const struct ARCHIVE *archive, const struct TOC_ENTRY *toc_entry, const char *output_filename);
 
 const struct TOC_ENTRY *pyi_archive_find_entry_by_name(const struct ARCHIVE *archive, const char *name);
+const struct TOC_ENTRY *pyi_archive_resolve_alias(const struct ARCHIVE *archive, const struct TOC_ENTRY *toc_entry);
 
 #endif /* PYI_ARCHIVE_H */
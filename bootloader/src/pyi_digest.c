@@ -0,0 +1,356 @@
+/*
+ * ****************************************************************************
+ * Copyright (c) 2013-2023, PyInstaller Development Team.
+ *
+ * Distributed under the terms of the GNU General Public License (version 2
+ * or later) with exception for distributing the bootloader.
+ *
+ * The full license is in the file COPYING.txt, distributed with this software.
+ *
+ * SPDX-License-Identifier: (GPL-2.0-or-later WITH Bootloader-exception)
+ * ****************************************************************************
+ */
+
+/*
+ * SHA-256 message digest (FIPS 180-4), and chunked file digest that is
+ * used to verify the integrity of side-loaded PKG archive.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>  /* malloc */
+#include <string.h>  /* memcpy */
+
+#ifndef _WIN32
+    #include <pthread.h>
+    #include <unistd.h>  /* sysconf */
+#endif
+
+/* PyInstaller headers. */
+#include "pyi_global.h"
+#include "pyi_path.h"
+#include "pyi_digest.h"
+
+
+/**********************************************************************\
+ *                              SHA-256                               *
+\**********************************************************************/
+
+static const uint32_t _pyi_sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void
+_pyi_sha256_process_block(struct PYI_SHA256 *sha256, const unsigned char *block)
+{
+    uint32_t w[64];
+    uint32_t a, b, c, d, e, f, g, h;
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[4 * i] << 24) | ((uint32_t)block[4 * i + 1] << 16) | ((uint32_t)block[4 * i + 2] << 8) | (uint32_t)block[4 * i + 3];
+    }
+    for (i = 16; i < 64; i++) {
+        uint32_t s0 = ROTR32(w[i - 15], 7) ^ ROTR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROTR32(w[i - 2], 17) ^ ROTR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    a = sha256->state[0];
+    b = sha256->state[1];
+    c = sha256->state[2];
+    d = sha256->state[3];
+    e = sha256->state[4];
+    f = sha256->state[5];
+    g = sha256->state[6];
+    h = sha256->state[7];
+
+    for (i = 0; i < 64; i++) {
+        uint32_t t1 = h + (ROTR32(e, 6) ^ ROTR32(e, 11) ^ ROTR32(e, 25)) + ((e & f) ^ (~e & g)) + _pyi_sha256_k[i] + w[i];
+        uint32_t t2 = (ROTR32(a, 2) ^ ROTR32(a, 13) ^ ROTR32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    sha256->state[0] += a;
+    sha256->state[1] += b;
+    sha256->state[2] += c;
+    sha256->state[3] += d;
+    sha256->state[4] += e;
+    sha256->state[5] += f;
+    sha256->state[6] += g;
+    sha256->state[7] += h;
+}
+
+void
+pyi_sha256_init(struct PYI_SHA256 *sha256)
+{
+    static const uint32_t initial_state[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+
+    memcpy(sha256->state, initial_state, sizeof(initial_state));
+    sha256->length = 0;
+    sha256->block_length = 0;
+}
+
+void
+pyi_sha256_update(struct PYI_SHA256 *sha256, const void *data, size_t length)
+{
+    const unsigned char *ptr = (const unsigned char *)data;
+
+    sha256->length += length;
+
+    /* Complete the partial block */
+    if (sha256->block_length > 0) {
+        size_t fill_length = 64 - sha256->block_length;
+        if (fill_length > length) {
+            fill_length = length;
+        }
+        memcpy(sha256->block + sha256->block_length, ptr, fill_length);
+        sha256->block_length += fill_length;
+        ptr += fill_length;
+        length -= fill_length;
+        if (sha256->block_length < 64) {
+            return;
+        }
+        _pyi_sha256_process_block(sha256, sha256->block);
+        sha256->block_length = 0;
+    }
+
+    /* Process whole blocks directly from input */
+    while (length >= 64) {
+        _pyi_sha256_process_block(sha256, ptr);
+        ptr += 64;
+        length -= 64;
+    }
+
+    /* Store the remainder */
+    memcpy(sha256->block, ptr, length);
+    sha256->block_length = length;
+}
+
+void
+pyi_sha256_final(struct PYI_SHA256 *sha256, unsigned char *digest)
+{
+    uint64_t bit_length = sha256->length * 8;
+    int i;
+
+    /* Padding: 0x80 byte, zeros, and 64-bit big-endian message length */
+    sha256->block[sha256->block_length++] = 0x80;
+    if (sha256->block_length > 56) {
+        memset(sha256->block + sha256->block_length, 0, 64 - sha256->block_length);
+        _pyi_sha256_process_block(sha256, sha256->block);
+        sha256->block_length = 0;
+    }
+    memset(sha256->block + sha256->block_length, 0, 56 - sha256->block_length);
+    for (i = 0; i < 8; i++) {
+        sha256->block[56 + i] = (unsigned char)(bit_length >> (56 - 8 * i));
+    }
+    _pyi_sha256_process_block(sha256, sha256->block);
+
+    for (i = 0; i < 8; i++) {
+        digest[4 * i] = (unsigned char)(sha256->state[i] >> 24);
+        digest[4 * i + 1] = (unsigned char)(sha256->state[i] >> 16);
+        digest[4 * i + 2] = (unsigned char)(sha256->state[i] >> 8);
+        digest[4 * i + 3] = (unsigned char)sha256->state[i];
+    }
+}
+
+
+/**********************************************************************\
+ *                        Chunked file digest                         *
+\**********************************************************************/
+
+/* Upper limit on number of threads used to compute chunk digests. */
+#define PYI_DIGEST_MAX_THREADS 16
+
+/* State shared by the workers that compute chunk digests. */
+struct PYI_DIGEST_JOB
+{
+    const char *filename;
+    uint64_t file_length;
+    uint64_t chunk_size;
+    uint64_t chunk_count;
+    unsigned char *chunk_digests; /* chunk_count * PYI_SHA256_DIGEST_LENGTH bytes */
+
+    uint64_t next_chunk;
+    int failed;
+#ifndef _WIN32
+    pthread_mutex_t lock;
+#endif
+};
+
+/*
+ * Claim the next chunk whose digest is to be computed. Returns
+ * (uint64_t)-1 when there are no more chunks, or when an error occurred.
+ */
+static uint64_t
+_pyi_digest_claim_chunk(struct PYI_DIGEST_JOB *job, int failed)
+{
+    uint64_t chunk_index = (uint64_t)-1;
+
+#ifndef _WIN32
+    pthread_mutex_lock(&job->lock);
+#endif
+    job->failed |= failed;
+    if (!job->failed && job->next_chunk < job->chunk_count) {
+        chunk_index = job->next_chunk++;
+    }
+#ifndef _WIN32
+    pthread_mutex_unlock(&job->lock);
+#endif
+
+    return chunk_index;
+}
+
+/*
+ * Worker that computes digests of chunks until all are processed. Each
+ * worker uses its own file handle.
+ */
+static void *
+_pyi_digest_worker(void *arg)
+{
+    struct PYI_DIGEST_JOB *job = (struct PYI_DIGEST_JOB *)arg;
+    const size_t BUFFER_SIZE = 64 * 1024;
+    unsigned char *buffer;
+    FILE *fp;
+    uint64_t chunk_index;
+    int failed = 0;
+
+    buffer = (unsigned char *)malloc(BUFFER_SIZE);
+    fp = pyi_path_fopen(job->filename, "rb");
+    if (buffer == NULL || fp == NULL) {
+        failed = 1;
+    }
+
+    while ((chunk_index = _pyi_digest_claim_chunk(job, failed)) != (uint64_t)-1) {
+        struct PYI_SHA256 sha256;
+        uint64_t chunk_offset = chunk_index * job->chunk_size;
+        uint64_t remaining_size = job->file_length - chunk_offset;
+
+        if (remaining_size > job->chunk_size) {
+            remaining_size = job->chunk_size;
+        }
+        if (pyi_fseek(fp, chunk_offset, SEEK_SET) < 0) {
+            failed = 1;
+            continue;
+        }
+
+        pyi_sha256_init(&sha256);
+        while (remaining_size > 0) {
+            size_t read_size = (BUFFER_SIZE < remaining_size) ? BUFFER_SIZE : (size_t)remaining_size;
+            if (fread(buffer, 1, read_size, fp) != read_size) {
+                failed = 1;
+                break;
+            }
+            pyi_sha256_update(&sha256, buffer, read_size);
+            remaining_size -= read_size;
+        }
+        pyi_sha256_final(&sha256, job->chunk_digests + chunk_index * PYI_SHA256_DIGEST_LENGTH);
+    }
+
+    if (fp) {
+        fclose(fp);
+    }
+    free(buffer);
+
+    return NULL;
+}
+
+/*
+ * Compute the chunked digest of the given file, and store its length.
+ * The chunks' digests are computed by multiple threads (on POSIX systems).
+ * Returns 0 on success, -1 on error.
+ */
+int
+pyi_digest_file_chunked(const char *filename, uint64_t chunk_size, unsigned char *digest, uint64_t *file_length)
+{
+    struct PYI_DIGEST_JOB job;
+    struct PYI_SHA256 sha256;
+    FILE *fp;
+#ifndef _WIN32
+    pthread_t threads[PYI_DIGEST_MAX_THREADS];
+    int thread_count = 0;
+    long cpu_count;
+    int i;
+#endif
+
+    if (chunk_size == 0) {
+        return -1;
+    }
+
+    memset(&job, 0, sizeof(job));
+    job.filename = filename;
+    job.chunk_size = chunk_size;
+
+    /* Determine file length */
+    fp = pyi_path_fopen(filename, "rb");
+    if (fp == NULL) {
+        return -1;
+    }
+    if (pyi_fseek(fp, 0, SEEK_END) < 0) {
+        fclose(fp);
+        return -1;
+    }
+    job.file_length = (uint64_t)pyi_ftell(fp);
+    fclose(fp);
+
+    job.chunk_count = (job.file_length + chunk_size - 1) / chunk_size;
+    if (job.chunk_count > SIZE_MAX / PYI_SHA256_DIGEST_LENGTH) {
+        return -1;
+    }
+    job.chunk_digests = (unsigned char *)malloc(job.chunk_count ? (size_t)job.chunk_count * PYI_SHA256_DIGEST_LENGTH : 1);
+    if (job.chunk_digests == NULL) {
+        return -1;
+    }
+
+#ifndef _WIN32
+    /* Compute the chunks' digests using worker threads; the calling
+     * thread participates as well. */
+    pthread_mutex_init(&job.lock, NULL);
+    cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    for (i = 1; i < cpu_count && i < PYI_DIGEST_MAX_THREADS && (uint64_t)i < job.chunk_count; i++) {
+        if (pthread_create(&threads[thread_count], NULL, _pyi_digest_worker, &job) != 0) {
+            break;
+        }
+        thread_count++;
+    }
+    _pyi_digest_worker(&job);
+    for (i = 0; i < thread_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_mutex_destroy(&job.lock);
+    PYI_DEBUG("LOADER: computed digests of %" PRIu64 " chunks using %d thread(s).\n", job.chunk_count, thread_count + 1);
+#else
+    _pyi_digest_worker(&job);
+#endif
+
+    if (job.failed) {
+        free(job.chunk_digests);
+        return -1;
+    }
+
+    /* Combine the chunks' digests */
+    pyi_sha256_init(&sha256);
+    pyi_sha256_update(&sha256, job.chunk_digests, (size_t)job.chunk_count * PYI_SHA256_DIGEST_LENGTH);
+    pyi_sha256_final(&sha256, digest);
+    free(job.chunk_digests);
+
+    *file_length = job.file_length;
+    return 0;
+}
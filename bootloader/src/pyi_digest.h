@@ -0,0 +1,45 @@
+/*
+ * ****************************************************************************
+ * Copyright (c) 2013-2023, PyInstaller Development Team.
+ *
+ * Distributed under the terms of the GNU General Public License (version 2
+ * or later) with exception for distributing the bootloader.
+ *
+ * The full license is in the file COPYING.txt, distributed with this software.
+ *
+ * SPDX-License-Identifier: (GPL-2.0-or-later WITH Bootloader-exception)
+ * ****************************************************************************
+ */
+
+/*
+ * SHA-256 message digest, and chunked file digest built on top of it.
+ */
+
+#ifndef PYI_DIGEST_H
+#define PYI_DIGEST_H
+
+#include <stddef.h>  /* size_t */
+#include <inttypes.h>  /* uint32_t, uint64_t */
+
+#define PYI_SHA256_DIGEST_LENGTH 32
+
+/* SHA-256 computation state */
+struct PYI_SHA256
+{
+    uint32_t state[8];
+    uint64_t length; /* total length of processed data, in bytes */
+    unsigned char block[64]; /* partial input block */
+    size_t block_length;
+};
+
+void pyi_sha256_init(struct PYI_SHA256 *sha256);
+void pyi_sha256_update(struct PYI_SHA256 *sha256, const void *data, size_t length);
+void pyi_sha256_final(struct PYI_SHA256 *sha256, unsigned char *digest);
+
+/* Chunked file digest: SHA-256 of concatenated SHA-256 digests of the
+ * file's consecutive chunks of the given size. Unlike plain SHA-256, the
+ * chunks' digests can be computed in parallel. Must match the digest
+ * computed by `PyInstaller.building.api._compute_pkg_digest`. */
+int pyi_digest_file_chunked(const char *filename, uint64_t chunk_size, unsigned char *digest, uint64_t *file_length);
+
+#endif /* PYI_DIGEST_H */
@@ -273,4 +273,10 @@
     #define pyi_be32toh(x) ntohl(x)
 #endif /* ifdef _WIN32 */
 
+/* 64-bit variant is composed of two 32-bit conversions; the check for
+ * host byte order is resolved at compile time. */
+#define pyi_be64toh(x) \
+    (pyi_be32toh(1) == 1 ? (uint64_t)(x) : \
+    (((uint64_t)pyi_be32toh((uint32_t)(x)) << 32) | (uint64_t)pyi_be32toh((uint32_t)((uint64_t)(x) >> 32))))
+
 #endif /* PYI_GLOBAL_H */
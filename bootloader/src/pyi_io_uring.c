@@ -0,0 +1,605 @@
+/*
+ * ****************************************************************************
+ * Copyright (c) 2013-2023, PyInstaller Development Team.
+ *
+ * Distributed under the terms of the GNU General Public License (version 2
+ * or later) with exception for distributing the bootloader.
+ *
+ * The full license is in the file COPYING.txt, distributed with this software.
+ *
+ * SPDX-License-Identifier: (GPL-2.0-or-later WITH Bootloader-exception)
+ * ****************************************************************************
+ */
+
+/*
+ * Batched extraction of archive entries using io_uring (Linux only).
+ *
+ * Each extracted file is submitted as a chain of linked requests: OPENAT
+ * into a direct (registered) file descriptor, WRITE of the whole data,
+ * and CLOSE. The chains of many files are submitted to the kernel in a
+ * single io_uring_enter() call, instead of making a series of blocking
+ * system calls for each file. The entries' data is written directly from
+ * a read-only mapping of the archive file; compressed entries are
+ * decompressed into a temporary buffer, while the kernel is writing the
+ * previously submitted files.
+ *
+ * Using the direct file descriptor in the linked WRITE request requires
+ * IORING_FEAT_LINKED_FILE (Linux 5.18 or later). If io_uring is not
+ * available (too old kernel, disabled via sysctl, or forbidden by seccomp
+ * filter), pyi_io_uring_extractor_new() fails and the caller should use
+ * the synchronous extraction path. If a request fails, the entry is
+ * extracted again using the synchronous path, and the extractor is
+ * disabled for the remaining entries.
+ *
+ * We use the system calls directly, to avoid dependency on liburing.
+ */
+
+#if defined(HAVE_IO_URING)
+
+#include <errno.h>
+#include <fcntl.h>  /* O_*, AT_FDCWD */
+#include <stdio.h>
+#include <stdlib.h>  /* malloc */
+#include <string.h>  /* memset */
+#include <sys/mman.h>  /* mmap */
+#include <sys/stat.h>  /* fstat */
+#include <sys/syscall.h>  /* __NR_io_uring_* */
+#include <unistd.h>  /* syscall, close */
+#include <linux/io_uring.h>
+
+/* PyInstaller headers. */
+#include "zlib.h"
+#include "pyi_global.h"
+#include "pyi_archive.h"
+#include "pyi_io_uring.h"
+
+
+/* Number of submission queue entries; each file uses up to three. */
+#define PYI_IO_URING_QUEUE_DEPTH 256
+
+/* Number of files that can be in flight at once; each uses one direct
+ * file descriptor slot. */
+#define PYI_IO_URING_SLOT_COUNT 64
+
+/* Limit on the combined size of decompression buffers of in-flight files. */
+#define PYI_IO_URING_MAX_BUFFERED (64 * 1024 * 1024)
+
+/* Entries larger than this are extracted using the synchronous path,
+ * as the length of a single write request is limited. */
+#define PYI_IO_URING_MAX_ENTRY_SIZE (1024 * 1024 * 1024)
+
+/* Operations in a file's chain, encoded in the requests' user data. */
+#define PYI_IO_URING_OP_OPEN 0
+#define PYI_IO_URING_OP_WRITE 1
+#define PYI_IO_URING_OP_CLOSE 2
+
+/* In-flight file */
+struct IO_URING_SLOT
+{
+    const struct TOC_ENTRY *toc_entry;
+    char output_filename[PYI_PATH_MAX]; /* must remain valid until OPENAT completes */
+    unsigned char *buffer; /* decompression buffer (NULL for uncompressed entries) */
+    uint64_t length;
+    int pending; /* number of outstanding requests */
+    bool failed;
+};
+
+struct IO_URING_EXTRACTOR
+{
+    const struct ARCHIVE *archive;
+
+    /* Read-only mapping of the archive file */
+    const unsigned char *archive_data;
+    size_t archive_size;
+
+    int ring_fd;
+
+    /* Submission queue */
+    void *sq_ring;
+    size_t sq_ring_size;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned sq_pending; /* prepared, but not yet submitted entries */
+
+    /* Completion queue */
+    void *cq_ring;
+    size_t cq_ring_size;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+
+    struct IO_URING_SLOT slots[PYI_IO_URING_SLOT_COUNT];
+    int active_slots;
+    uint64_t buffered_size;
+
+    /* Set when a request failed; the remaining entries are extracted
+     * using the synchronous path. */
+    bool disabled;
+    /* Set when synchronous re-extraction of a failed entry failed. */
+    bool failed;
+};
+
+
+static int
+_pyi_io_uring_setup(unsigned entries, struct io_uring_params *params)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int
+_pyi_io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return (int)syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int
+_pyi_io_uring_register(int ring_fd, unsigned opcode, void *arg, unsigned nr_args)
+{
+    return (int)syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args);
+}
+
+/*
+ * Check that the kernel supports all operations that we use.
+ */
+static bool
+_pyi_io_uring_probe_ops(int ring_fd)
+{
+    const size_t probe_size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe;
+    bool supported = false;
+
+    probe = (struct io_uring_probe *)calloc(1, probe_size);
+    if (probe == NULL) {
+        return false;
+    }
+    if (_pyi_io_uring_register(ring_fd, IORING_REGISTER_PROBE, probe, 256) == 0) {
+        supported = probe->last_op >= IORING_OP_CLOSE &&
+            (probe->ops[IORING_OP_OPENAT].flags & IO_URING_OP_SUPPORTED) &&
+            (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED) &&
+            (probe->ops[IORING_OP_CLOSE].flags & IO_URING_OP_SUPPORTED);
+    }
+    free(probe);
+
+    return supported;
+}
+
+/*
+ * Create the extractor for the given archive. Returns NULL if io_uring
+ * is unavailable, in which case the caller should fall back to the
+ * synchronous extraction path.
+ */
+struct IO_URING_EXTRACTOR *
+pyi_io_uring_extractor_new(const struct ARCHIVE *archive)
+{
+    struct IO_URING_EXTRACTOR *extractor;
+    struct io_uring_params params;
+    int files[PYI_IO_URING_SLOT_COUNT];
+    struct stat archive_stat;
+    int archive_fd;
+    int i;
+
+    extractor = (struct IO_URING_EXTRACTOR *)calloc(1, sizeof(struct IO_URING_EXTRACTOR));
+    if (extractor == NULL) {
+        return NULL;
+    }
+    extractor->archive = archive;
+    extractor->ring_fd = -1;
+
+    /* Set up the ring */
+    memset(&params, 0, sizeof(params));
+    extractor->ring_fd = _pyi_io_uring_setup(PYI_IO_URING_QUEUE_DEPTH, &params);
+    if (extractor->ring_fd < 0) {
+        /* ENOSYS (not supported), EPERM (disabled via sysctl or seccomp) */
+        PYI_DEBUG("LOADER: io_uring is not available (errno %d).\n", errno);
+        goto fail;
+    }
+    if (!(params.features & IORING_FEAT_LINKED_FILE) || !_pyi_io_uring_probe_ops(extractor->ring_fd)) {
+        PYI_DEBUG("LOADER: io_uring does not support required features.\n");
+        goto fail;
+    }
+
+    /* Map the submission and completion queue rings, and the array of
+     * submission queue entries. */
+    extractor->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    extractor->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (extractor->cq_ring_size > extractor->sq_ring_size) {
+            extractor->sq_ring_size = extractor->cq_ring_size;
+        }
+        extractor->cq_ring_size = 0; /* shared with SQ ring */
+    }
+
+    extractor->sq_ring = mmap(NULL, extractor->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, extractor->ring_fd, IORING_OFF_SQ_RING);
+    if (extractor->sq_ring == MAP_FAILED) {
+        extractor->sq_ring = NULL;
+        goto fail;
+    }
+    if (extractor->cq_ring_size) {
+        extractor->cq_ring = mmap(NULL, extractor->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, extractor->ring_fd, IORING_OFF_CQ_RING);
+        if (extractor->cq_ring == MAP_FAILED) {
+            extractor->cq_ring = NULL;
+            goto fail;
+        }
+    } else {
+        extractor->cq_ring = extractor->sq_ring;
+    }
+    extractor->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    extractor->sqes = (struct io_uring_sqe *)mmap(NULL, extractor->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, extractor->ring_fd, IORING_OFF_SQES);
+    if (extractor->sqes == MAP_FAILED) {
+        extractor->sqes = NULL;
+        goto fail;
+    }
+
+    extractor->sq_head = (unsigned *)((char *)extractor->sq_ring + params.sq_off.head);
+    extractor->sq_tail = (unsigned *)((char *)extractor->sq_ring + params.sq_off.tail);
+    extractor->sq_mask = (unsigned *)((char *)extractor->sq_ring + params.sq_off.ring_mask);
+    extractor->sq_array = (unsigned *)((char *)extractor->sq_ring + params.sq_off.array);
+    extractor->cq_head = (unsigned *)((char *)extractor->cq_ring + params.cq_off.head);
+    extractor->cq_tail = (unsigned *)((char *)extractor->cq_ring + params.cq_off.tail);
+    extractor->cq_mask = (unsigned *)((char *)extractor->cq_ring + params.cq_off.ring_mask);
+    extractor->cqes = (struct io_uring_cqe *)((char *)extractor->cq_ring + params.cq_off.cqes);
+
+    /* Register sparse table of direct file descriptors */
+    for (i = 0; i < PYI_IO_URING_SLOT_COUNT; i++) {
+        files[i] = -1;
+    }
+    if (_pyi_io_uring_register(extractor->ring_fd, IORING_REGISTER_FILES, files, PYI_IO_URING_SLOT_COUNT) < 0) {
+        PYI_DEBUG("LOADER: failed to register io_uring file table (errno %d).\n", errno);
+        goto fail;
+    }
+
+    /* Map the archive file */
+    archive_fd = open(archive->filename, O_RDONLY | O_CLOEXEC);
+    if (archive_fd < 0) {
+        goto fail;
+    }
+    if (fstat(archive_fd, &archive_stat) < 0 || archive_stat.st_size == 0) {
+        close(archive_fd);
+        goto fail;
+    }
+    extractor->archive_size = (size_t)archive_stat.st_size;
+    extractor->archive_data = (const unsigned char *)mmap(NULL, extractor->archive_size, PROT_READ, MAP_PRIVATE, archive_fd, 0);
+    close(archive_fd);
+    if (extractor->archive_data == MAP_FAILED) {
+        extractor->archive_data = NULL;
+        goto fail;
+    }
+
+    PYI_DEBUG("LOADER: using io_uring for extraction of files.\n");
+    return extractor;
+
+fail:
+    pyi_io_uring_extractor_free(&extractor);
+    return NULL;
+}
+
+/*
+ * Free the extractor. The caller must flush it first.
+ */
+void
+pyi_io_uring_extractor_free(struct IO_URING_EXTRACTOR **extractor_ref)
+{
+    struct IO_URING_EXTRACTOR *extractor = *extractor_ref;
+
+    *extractor_ref = NULL;
+    if (extractor == NULL) {
+        return;
+    }
+
+    if (extractor->archive_data) {
+        munmap((void *)extractor->archive_data, extractor->archive_size);
+    }
+    if (extractor->sqes) {
+        munmap(extractor->sqes, extractor->sqes_size);
+    }
+    if (extractor->cq_ring && extractor->cq_ring != extractor->sq_ring) {
+        munmap(extractor->cq_ring, extractor->cq_ring_size);
+    }
+    if (extractor->sq_ring) {
+        munmap(extractor->sq_ring, extractor->sq_ring_size);
+    }
+    if (extractor->ring_fd >= 0) {
+        close(extractor->ring_fd); /* also closes the direct file descriptors */
+    }
+    free(extractor);
+}
+
+
+/**********************************************************************\
+ *                       Request submission                           *
+\**********************************************************************/
+
+/*
+ * Return the next free submission queue entry, or NULL if the queue is
+ * full (and needs to be submitted first).
+ */
+static struct io_uring_sqe *
+_pyi_io_uring_get_sqe(struct IO_URING_EXTRACTOR *extractor)
+{
+    unsigned head = __atomic_load_n(extractor->sq_head, __ATOMIC_ACQUIRE);
+    unsigned tail = *extractor->sq_tail + extractor->sq_pending;
+    struct io_uring_sqe *sqe;
+    unsigned index;
+
+    if (tail - head >= *extractor->sq_mask + 1) {
+        return NULL;
+    }
+    index = tail & *extractor->sq_mask;
+    sqe = &extractor->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    extractor->sq_array[index] = index;
+    extractor->sq_pending++;
+
+    return sqe;
+}
+
+/*
+ * Publish the prepared submission queue entries, submit them to the
+ * kernel, and optionally wait for the given number of completions.
+ */
+static int
+_pyi_io_uring_submit(struct IO_URING_EXTRACTOR *extractor, unsigned min_complete)
+{
+    unsigned to_submit = extractor->sq_pending;
+    int rc;
+
+    __atomic_store_n(extractor->sq_tail, *extractor->sq_tail + to_submit, __ATOMIC_RELEASE);
+    extractor->sq_pending = 0;
+
+    do {
+        rc = _pyi_io_uring_enter(extractor->ring_fd, to_submit, min_complete, min_complete ? IORING_ENTER_GETEVENTS : 0);
+    } while (rc < 0 && errno == EINTR);
+    if (rc < 0) {
+        PYI_PERROR("io_uring_enter", "Failed to submit extraction requests!\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Finalize the slot whose requests have all completed. If any of the
+ * requests failed, extract the entry again using the synchronous path.
+ */
+static void
+_pyi_io_uring_complete_slot(struct IO_URING_EXTRACTOR *extractor, struct IO_URING_SLOT *slot)
+{
+    if (slot->failed) {
+        PYI_DEBUG("LOADER: io_uring extraction of %s failed; falling back to synchronous extraction.\n", slot->toc_entry->name);
+        extractor->disabled = true;
+        if (pyi_archive_extract2fs(extractor->archive, slot->toc_entry, slot->output_filename) < 0) {
+            PYI_ERROR("Failed to extract entry: %s.\n", slot->toc_entry->name);
+            extractor->failed = true;
+        }
+    }
+
+    free(slot->buffer);
+    extractor->buffered_size -= slot->buffer ? slot->length : 0;
+    slot->buffer = NULL;
+    slot->toc_entry = NULL;
+    extractor->active_slots--;
+}
+
+/*
+ * Process the available completion queue entries.
+ */
+static void
+_pyi_io_uring_reap(struct IO_URING_EXTRACTOR *extractor)
+{
+    unsigned head = *extractor->cq_head;
+    unsigned tail = __atomic_load_n(extractor->cq_tail, __ATOMIC_ACQUIRE);
+
+    while (head != tail) {
+        const struct io_uring_cqe *cqe = &extractor->cqes[head & *extractor->cq_mask];
+        struct IO_URING_SLOT *slot = &extractor->slots[cqe->user_data >> 2];
+        int op = (int)(cqe->user_data & 3);
+
+        if (cqe->res < 0 || (op == PYI_IO_URING_OP_WRITE && (uint64_t)cqe->res != slot->length)) {
+            slot->failed = true;
+        }
+        if (--slot->pending == 0) {
+            _pyi_io_uring_complete_slot(extractor, slot);
+        }
+        head++;
+    }
+
+    __atomic_store_n(extractor->cq_head, head, __ATOMIC_RELEASE);
+}
+
+/*
+ * Submit the prepared requests and wait for at least one completion.
+ */
+static int
+_pyi_io_uring_wait(struct IO_URING_EXTRACTOR *extractor)
+{
+    if (_pyi_io_uring_submit(extractor, 1) < 0) {
+        return -1;
+    }
+    _pyi_io_uring_reap(extractor);
+    return 0;
+}
+
+/*
+ * Decompress the entry's data from the archive mapping into a newly
+ * allocated buffer.
+ */
+static unsigned char *
+_pyi_io_uring_decompress(const struct TOC_ENTRY *toc_entry, const unsigned char *src)
+{
+    unsigned char *buffer;
+    z_stream zstream;
+    int rc;
+
+    buffer = (unsigned char *)malloc(toc_entry->uncompressed_length ? (size_t)toc_entry->uncompressed_length : 1);
+    if (buffer == NULL) {
+        return NULL;
+    }
+
+    memset(&zstream, 0, sizeof(zstream));
+    zstream.next_in = (unsigned char *)src;
+    zstream.avail_in = (uInt)toc_entry->length;
+    zstream.next_out = buffer;
+    zstream.avail_out = (uInt)toc_entry->uncompressed_length;
+    rc = inflateInit(&zstream);
+    if (rc == Z_OK) {
+        rc = inflate(&zstream, Z_FINISH);
+        inflateEnd(&zstream);
+    }
+    if (rc != Z_STREAM_END || zstream.total_out != toc_entry->uncompressed_length) {
+        free(buffer);
+        return NULL;
+    }
+
+    return buffer;
+}
+
+/*
+ * Queue extraction of the given entry. Returns 0 if the extraction was
+ * queued, 1 if the entry is not eligible for extraction via io_uring (in
+ * which case the caller should extract it using the synchronous path),
+ * and -1 on error.
+ */
+int
+pyi_io_uring_extract(struct IO_URING_EXTRACTOR *extractor, const struct TOC_ENTRY *toc_entry, const char *output_filename)
+{
+    struct IO_URING_SLOT *slot = NULL;
+    struct io_uring_sqe *sqe;
+    const unsigned char *data;
+    uint64_t data_start;
+    unsigned slot_index;
+    int i;
+
+    if (extractor->disabled) {
+        return 1;
+    }
+
+    /* Only regular files of limited size */
+    switch (toc_entry->typecode) {
+        case ARCHIVE_ITEM_BINARY:
+        case ARCHIVE_ITEM_DATA:
+        case ARCHIVE_ITEM_ZIPFILE: {
+            break;
+        }
+        default: {
+            return 1;
+        }
+    }
+    if (toc_entry->uncompressed_length > PYI_IO_URING_MAX_ENTRY_SIZE || toc_entry->length > PYI_IO_URING_MAX_ENTRY_SIZE) {
+        return 1;
+    }
+    if (strlen(output_filename) >= PYI_PATH_MAX) {
+        return 1;
+    }
+
+    data_start = extractor->archive->pkg_offset + toc_entry->offset;
+    if (data_start > extractor->archive_size || toc_entry->length > extractor->archive_size - data_start) {
+        return 1; /* Let the synchronous path report the error */
+    }
+
+    /* Wait for a free slot, space in submission queue, and (for compressed
+     * entries) for the decompression buffers to drain. */
+    while (extractor->active_slots == PYI_IO_URING_SLOT_COUNT ||
+        (toc_entry->compression_flag == 1 && extractor->buffered_size > 0 && extractor->buffered_size + toc_entry->uncompressed_length > PYI_IO_URING_MAX_BUFFERED)) {
+        if (_pyi_io_uring_wait(extractor) < 0) {
+            return -1;
+        }
+    }
+    if (*extractor->sq_mask + 1 - (*extractor->sq_tail + extractor->sq_pending - __atomic_load_n(extractor->sq_head, __ATOMIC_ACQUIRE)) < 3) {
+        if (_pyi_io_uring_submit(extractor, 0) < 0) {
+            return -1;
+        }
+    }
+
+    /* Obtain the data */
+    data = extractor->archive_data + data_start;
+    if (toc_entry->compression_flag == 1) {
+        unsigned char *buffer = _pyi_io_uring_decompress(toc_entry, data);
+        if (buffer == NULL) {
+            return 1; /* Let the synchronous path report the error */
+        }
+        data = buffer;
+    }
+
+    /* Claim a free slot */
+    for (i = 0; i < PYI_IO_URING_SLOT_COUNT; i++) {
+        if (extractor->slots[i].toc_entry == NULL) {
+            slot = &extractor->slots[i];
+            break;
+        }
+    }
+    slot_index = (unsigned)(slot - extractor->slots);
+    slot->toc_entry = toc_entry;
+    snprintf(slot->output_filename, PYI_PATH_MAX, "%s", output_filename);
+    slot->buffer = toc_entry->compression_flag == 1 ? (unsigned char *)data : NULL;
+    slot->length = toc_entry->uncompressed_length;
+    slot->failed = false;
+    slot->pending = 0;
+    extractor->active_slots++;
+    if (slot->buffer) {
+        extractor->buffered_size += slot->length;
+    }
+
+    /* OPENAT into the slot's direct file descriptor */
+    sqe = _pyi_io_uring_get_sqe(extractor);
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = (uint64_t)(uintptr_t)slot->output_filename;
+    sqe->open_flags = O_WRONLY | O_CREAT | O_TRUNC; /* O_CLOEXEC is invalid (and moot) for direct descriptors */
+    sqe->len = toc_entry->typecode == ARCHIVE_ITEM_BINARY ? 0700 : 0600; /* mode */
+    sqe->file_index = slot_index + 1;
+    sqe->flags = IOSQE_IO_LINK;
+    sqe->user_data = ((uint64_t)slot_index << 2) | PYI_IO_URING_OP_OPEN;
+    slot->pending++;
+
+    /* WRITE of the whole data; the CLOSE request is hard-linked to it, so
+     * that the descriptor is closed even if the write fails. */
+    if (slot->length > 0) {
+        sqe = _pyi_io_uring_get_sqe(extractor);
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->fd = (int)slot_index;
+        sqe->addr = (uint64_t)(uintptr_t)data;
+        sqe->len = (unsigned)slot->length;
+        sqe->off = 0;
+        sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+        sqe->user_data = ((uint64_t)slot_index << 2) | PYI_IO_URING_OP_WRITE;
+        slot->pending++;
+    }
+
+    /* CLOSE of the direct file descriptor */
+    sqe = _pyi_io_uring_get_sqe(extractor);
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->file_index = slot_index + 1;
+    sqe->user_data = ((uint64_t)slot_index << 2) | PYI_IO_URING_OP_CLOSE;
+    slot->pending++;
+
+    /* Submit in batches; the requests are only queued here, and are
+     * submitted when queue fills up, or when the extractor is flushed. */
+    _pyi_io_uring_reap(extractor);
+
+    return 0;
+}
+
+/*
+ * Submit all queued requests and wait for their completion. This must be
+ * called before accessing the extracted files (for example, when creating
+ * hard links to them), and after the last entry has been queued.
+ * Returns 0 on success, -1 if any of the entries could not be extracted.
+ */
+int
+pyi_io_uring_flush(struct IO_URING_EXTRACTOR *extractor)
+{
+    while (extractor->active_slots > 0 || extractor->sq_pending > 0) {
+        if (_pyi_io_uring_wait(extractor) < 0) {
+            return -1;
+        }
+    }
+
+    return extractor->failed ? -1 : 0;
+}
+
+#endif /* defined(HAVE_IO_URING) */
@@ -0,0 +1,35 @@
+/*
+ * ****************************************************************************
+ * Copyright (c) 2013-2023, PyInstaller Development Team.
+ *
+ * Distributed under the terms of the GNU General Public License (version 2
+ * or later) with exception for distributing the bootloader.
+ *
+ * The full license is in the file COPYING.txt, distributed with this software.
+ *
+ * SPDX-License-Identifier: (GPL-2.0-or-later WITH Bootloader-exception)
+ * ****************************************************************************
+ */
+
+/*
+ * Batched extraction of archive entries using io_uring (Linux only).
+ */
+
+#ifndef PYI_IO_URING_H
+#define PYI_IO_URING_H
+
+#if defined(HAVE_IO_URING)
+
+#include "pyi_archive.h"
+
+struct IO_URING_EXTRACTOR;
+
+struct IO_URING_EXTRACTOR *pyi_io_uring_extractor_new(const struct ARCHIVE *archive);
+void pyi_io_uring_extractor_free(struct IO_URING_EXTRACTOR **extractor_ref);
+
+int pyi_io_uring_extract(struct IO_URING_EXTRACTOR *extractor, const struct TOC_ENTRY *toc_entry, const char *output_filename);
+int pyi_io_uring_flush(struct IO_URING_EXTRACTOR *extractor);
+
+#endif /* defined(HAVE_IO_URING) */
+
+#endif /* PYI_IO_URING_H */
@@ -33,10 +33,41 @@
 #include "pyi_splash.h"
 #include "pyi_python.h"
 #include "pyi_pythonlib.h"
+#include "pyi_readahead.h"
 #include "pyi_exception_dialog.h"
 #include "pyi_multipkg.h"
+#include "pyi_io_uring.h"
 
 
+/*
+ * Extract an alias entry (type 'h') by creating a hard link to the file
+ * that was extracted from the aliased entry. If hard link cannot be
+ * created (for example, the aliased file has not been extracted, or the
+ * file system does not support hard links), fall back to extracting the
+ * shared data.
+ */
+static int
+_pyi_launch_extract_alias(const struct PYI_CONTEXT *pyi_ctx, const struct TOC_ENTRY *toc_entry, const char *output_filename)
+{
+    const struct TOC_ENTRY *owner_entry;
+    char owner_filename[PYI_PATH_MAX];
+
+    owner_entry = pyi_archive_resolve_alias(pyi_ctx->archive, toc_entry);
+    if (owner_entry == NULL) {
+        PYI_ERROR("Failed to resolve aliased entry for %s!\n", toc_entry->name);
+        return -1;
+    }
+
+    if (snprintf(owner_filename, PYI_PATH_MAX, "%s%c%s", pyi_ctx->application_home_dir, PYI_SEP, owner_entry->name) < PYI_PATH_MAX) {
+        if (pyi_path_exists(owner_filename) == 1 && pyi_path_mkhardlink(owner_filename, output_filename) == 0) {
+            return 0;
+        }
+    }
+
+    PYI_DEBUG("LOADER: failed to hard link %s to %s; extracting a copy.\n", toc_entry->name, owner_entry->name);
+    return pyi_archive_extract2fs(pyi_ctx->archive, owner_entry, output_filename);
+}
+
 /*
  * Extract all binaries (type 'b') and all data files (type 'x') to the filesystem
  * and checks for dependencies (type 'd'). If dependencies are found, extract them.
@@ -61,11 +92,44 @@ pyi_launch_extract_files_from_archive(struct PYI_CONTEXT *pyi_ctx)
     char multipkg_ref[PYI_PATH_MAX];
     char multipkg_name[PYI_PATH_MAX];
 
-    const char *entry_filename;
+    const char *entry_filename = NULL;
+
+    /* Byte-based extraction progress, for display on splash screen */
+    uint64_t bytes_total = 0;
+    uint64_t bytes_done = 0;
+
+#if defined(HAVE_IO_URING)
+    struct IO_URING_EXTRACTOR *io_uring_extractor = NULL;
+#endif
 
     /* Clear the archive pool array. */
     memset(multipkg_archive_pool, 0, sizeof(multipkg_archive_pool));
 
+#if defined(HAVE_IO_URING)
+    /* If enabled, set up batched extraction via io_uring; if it is not
+     * available, the synchronous extraction path is used. */
+    if (pyi_ctx->io_uring_extraction) {
+        io_uring_extractor = pyi_io_uring_extractor_new(archive);
+    }
+#endif
+
+    /* Compute the total size of the data to be extracted */
+    if (pyi_ctx->splash != NULL) {
+        for (toc_entry = archive->toc; toc_entry < archive->toc_end; toc_entry = pyi_archive_next_toc_entry(archive, toc_entry)) {
+            switch (toc_entry->typecode) {
+                case ARCHIVE_ITEM_BINARY:
+                case ARCHIVE_ITEM_DATA:
+                case ARCHIVE_ITEM_ZIPFILE: {
+                    bytes_total += toc_entry->uncompressed_length;
+                    break;
+                }
+                default: {
+                    break;
+                }
+            }
+        }
+    }
+
     for (toc_entry = archive->toc; toc_entry < archive->toc_end; toc_entry = pyi_archive_next_toc_entry(archive, toc_entry)) {
         /* Check if entry is extractable */
         switch (toc_entry->typecode) {
@@ -73,7 +137,8 @@ pyi_launch_extract_files_from_archive(struct PYI_CONTEXT *pyi_ctx)
             case ARCHIVE_ITEM_BINARY:
             case ARCHIVE_ITEM_DATA:
             case ARCHIVE_ITEM_ZIPFILE:
-            case ARCHIVE_ITEM_SYMLINK: {
+            case ARCHIVE_ITEM_SYMLINK:
+            case ARCHIVE_ITEM_ALIAS: {
                 /* toc_entry->name is the output filename */
                 entry_filename = toc_entry->name;
                 break;
@@ -98,9 +163,22 @@ pyi_launch_extract_files_from_archive(struct PYI_CONTEXT *pyi_ctx)
             break;
         }
 
-        /* Update splash screen (display name of the currently-processed entry) */
+        /* Update splash screen (display name of the currently-processed
+         * entry, and the progress); the updates are coalesced and
+         * rate-limited by the splash screen. */
         if (pyi_ctx->splash != NULL) {
-            pyi_splash_update_text(pyi_ctx->splash, entry_filename);
+            pyi_splash_update_progress(pyi_ctx->splash, entry_filename, bytes_done, bytes_total);
+            switch (toc_entry->typecode) {
+                case ARCHIVE_ITEM_BINARY:
+                case ARCHIVE_ITEM_DATA:
+                case ARCHIVE_ITEM_ZIPFILE: {
+                    bytes_done += toc_entry->uncompressed_length;
+                    break;
+                }
+                default: {
+                    break;
+                }
+            }
         }
 
         /* Construct output filename */
@@ -134,6 +212,28 @@ pyi_launch_extract_files_from_archive(struct PYI_CONTEXT *pyi_ctx)
             break;
         }
 
+#if defined(HAVE_IO_URING)
+        if (io_uring_extractor != NULL) {
+            /* Dependencies and aliases may need to access previously
+             * extracted files, so wait for pending extractions first. */
+            if (toc_entry->typecode == ARCHIVE_ITEM_DEPENDENCY || toc_entry->typecode == ARCHIVE_ITEM_ALIAS) {
+                if (pyi_io_uring_flush(io_uring_extractor) < 0) {
+                    retcode = -1;
+                    break;
+                }
+            } else {
+                retcode = pyi_io_uring_extract(io_uring_extractor, toc_entry, output_filename);
+                if (retcode < 0) {
+                    PYI_ERROR("Failed to extract entry: %s.\n", toc_entry->name);
+                    break;
+                } else if (retcode == 0) {
+                    continue; /* Queued */
+                }
+                /* Not eligible; extract using the synchronous path */
+            }
+        }
+#endif
+
         /* Extract */
         if (toc_entry->typecode == ARCHIVE_ITEM_DEPENDENCY) {
             retcode = pyi_multipkg_extract_dependency(
@@ -143,6 +243,8 @@ pyi_launch_extract_files_from_archive(struct PYI_CONTEXT *pyi_ctx)
                 multipkg_name,
                 output_filename
             );
+        } else if (toc_entry->typecode == ARCHIVE_ITEM_ALIAS) {
+            retcode = _pyi_launch_extract_alias(pyi_ctx, toc_entry, output_filename);
         } else {
             retcode = pyi_archive_extract2fs(archive, toc_entry, output_filename);
         }
@@ -154,6 +256,22 @@ pyi_launch_extract_files_from_archive(struct PYI_CONTEXT *pyi_ctx)
         }
     }
 
+#if defined(HAVE_IO_URING)
+    /* Wait for pending extractions to complete. */
+    if (io_uring_extractor != NULL) {
+        if (pyi_io_uring_flush(io_uring_extractor) < 0) {
+            retcode = -1;
+        }
+        pyi_io_uring_extractor_free(&io_uring_extractor);
+    }
+#endif
+
+    /* Display the final status on splash screen */
+    if (pyi_ctx->splash != NULL && retcode == 0) {
+        pyi_splash_update_progress(pyi_ctx->splash, entry_filename ? entry_filename : "", bytes_done, bytes_total);
+        pyi_splash_flush_status(pyi_ctx->splash);
+    }
+
     /* Free memory allocated for archive pool. */
     for (index = 0; multipkg_archive_pool[index] != NULL; index++) {
         pyi_archive_free(&multipkg_archive_pool[index]);
@@ -270,6 +388,39 @@ _pyi_extract_exception_traceback(
 
 #endif /* if defined(WINDOWED) */
 
+/*
+ * Check if the currently raised exception is SystemExit (or its
+ * subclass).
+ */
+static int
+_pyi_launch_is_system_exit()
+{
+    PyObject *ptype, *pvalue, *ptraceback;
+    PyObject *builtins;
+    PyObject *system_exit = NULL;
+    int matches;
+
+    /* Temporarily clear the error indicator, so we can look up the
+     * exception class. */
+    PI_PyErr_Fetch(&ptype, &pvalue, &ptraceback);
+    builtins = PI_PyImport_ImportModule("builtins");
+    if (builtins != NULL) {
+        system_exit = PI_PyObject_GetAttrString(builtins, "SystemExit");
+        PI_Py_DecRef(builtins);
+    }
+    PI_PyErr_Clear();
+    PI_PyErr_Restore(ptype, pvalue, ptraceback);
+
+    if (system_exit == NULL) {
+        return 0;
+    }
+
+    matches = PI_PyErr_ExceptionMatches(system_exit);
+    PI_Py_DecRef(system_exit);
+
+    return matches;
+}
+
 /*
  * Run scripts
  * Return non zero on failure
@@ -280,7 +431,10 @@ _pyi_launch_run_scripts(const struct PYI_CONTEXT *pyi_ctx)
     const struct ARCHIVE *archive = pyi_ctx->archive;
     unsigned char *data;
     char buf[PYI_PATH_MAX];
+    const struct TOC_ENTRY *const *script_entries;
     const struct TOC_ENTRY *toc_entry;
+    uint32_t num_scripts;
+    uint32_t i;
     PyObject *__main__;
     PyObject *__file__;
     PyObject *main_dict;
@@ -300,11 +454,10 @@ _pyi_launch_run_scripts(const struct PYI_CONTEXT *pyi_ctx)
         return -1;
     }
 
-    /* Iterate through toc looking for scripts (type 's') */
-    for (toc_entry = archive->toc; toc_entry < archive->toc_end; toc_entry = pyi_archive_next_toc_entry(archive, toc_entry)) {
-        if (toc_entry->typecode != ARCHIVE_ITEM_PYSOURCE) {
-            continue;
-        }
+    /* Iterate through scripts (type 's') in TOC */
+    script_entries = pyi_archive_get_entries_by_typecode(archive, ARCHIVE_ITEM_PYSOURCE, &num_scripts);
+    for (i = 0; i < num_scripts; i++) {
+        toc_entry = script_entries[i];
 
         /* Get data out of the archive.  */
         data = pyi_archive_extract(archive, toc_entry);
@@ -347,6 +500,25 @@ _pyi_launch_run_scripts(const struct PYI_CONTEXT *pyi_ctx)
          * (Since we evaluate module-level code, which is not allowed to return an
          * object, the Python object returned is always None.) */
         if (!retval) {
+            /* In fast-exit mode, SystemExit must not reach PyErr_Print(),
+             * because it would call exit() and thus finalize the python
+             * interpreter. Instead, the exception is stored in sys
+             * module, and the exit code is derived from it during the
+             * fast exit. */
+            if (pyi_ctx->fast_exit && _pyi_launch_is_system_exit()) {
+                PyObject *ptype, *pvalue, *ptraceback;
+
+                PI_PyErr_Fetch(&ptype, &pvalue, &ptraceback);
+                PI_PyErr_NormalizeException(&ptype, &pvalue, &ptraceback);
+                PI_PySys_SetObject("_pyi_system_exit", pvalue);
+                PI_Py_DecRef(ptype);
+                PI_Py_DecRef(pvalue);
+                PI_Py_DecRef(ptraceback);
+
+                PYI_DEBUG("LOADER: script raised SystemExit; deferring to fast exit.\n");
+                return 0;
+            }
+
 #if defined(WINDOWED)
             /* In windowed mode, we need to display error information
              * via non-console means (i.e., error dialog on Windows,
@@ -443,6 +615,12 @@ pyi_launch_execute(struct PYI_CONTEXT *pyi_ctx)
         pyi_ctx->python_symbols_loaded = 1;
     }
 
+    /* Warm up page cache for the bundled shared libraries that were
+     * selected at build time, while python interpreter is initialized. */
+    if (pyi_readahead_start(pyi_ctx) < 0) {
+        PYI_DEBUG("LOADER: failed to start readahead thread!\n");
+    }
+
     /* Start Python. */
     if (pyi_pylib_start_python(pyi_ctx)) {
         return -1;
@@ -458,6 +636,16 @@ pyi_launch_execute(struct PYI_CONTEXT *pyi_ctx)
         return -1;
     }
 
+    /* Set up on-demand access to archive entries (onefile mode) */
+    if (pyi_ctx->is_onefile && pyi_pylib_install_lazy_entries(pyi_ctx)) {
+        return -1;
+    }
+
+    /* Allow recording of usage profile, if enabled at build time */
+    if (pyi_ctx->usage_recorder && pyi_pylib_enable_usage_recorder(pyi_ctx)) {
+        return -1;
+    }
+
     /* Run scripts */
     rc = _pyi_launch_run_scripts(pyi_ctx);
 
@@ -35,6 +35,7 @@
 
 #if defined(__linux__)
     #include <sys/prctl.h> /* prctl() */
+    #include <malloc.h> /* malloc_trim() */
 #endif
 
 #if defined(__APPLE__) && defined(WINDOWED)
@@ -50,6 +51,7 @@
 #include "pyi_global.h"  /* PYI_PATH_MAX */
 #include "pyi_path.h"
 #include "pyi_archive.h"
+#include "pyi_digest.h"
 #include "pyi_utils.h"
 #include "pyi_pythonlib.h"
 #include "pyi_launch.h"
@@ -90,6 +92,7 @@ static void _pyi_main_setup_splash_screen(struct PYI_CONTEXT *pyi_ctx);
 
 static int _pyi_main_onedir_or_onefile_child(struct PYI_CONTEXT *pyi_ctx);
 static int _pyi_main_onefile_parent(struct PYI_CONTEXT *pyi_ctx);
+static int _pyi_main_onefile_parent_finish(struct PYI_CONTEXT *pyi_ctx, int ret);
 
 static int _pyi_main_resolve_executable(struct PYI_CONTEXT *pyi_context);
 static int _pyi_main_resolve_pkg_archive(struct PYI_CONTEXT *pyi_context);
@@ -115,6 +118,22 @@ pyi_main(struct PYI_CONTEXT *pyi_ctx)
 
     PYI_DEBUG("PyInstaller Bootloader 6.x\n");
 
+    /* Check if this is the onefile waiter process, to which the onefile
+     * parent process handed over the supervision of the child process.
+     * This needs to be done before anything else, in order to keep the
+     * waiter's memory footprint minimal. */
+#if !defined(_WIN32)
+    if (1) {
+        int ret = pyi_utils_run_onefile_waiter(pyi_ctx);
+        if (ret != -2) {
+            if (ret == -1) {
+                return -1;
+            }
+            return _pyi_main_onefile_parent_finish(pyi_ctx, ret);
+        }
+    }
+#endif
+
     /* In debug builds, dump the command-line arguments. */
 #if defined(LAUNCH_DEBUG)
     _pyi_main_dump_command_line_arguments(pyi_ctx);
@@ -324,6 +343,16 @@ pyi_main(struct PYI_CONTEXT *pyi_ctx)
             }
 
             PYI_DEBUG("LOADER: created temporary directory: %s\n", pyi_ctx->application_home_dir);
+
+            /* On POSIX systems, lock the temporary directory for the
+             * lifetime of the application, and opportunistically sweep
+             * for stale temporary directories left behind by abruptly
+             * terminated instances. Both are best-effort; failures are
+             * not fatal. */
+#if !defined(_WIN32)
+            pyi_lock_temporary_application_directory(pyi_ctx);
+            pyi_sweep_stale_temporary_directories(pyi_ctx);
+#endif
         } else {
             /* Child process; the path to ephemeral application top-level
              * directory should be available in _PYI_APPLICATION_HOME_DIR
@@ -532,12 +561,13 @@ static void
 _pyi_main_read_runtime_options(struct PYI_CONTEXT *pyi_ctx)
 {
     const struct ARCHIVE *archive = pyi_ctx->archive;
-    const struct TOC_ENTRY *toc_entry;
+    const struct TOC_ENTRY *const *option_entries;
+    uint32_t num_options;
+    uint32_t i;
 
-    for (toc_entry = archive->toc; toc_entry < archive->toc_end; toc_entry = pyi_archive_next_toc_entry(archive, toc_entry)) {
-        if (toc_entry->typecode != ARCHIVE_ITEM_RUNTIME_OPTION) {
-            continue;
-        }
+    option_entries = pyi_archive_get_entries_by_typecode(archive, ARCHIVE_ITEM_RUNTIME_OPTION, &num_options);
+    for (i = 0; i < num_options; i++) {
+        const struct TOC_ENTRY *toc_entry = option_entries[i];
 
         /* NOTE: option names are constants, so we use hard-coded
          * lengths as well to avoid invoking strlen() on each
@@ -629,6 +659,55 @@ _pyi_main_read_runtime_options(struct PYI_CONTEXT *pyi_ctx)
             continue;
         }
 #endif
+
+        /* pyi-deferred-cleanup
+         *
+         * Deferred removal of temporary directory in onefile parent
+         * process (POSIX only) */
+#if !defined(_WIN32)
+        if (strncmp(toc_entry->name, "pyi-deferred-cleanup", 20) == 0) {
+            pyi_ctx->deferred_cleanup = 1;
+            continue;
+        }
+#endif
+
+        /* pyi-fast-exit
+         *
+         * Skip finalization of python interpreter at exit */
+        if (strncmp(toc_entry->name, "pyi-fast-exit", 13) == 0) {
+            pyi_ctx->fast_exit = 1;
+            continue;
+        }
+
+        /* pyi-io-uring-extraction
+         *
+         * Batched extraction of files via io_uring in onefile parent
+         * process (Linux only) */
+#if defined(__linux__)
+        if (strncmp(toc_entry->name, "pyi-io-uring-extraction", 23) == 0) {
+            pyi_ctx->io_uring_extraction = 1;
+            continue;
+        }
+#endif
+
+        /* pyi-onefile-exec-waiter
+         *
+         * Hand over the supervision of child process to minimal waiter
+         * process in onefile mode (POSIX only) */
+#if !defined(_WIN32)
+        if (strncmp(toc_entry->name, "pyi-onefile-exec-waiter", 23) == 0) {
+            pyi_ctx->onefile_exec_waiter = 1;
+            continue;
+        }
+#endif
+
+        /* pyi-usage-recorder
+         *
+         * Allow recording of the application's usage profile */
+        if (strncmp(toc_entry->name, "pyi-usage-recorder", 18) == 0) {
+            pyi_ctx->usage_recorder = 1;
+            continue;
+        }
     }
 }
 
@@ -704,6 +783,15 @@ _pyi_main_setup_splash_screen(struct PYI_CONTEXT *pyi_ctx)
             PYI_WARNING("Failed to unpack splash screen dependencies from PKG archive!\n");
             goto cleanup;
         }
+
+        /* Load Tcl/Tk shared libraries and start the splash screen in
+         * a separate thread, so that the extraction of the remaining
+         * files can proceed in the meantime. The bring-up thread is
+         * joined once the extraction is complete. */
+        if (pyi_splash_start_async(pyi_ctx->splash, pyi_ctx->executable_filename) == 0) {
+            return;
+        }
+        PYI_DEBUG("LOADER: failed to create splash screen bring-up thread; starting splash screen synchronously.\n");
     }
 
     /* Load Tcl/Tk shared libraries */
@@ -805,6 +893,14 @@ _pyi_main_onedir_or_onefile_child(struct PYI_CONTEXT *pyi_ctx)
     /* Main code to initialize Python and run user's code. */
     pyi_launch_initialize(pyi_ctx);
     ret = pyi_launch_execute(pyi_ctx);
+
+    /* In fast-exit mode, terminate the process without finalizing the
+     * python interpreter; this returns only if the interpreter was not
+     * initialized (i.e., if we failed to start it). */
+    if (pyi_ctx->fast_exit) {
+        pyi_pylib_fast_exit(pyi_ctx, ret);
+    }
+
     pyi_launch_finalize(pyi_ctx);
 
     /* Clean up splash screen resources; required when in single-process
@@ -825,6 +921,34 @@ _pyi_main_onedir_or_onefile_child(struct PYI_CONTEXT *pyi_ctx)
 /**********************************************************************\
  *                      Onefile parent codepath                       *
 \**********************************************************************/
+
+/*
+ * Release the resources that onefile parent process does not need after
+ * the extraction, before it starts waiting for the child process; on
+ * hosts that run many instances of the application, the memory held by
+ * idle parent processes adds up. The Tcl/Tk interpreter of the splash
+ * screen needs to stay alive, because the splash screen is shown until
+ * the child process closes it; if the splash screen is not used, this
+ * process can optionally be replaced by a minimal waiter process (see
+ * pyi_utils_create_child).
+ */
+static void
+_pyi_main_onefile_parent_release_resources(struct PYI_CONTEXT *pyi_ctx)
+{
+    /* The archive and its TOC are needed only during extraction. */
+    pyi_archive_free(&pyi_ctx->archive);
+
+    /* Splash screen's script, image, and list of requirements are
+     * needed only during its start-up and during extraction. */
+    pyi_splash_free_startup_data(pyi_ctx->splash);
+
+    /* Return the freed heap memory to the OS; glibc keeps it in the
+     * process' arenas otherwise. */
+#if defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+}
+
 static int
 _pyi_main_onefile_parent(struct PYI_CONTEXT *pyi_ctx)
 {
@@ -832,7 +956,18 @@ _pyi_main_onefile_parent(struct PYI_CONTEXT *pyi_ctx)
 
     /* Extract files to temporary directory */
     PYI_DEBUG("LOADER: extracting files to temporary directory...\n");
-    if (pyi_launch_extract_files_from_archive(pyi_ctx) < 0) {
+    ret = pyi_launch_extract_files_from_archive(pyi_ctx);
+
+    /* Wait for the splash screen bring-up, which ran concurrently with
+     * the extraction. The splash screen must be up before the child
+     * process is spawned, so that the child inherits the _PYI_SPLASH_IPC
+     * environment variable that is set by the splash screen script. */
+    if (pyi_splash_join(pyi_ctx->splash) != 0) {
+        pyi_splash_finalize(pyi_ctx->splash);
+        pyi_splash_context_free(&pyi_ctx->splash);
+    }
+
+    if (ret < 0) {
         PYI_DEBUG("LOADER: failed to extract files!\n");
         return -1;
     }
@@ -924,12 +1059,28 @@ _pyi_main_onefile_parent(struct PYI_CONTEXT *pyi_ctx)
     PYI_DEBUG("LOADER: setting _PYI_APPLICATION_HOME_DIR to %s\n", pyi_ctx->application_home_dir);
     pyi_setenv("_PYI_APPLICATION_HOME_DIR", pyi_ctx->application_home_dir);
 
+    /* Release resources that are not needed anymore, to keep the memory
+     * footprint low while we wait for the child process. */
+    _pyi_main_onefile_parent_release_resources(pyi_ctx);
+
     /* Start the child process that will execute user's program. */
     PYI_DEBUG("LOADER: starting the child process...\n");
     ret = pyi_utils_create_child(pyi_ctx);
 
     PYI_DEBUG("LOADER: child process exited (return code: %d)\n", ret);
 
+    return _pyi_main_onefile_parent_finish(pyi_ctx, ret);
+}
+
+/*
+ * Clean up after the child process exited, and re-raise its signal, if
+ * necessary. Used both by the onefile parent process and by the onefile
+ * waiter process (POSIX only) that took over the supervision of the
+ * child process from it.
+ */
+static int
+_pyi_main_onefile_parent_finish(struct PYI_CONTEXT *pyi_ctx, int ret)
+{
     PYI_DEBUG("LOADER: performing cleanup...\n");
 
     /* The cleanup code for onefile parent process is organized in a
@@ -967,9 +1118,30 @@ int pyi_main_onefile_parent_cleanup(struct PYI_CONTEXT *pyi_ctx)
     pyi_splash_finalize(pyi_ctx->splash);
     pyi_splash_context_free(&pyi_ctx->splash);
 
-    /* Remove the application's temporary directory */
+    /* Remove the application's temporary directory. In deferred cleanup
+     * mode, the removal is handed over to a detached helper process;
+     * strict unpack mode requires synchronous removal, though, so that
+     * failures can be reported. */
+#if !defined(_WIN32)
+    if (pyi_ctx->deferred_cleanup && !pyi_ctx->strict_unpack_mode) {
+        PYI_DEBUG("LOADER: scheduling removal of temporary directory: %s\n", pyi_ctx->application_home_dir);
+        cleanup_status = pyi_recursive_rmdir_detached(pyi_ctx->application_home_dir);
+    } else {
+        PYI_DEBUG("LOADER: removing temporary directory: %s\n", pyi_ctx->application_home_dir);
+        cleanup_status = pyi_recursive_rmdir(pyi_ctx->application_home_dir);
+    }
+
+    /* Remove the lock file, and release the lock; the directory has
+     * either been removed, or renamed to tombstone name. If removal
+     * failed, keep the lock file, so that once the lock is released at
+     * process exit, a subsequent sweep can attempt the removal again. */
+    if (cleanup_status == 0) {
+        pyi_unlock_temporary_application_directory(pyi_ctx);
+    }
+#else
     PYI_DEBUG("LOADER: removing temporary directory: %s\n", pyi_ctx->application_home_dir);
     cleanup_status = pyi_recursive_rmdir(pyi_ctx->application_home_dir);
+#endif
 
 #ifdef _WIN32
     /* On Windows, we might fail to remove temporary directory due to
@@ -1239,12 +1411,25 @@ _pyi_main_resolve_executable(struct PYI_CONTEXT *pyi_ctx)
 /**********************************************************************\
  *                      Archive file resolution                       *
 \**********************************************************************/
+/* PKG sideload signature, embedded in the executable: the magic pattern
+ * is followed by the chunk size and the result of the chunked digest of
+ * the PKG file, and the PKG file length (big-endian integers). Must match
+ * the signature written by `PyInstaller.building.api.EXE`. */
+struct PKG_SIDELOAD_SIGNATURE
+{
+    uint32_t chunk_size;
+    uint64_t pkg_length;
+    unsigned char digest[PYI_SHA256_DIGEST_LENGTH];
+};
+
 static int
-_pyi_allow_pkg_sideload(const char *executable)
+_pyi_allow_pkg_sideload(const char *executable, struct PKG_SIDELOAD_SIGNATURE *signature)
 {
     FILE *file = NULL;
     uint64_t magic_offset;
     unsigned char magic[8];
+    unsigned char signature_data[4 + 8 + PYI_SHA256_DIGEST_LENGTH];
+    int i;
 
     /* First, find the PKG sideload signature in the executable */
     file = pyi_path_fopen(executable, "rb");
@@ -1263,15 +1448,55 @@ _pyi_allow_pkg_sideload(const char *executable)
         return 1; /* Error code 1: no embedded PKG sideload signature */
     }
 
-    /* TODO: expand the verification by embedding hash of the PKG file */
+    /* Read the PKG digest that follows the magic pattern */
+    if (pyi_fseek(file, magic_offset + sizeof(magic), SEEK_SET) < 0 || fread(signature_data, sizeof(signature_data), 1, file) < 1) {
+        fclose(file);
+        return 2; /* Error code 2: truncated PKG sideload signature */
+    }
+    fclose(file);
+
+    signature->chunk_size = 0;
+    for (i = 0; i < 4; i++) {
+        signature->chunk_size = (signature->chunk_size << 8) | signature_data[i];
+    }
+    signature->pkg_length = 0;
+    for (i = 0; i < 8; i++) {
+        signature->pkg_length = (signature->pkg_length << 8) | signature_data[4 + i];
+    }
+    memcpy(signature->digest, signature_data + 12, PYI_SHA256_DIGEST_LENGTH);
+
+    /* Allow PKG to be sideloaded, subject to digest verification */
+    return 0;
+}
+
+/*
+ * Verify the side-loaded PKG file against the digest from the sideload
+ * signature, to ensure that the executable runs only the PKG it was built
+ * with. Returns 0 if the PKG matches.
+ */
+static int
+_pyi_verify_pkg_sideload(const char *archive_filename, const struct PKG_SIDELOAD_SIGNATURE *signature)
+{
+    unsigned char digest[PYI_SHA256_DIGEST_LENGTH];
+    uint64_t pkg_length;
+
+    if (pyi_digest_file_chunked(archive_filename, signature->chunk_size, digest, &pkg_length) < 0) {
+        PYI_DEBUG("LOADER: failed to compute digest of PKG file %s!\n", archive_filename);
+        return -1;
+    }
+    if (pkg_length != signature->pkg_length || memcmp(digest, signature->digest, PYI_SHA256_DIGEST_LENGTH) != 0) {
+        PYI_DEBUG("LOADER: digest of PKG file %s does not match the sideload signature!\n", archive_filename);
+        return -1;
+    }
 
-    /* Allow PKG to be sideloaded */
+    PYI_DEBUG("LOADER: digest of PKG file %s matches the sideload signature.\n", archive_filename);
     return 0;
 }
 
 static int
 _pyi_main_resolve_pkg_archive(struct PYI_CONTEXT *pyi_ctx)
 {
+    struct PKG_SIDELOAD_SIGNATURE signature;
     int status;
 
     /* Try opening embedded archive first */
@@ -1286,7 +1511,7 @@ _pyi_main_resolve_pkg_archive(struct PYI_CONTEXT *pyi_ctx)
     PYI_DEBUG("LOADER: failed to open executable-embedded archive!\n");
 
     /* Check if side-load is allowed */
-    status = _pyi_allow_pkg_sideload(pyi_ctx->executable_filename);
+    status = _pyi_allow_pkg_sideload(pyi_ctx->executable_filename, &signature);
     if (status != 0) {
         PYI_DEBUG("LOADER: side-load is disabled (code %d)!\n", status);
         PYI_ERROR(
@@ -1310,6 +1535,15 @@ _pyi_main_resolve_pkg_archive(struct PYI_CONTEXT *pyi_ctx)
 
     PYI_DEBUG("LOADER: trying to load external PKG archive (%s)...\n", pyi_ctx->archive_filename);
 
+    if (_pyi_verify_pkg_sideload(pyi_ctx->archive_filename, &signature) < 0) {
+        PYI_ERROR(
+            "Could not side-load PyInstaller's PKG archive from external file (%s): the file does not match the "
+            "executable!\n",
+            pyi_ctx->archive_filename
+        );
+        return -1;
+    }
+
     pyi_ctx->archive = pyi_archive_open(pyi_ctx->archive_filename);
     if (pyi_ctx->archive == NULL) {
         PYI_ERROR(
@@ -288,6 +288,67 @@ struct PYI_CONTEXT
     unsigned char ignore_signals;
 #endif
 
+    /* Deferred removal of the temporary directory in onefile parent
+     * process (POSIX systems only).
+     *
+     * If this option is specified, the temporary directory is renamed
+     * to a tombstone name and removed by a detached, low-priority helper
+     * process, so the parent process can exit as soon as the child
+     * process exits. Has no effect in strict unpack mode, which requires
+     * synchronous removal in order to report failures. */
+#if !defined(_WIN32)
+    unsigned char deferred_cleanup;
+#endif
+
+    /* Descriptor of the lock file that accompanies the temporary
+     * directory of onefile application (POSIX systems only).
+     *
+     * The onefile parent process holds an advisory lock on this file
+     * for the whole lifetime of the temporary directory; the descriptor
+     * is inherited by the child process, so the lock remains held even
+     * if the parent process is killed. Temporary directories whose lock
+     * file is not locked are considered stale, and are removed by
+     * subsequent instances. A value of 0 means that no lock is held. */
+#if !defined(_WIN32)
+    int application_home_dir_lock_fd;
+#endif
+
+    /* Fast exit mode.
+     *
+     * If this option is specified, the process running the python
+     * interpreter terminates immediately after running the atexit
+     * handlers and flushing the standard streams, without finalizing
+     * the python interpreter. */
+    unsigned char fast_exit;
+
+    /* Batched extraction via io_uring (Linux only).
+     *
+     * If this option is specified, the onefile parent process extracts
+     * the files using io_uring, if it is available; otherwise, the
+     * synchronous extraction path is used. */
+#if defined(__linux__)
+    unsigned char io_uring_extraction;
+#endif
+
+    /* Onefile exec waiter mode (POSIX only).
+     *
+     * If this option is specified, the onefile parent process replaces
+     * itself with a minimal waiter process (a fresh instance of the
+     * executable) after starting the child process; the waiter forwards
+     * the signals to the child process, and performs the cleanup after
+     * the child process exits. */
+#if !defined(_WIN32)
+    unsigned char onefile_exec_waiter;
+#endif
+
+    /* Usage recorder.
+     *
+     * If this option is specified, the PYINSTALLER_USAGE_PROFILE
+     * environment variable enables the recording of modules and files
+     * that are used by the application (see pyimod02_importers). The
+     * option is signalled to python code via sys._pyi_usage_recorder. */
+    unsigned char usage_recorder;
+
     /**
      * Flag indicating that colleted python shared library was built
      * with --disable-gil / Py_GIL_DISABLED. Used to select correct
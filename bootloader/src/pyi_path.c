@@ -21,12 +21,14 @@
 #ifdef _WIN32
     #include <windows.h>
     #include <wchar.h>
+    #include <fcntl.h>  /* _O_BINARY */
+    #include <io.h>  /* _wopen */
     #ifdef __GNUC__
         #include <libgen.h> /* basename(), dirname() */
     #endif /* __GNUC__ */
 #else /* _WIN32 */
     #include <libgen.h>  /* basename(), dirnmae() */
-    #include <unistd.h>  /* unlink(), symlink() */
+    #include <unistd.h>  /* unlink(), symlink(), link() */
 #endif /* _WIN32 */
 
 #include <stdio.h>  /* FILE, fopen */
@@ -184,6 +186,19 @@ pyi_path_fopen(const char* filename, const char* mode)
     pyi_win32_utf8_to_wcs(mode, wmode, 10);
     return _wfopen(wfilename, wmode);
 }
+
+/*
+ * Multiplatform wrapper around function open(). On Windows, the file is
+ * always opened in binary mode.
+ */
+int
+pyi_path_open(const char *filename, int flags, int mode)
+{
+    wchar_t wfilename[PYI_PATH_MAX];
+
+    pyi_win32_utf8_to_wcs(filename, wfilename, PYI_PATH_MAX);
+    return _wopen(wfilename, flags | _O_BINARY, mode);
+}
 #endif
 
 bool
@@ -243,3 +258,28 @@ pyi_path_mksymlink(const char *link_target, const char *link_name)
     return symlink(link_target, link_name);
 #endif
 }
+
+/*
+ * Create hard link.
+ */
+int
+pyi_path_mkhardlink(const char *existing_name, const char *link_name)
+{
+#ifdef _WIN32
+    wchar_t wexisting_name[PYI_PATH_MAX];
+    wchar_t wlink_name[PYI_PATH_MAX];
+
+    if (!pyi_win32_utf8_to_wcs(existing_name, wexisting_name, PYI_PATH_MAX)) {
+        return -1;
+    }
+    if (!pyi_win32_utf8_to_wcs(link_name, wlink_name, PYI_PATH_MAX)) {
+        return -1;
+    }
+    if (CreateHardLinkW(wlink_name, wexisting_name, NULL) == 0) {
+        return -1;
+    }
+    return 0;
+#else
+    return link(existing_name, link_name);
+#endif
+}
@@ -35,10 +35,13 @@ bool pyi_path_is_symlink(const char *path);
 
 #ifdef _WIN32
 FILE *pyi_path_fopen(const char *filename, const char *mode);
+int pyi_path_open(const char *filename, int flags, int mode);
 #else
 #define pyi_path_fopen(x, y) fopen(x, y)
+#define pyi_path_open(x, y, z) open(x, y, z)
 #endif
 
 int pyi_path_mksymlink(const char *link_target, const char *link_name);
+int pyi_path_mkhardlink(const char *existing_name, const char *link_name);
 
 #endif /* PYI_PATH_H */
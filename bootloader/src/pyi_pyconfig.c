@@ -142,7 +142,10 @@ pyi_runtime_options_read(const struct PYI_CONTEXT *pyi_ctx)
 {
     struct PyiRuntimeOptions *options;
     const struct ARCHIVE *archive = pyi_ctx->archive;
+    const struct TOC_ENTRY *const *option_entries;
     const struct TOC_ENTRY *toc_entry;
+    uint32_t num_options;
+    uint32_t i;
     int num_wflags = 0;
     int num_xflags = 0;
     int failed = 0;
@@ -155,14 +158,13 @@ pyi_runtime_options_read(const struct PYI_CONTEXT *pyi_ctx)
 
     options->utf8_mode = -1; /* default: auto-select based on locale */
 
-    /* Parse run-time options from PKG archive */
-    for (toc_entry = archive->toc; toc_entry < archive->toc_end; toc_entry = pyi_archive_next_toc_entry(archive, toc_entry)) {
+    /* Parse run-time options from PKG archive; we are only interested
+     * in OPTION entries */
+    option_entries = pyi_archive_get_entries_by_typecode(archive, ARCHIVE_ITEM_RUNTIME_OPTION, &num_options);
+    for (i = 0; i < num_options; i++) {
         const char *value_str;
 
-        /* We are only interested in OPTION entries */
-        if (toc_entry->typecode != ARCHIVE_ITEM_RUNTIME_OPTION) {
-            continue;
-        }
+        toc_entry = option_entries[i];
 
         /* Skip bootloader options; these start with "pyi-" */
         if (strncmp(toc_entry->name, "pyi-", 4) == 0) {
@@ -222,11 +224,8 @@ pyi_runtime_options_read(const struct PYI_CONTEXT *pyi_ctx)
     }
 
     /* Collect */
-    for (toc_entry = archive->toc; toc_entry < archive->toc_end; toc_entry = pyi_archive_next_toc_entry(archive, toc_entry)) {
-        /* We are only interested in OPTION entries */
-        if (toc_entry->typecode != ARCHIVE_ITEM_RUNTIME_OPTION) {
-            continue;
-        }
+    for (i = 0; i < num_options; i++) {
+        toc_entry = option_entries[i];
 
         if (strncmp(toc_entry->name, "W ", 2) == 0) {
             /* Copy for pass-through */
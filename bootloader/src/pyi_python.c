@@ -39,7 +39,10 @@ PYI_DECLPROC(PyConfig_SetBytesString)
 PYI_DECLPROC(PyConfig_SetString)
 PYI_DECLPROC(PyConfig_SetWideStringList)
 
+PYI_DECLPROC(PyCFunction_NewEx)
+
 PYI_DECLPROC(PyErr_Clear)
+PYI_DECLPROC(PyErr_ExceptionMatches)
 PYI_DECLPROC(PyErr_Fetch)
 PYI_DECLPROC(PyErr_NormalizeException)
 PYI_DECLPROC(PyErr_Occurred)
@@ -52,6 +55,9 @@ PYI_DECLPROC(PyImport_AddModule)
 PYI_DECLPROC(PyImport_ExecCodeModule)
 PYI_DECLPROC(PyImport_ImportModule)
 
+PYI_DECLPROC(PyLong_AsLong)
+PYI_DECLPROC(PyLong_FromLong)
+
 PYI_DECLPROC(PyMarshal_ReadObjectFromString)
 
 PYI_DECLPROC(PyMem_RawFree)
@@ -103,7 +109,10 @@ pyi_python_bind_functions(pyi_dylib_t dll, int python_version)
     PYI_GETPROC(dll, PyConfig_SetString)
     PYI_GETPROC(dll, PyConfig_SetWideStringList)
 
+    PYI_GETPROC(dll, PyCFunction_NewEx)
+
     PYI_GETPROC(dll, PyErr_Clear)
+    PYI_GETPROC(dll, PyErr_ExceptionMatches)
     PYI_GETPROC(dll, PyErr_Fetch)
     PYI_GETPROC(dll, PyErr_NormalizeException)
     PYI_GETPROC(dll, PyErr_Occurred)
@@ -116,6 +125,9 @@ pyi_python_bind_functions(pyi_dylib_t dll, int python_version)
     PYI_GETPROC(dll, PyImport_ExecCodeModule)
     PYI_GETPROC(dll, PyImport_ImportModule)
 
+    PYI_GETPROC(dll, PyLong_AsLong)
+    PYI_GETPROC(dll, PyLong_FromLong)
+
     PYI_GETPROC(dll, PyMarshal_ReadObjectFromString)
 
     PYI_GETPROC(dll, PyMem_RawFree)
@@ -152,6 +152,24 @@ typedef struct _PyPreConfig PyPreConfig;
 typedef struct _PyConfig PyConfig;
 
 
+/* Method definition structure, used to expose bootloader-provided
+ * functions to python code. Its layout is part of the stable ABI. We
+ * use only the METH_FASTCALL calling convention, which is available in
+ * all supported python versions and does not require argument parsing
+ * functions.
+ */
+typedef PyObject *(*PyCFunction)(PyObject *, PyObject *);
+
+typedef struct {
+    const char *ml_name;
+    PyCFunction ml_meth;
+    int ml_flags;
+    const char *ml_doc;
+} PyMethodDef;
+
+#define METH_FASTCALL 0x0080
+
+
 /* Py_ */
 PYI_EXTDECLPROC(void, Py_DecRef, (PyObject *))
 PYI_EXTDECLPROC(wchar_t *, Py_DecodeLocale, (const char *, size_t *))
@@ -169,8 +187,12 @@ PYI_EXTDECLPROC(PyStatus, PyConfig_SetBytesString, (PyConfig *, wchar_t **, cons
 PYI_EXTDECLPROC(PyStatus, PyConfig_SetString, (PyConfig *, wchar_t **, const wchar_t *))
 PYI_EXTDECLPROC(PyStatus, PyConfig_SetWideStringList, (PyConfig *, PyWideStringList *, Py_ssize_t, wchar_t **))
 
+/* PyCFunction_ */
+PYI_EXTDECLPROC(PyObject *, PyCFunction_NewEx, (PyMethodDef *, PyObject *, PyObject *))
+
 /* PyErr_ */
 PYI_EXTDECLPROC(void, PyErr_Clear, (void) )
+PYI_EXTDECLPROC(int, PyErr_ExceptionMatches, (PyObject *))
 PYI_EXTDECLPROC(void, PyErr_Fetch, (PyObject **, PyObject **, PyObject **))
 PYI_EXTDECLPROC(void, PyErr_NormalizeException, (PyObject **, PyObject **, PyObject **))
 PYI_EXTDECLPROC(PyObject *, PyErr_Occurred, (void) )
@@ -185,6 +207,10 @@ PYI_EXTDECLPROC(PyObject *, PyImport_AddModule, (const char *))
 PYI_EXTDECLPROC(PyObject *, PyImport_ExecCodeModule, (const char *, PyObject *))
 PYI_EXTDECLPROC(PyObject *, PyImport_ImportModule, (const char *))
 
+/* PyLong_ */
+PYI_EXTDECLPROC(long, PyLong_AsLong, (PyObject *))
+PYI_EXTDECLPROC(PyObject *, PyLong_FromLong, (long))
+
 /* PyMarshal_ */
 PYI_EXTDECLPROC(PyObject *, PyMarshal_ReadObjectFromString, (const char *, Py_ssize_t))
 
@@ -19,9 +19,11 @@
 
 #ifdef _WIN32
     #include <windows.h> /* HMODULE */
+    #include <stdlib.h>  /* _exit */
 #else
     #include <dlfcn.h>  /* dlerror */
     #include <stdlib.h>  /* mbstowcs */
+    #include <unistd.h>  /* _exit */
 #endif /* ifdef _WIN32 */
 #include <stddef.h>  /* ptrdiff_t */
 #include <stdio.h>
@@ -324,10 +326,65 @@ pyi_pylib_import_modules(const struct PYI_CONTEXT *pyi_ctx)
     return 0;
 }
 
+/*
+ * Decode the given filename into Python string.
+ */
+static PyObject *
+_pyi_pylib_decode_filename(const char *filename)
+{
+#ifdef _WIN32
+    /* Decode UTF-8 to PyUnicode */
+    return PI_PyUnicode_Decode(filename, strlen(filename), "utf-8", "strict");
+#else
+    /* Decode locale-encoded filename to PyUnicode object using Python's
+     * preferred decoding method for filenames. */
+    return PI_PyUnicode_DecodeFSDefault(filename);
+#endif
+}
+
+/*
+ * Look up the reference to the PYZ archive that is shared by multiple
+ * executables from a MERGE-d multi-package suite (type 'y'), and format
+ * the full path to it. The reference is stored as path relative to the
+ * parent directory of the executable. Returns 1 if the reference was
+ * found, 0 if there is no reference, and -1 on error.
+ */
+static int
+_pyi_pylib_find_shared_pyz(const struct PYI_CONTEXT *pyi_ctx, char *shared_pyz_path)
+{
+    const struct ARCHIVE *archive = pyi_ctx->archive;
+    const struct TOC_ENTRY *toc_entry;
+    char executable_dir[PYI_PATH_MAX];
+
+    for (toc_entry = archive->toc; toc_entry < archive->toc_end; toc_entry = pyi_archive_next_toc_entry(archive, toc_entry)) {
+        if (toc_entry->typecode == ARCHIVE_ITEM_SHARED_PYZ) {
+            break;
+        }
+    }
+    if (toc_entry >= archive->toc_end) {
+        return 0;
+    }
+
+    pyi_path_dirname(executable_dir, pyi_ctx->executable_filename);
+    if (snprintf(shared_pyz_path, PYI_PATH_MAX, "%s%c%s", executable_dir, PYI_SEP, toc_entry->name) >= PYI_PATH_MAX) {
+        PYI_ERROR("Path to shared PYZ archive %s exceeds PYI_PATH_MAX limit.\n", toc_entry->name);
+        return -1;
+    }
+    if (!pyi_path_exists(shared_pyz_path)) {
+        PYI_ERROR("Shared PYZ archive %s not found!\n", shared_pyz_path);
+        return -1;
+    }
+
+    return 1;
+}
+
 /*
  * Store path and offset to PYZ archive into sys._pyinstaller_pyz
  * attribute, so that our bootstrap python script can set up PYZ
- * archive reader.
+ * archive reader. If the executable references a shared PYZ archive
+ * (see MERGE), its path is appended, separated by a NUL character;
+ * the archive reader chains the TOC of the shared archive after the
+ * TOC of the executable's own archive.
  */
 int
 pyi_pylib_install_pyz(const struct PYI_CONTEXT *pyi_ctx)
@@ -337,6 +394,7 @@ pyi_pylib_install_pyz(const struct PYI_CONTEXT *pyi_ctx)
     PyObject *archive_filename_obj;
     PyObject *pyz_path_obj;
     unsigned long long pyz_offset;
+    char shared_pyz_path[PYI_PATH_MAX];
     int rc;
     const char *attr_name = "_pyinstaller_pyz";
 
@@ -354,14 +412,7 @@ pyi_pylib_install_pyz(const struct PYI_CONTEXT *pyi_ctx)
     }
 
     /* Store archive filename as Python string. */
-#ifdef _WIN32
-    /* Decode UTF-8 to PyUnicode */
-    archive_filename_obj = PI_PyUnicode_Decode(pyi_ctx->archive_filename, strlen(pyi_ctx->archive_filename), "utf-8", "strict");
-#else
-    /* Decode locale-encoded filename to PyUnicode object using Python's
-     * preferred decoding method for filenames. */
-    archive_filename_obj = PI_PyUnicode_DecodeFSDefault(pyi_ctx->archive_filename);
-#endif
+    archive_filename_obj = _pyi_pylib_decode_filename(pyi_ctx->archive_filename);
 
     /* Format name plus offset; here, we assume that python's %llu format
      * matches the platform's definition of "unsigned long long". Of
@@ -376,6 +427,33 @@ pyi_pylib_install_pyz(const struct PYI_CONTEXT *pyi_ctx)
         return -1;
     }
 
+    /* Append the path to shared PYZ archive, if applicable. */
+    rc = _pyi_pylib_find_shared_pyz(pyi_ctx, shared_pyz_path);
+    if (rc < 0) {
+        PI_Py_DecRef(pyz_path_obj);
+        return -1;
+    } else if (rc > 0) {
+        PyObject *shared_pyz_path_obj;
+        PyObject *combined_path_obj;
+
+        PYI_DEBUG("LOADER: using shared PYZ archive: %s\n", shared_pyz_path);
+
+        shared_pyz_path_obj = _pyi_pylib_decode_filename(shared_pyz_path);
+        if (shared_pyz_path_obj == NULL) {
+            combined_path_obj = NULL;
+        } else {
+            combined_path_obj = PI_PyUnicode_FromFormat("%U%c%U", pyz_path_obj, 0, shared_pyz_path_obj);
+            PI_Py_DecRef(shared_pyz_path_obj);
+        }
+        PI_Py_DecRef(pyz_path_obj);
+
+        if (combined_path_obj == NULL) {
+            PYI_ERROR("Failed to format shared PYZ archive path\n");
+            return -1;
+        }
+        pyz_path_obj = combined_path_obj;
+    }
+
     /* Store into sys._pyinstaller_pyz */
     rc = PI_PySys_SetObject(attr_name, pyz_path_obj);
     PI_Py_DecRef(pyz_path_obj);
@@ -389,6 +467,221 @@ pyi_pylib_install_pyz(const struct PYI_CONTEXT *pyi_ctx)
     return 0;
 }
 
+/*
+ * Extraction service for on-demand binaries (type 'e'), exposed to
+ * python code as sys._pyi_extract_lazy_binary(name, filename). Extracts
+ * the archive entry with given name into the given file, whose path is
+ * relative to the application's top-level directory. The caller (our
+ * PyiFrozenFinder) is responsible for creating the parent directory
+ * and for moving the file into its final location. Returns 0 on success
+ * and -1 on failure.
+ */
+static PyObject *
+_pyi_pylib_extract_lazy_binary(PyObject *self, PyObject *const *args, Py_ssize_t nargs)
+{
+    const struct PYI_CONTEXT *pyi_ctx = global_pyi_ctx;
+    const struct TOC_ENTRY *const *toc_entries;
+    const struct TOC_ENTRY *toc_entry = NULL;
+    uint32_t num_entries;
+    uint32_t i;
+    const char *entry_name;
+    const char *filename;
+    char output_filename[PYI_PATH_MAX];
+
+    (void)self; /* unused */
+
+    if (nargs != 2) {
+        return PI_PyLong_FromLong(-1);
+    }
+
+    entry_name = PI_PyUnicode_AsUTF8(args[0]);
+    filename = PI_PyUnicode_AsUTF8(args[1]);
+    if (entry_name == NULL || filename == NULL) {
+        PI_PyErr_Clear();
+        return PI_PyLong_FromLong(-1);
+    }
+
+    toc_entries = pyi_archive_get_entries_by_typecode(pyi_ctx->archive, ARCHIVE_ITEM_LAZY_BINARY, &num_entries);
+    for (i = 0; i < num_entries; i++) {
+        if (strcmp(toc_entries[i]->name, entry_name) == 0) {
+            toc_entry = toc_entries[i];
+            break;
+        }
+    }
+    if (toc_entry == NULL) {
+        PYI_WARNING("On-demand binary %s not found in the archive!\n", entry_name);
+        return PI_PyLong_FromLong(-1);
+    }
+
+    if (snprintf(output_filename, PYI_PATH_MAX, "%s%c%s", pyi_ctx->application_home_dir, PYI_SEP, filename) >= PYI_PATH_MAX) {
+        PYI_WARNING("Extraction path length exceeds maximum path length!\n");
+        return PI_PyLong_FromLong(-1);
+    }
+
+    PYI_DEBUG("LOADER: extracting on-demand binary %s...\n", entry_name);
+    if (pyi_archive_extract2fs(pyi_ctx->archive, toc_entry, output_filename) < 0) {
+        return PI_PyLong_FromLong(-1);
+    }
+
+    return PI_PyLong_FromLong(0);
+}
+
+static PyMethodDef _pyi_pylib_extract_lazy_binary_def = {
+    "_pyi_extract_lazy_binary",
+    (PyCFunction)(void (*)(void))_pyi_pylib_extract_lazy_binary,
+    METH_FASTCALL,
+    NULL
+};
+
+/*
+ * Unmarshal the given index entry (type 'i') and store it into the sys
+ * module, under the attribute name that is derived from the entry name
+ * (for example, pyi-lazy-binaries -> sys._pyi_lazy_binaries).
+ */
+static int
+_pyi_pylib_install_index(const struct ARCHIVE *archive, const struct TOC_ENTRY *toc_entry)
+{
+    char attr_name[64];
+    char *p;
+    unsigned char *index_data;
+    PyObject *index_obj;
+    int rc;
+
+    if (snprintf(attr_name, sizeof(attr_name), "_%s", toc_entry->name) >= (int)sizeof(attr_name)) {
+        PYI_ERROR("Name of archive index entry %s is too long!\n", toc_entry->name);
+        return -1;
+    }
+    for (p = attr_name; *p; p++) {
+        if (*p == '-') {
+            *p = '_';
+        }
+    }
+
+    index_data = pyi_archive_extract(archive, toc_entry);
+    if (index_data == NULL) {
+        PYI_ERROR("Failed to extract archive index entry %s!\n", toc_entry->name);
+        return -1;
+    }
+    index_obj = PI_PyMarshal_ReadObjectFromString((const char *)index_data, (Py_ssize_t)toc_entry->uncompressed_length);
+    free(index_data);
+    if (index_obj == NULL) {
+        PYI_ERROR("Failed to unmarshal archive index entry %s!\n", toc_entry->name);
+        PI_PyErr_Print();
+        return -1;
+    }
+
+    rc = PI_PySys_SetObject(attr_name, index_obj);
+    PI_Py_DecRef(index_obj);
+    if (rc != 0) {
+        PYI_ERROR("Failed to store archive index entry %s into sys.%s!\n", toc_entry->name, attr_name);
+        return -1;
+    }
+
+    PYI_DEBUG("LOADER: archive index entry %s stored into sys.%s\n", toc_entry->name, attr_name);
+    return 0;
+}
+
+/*
+ * If the archive contains entries that are not extracted by the onefile
+ * parent process (on-demand binaries and data files, i.e., the
+ * application was built with `lazy_extensions` or `lazy_data` option),
+ * store their indices into the sys module, along with the path and the
+ * offset of the PKG archive (sys._pyi_archive, in the same format as
+ * sys._pyinstaller_pyz), and the extraction function for on-demand
+ * binaries (sys._pyi_extract_lazy_binary). These are picked up by the
+ * pyimod02_importers module, which extracts or reads the entries when
+ * they are needed.
+ */
+int
+pyi_pylib_install_lazy_entries(const struct PYI_CONTEXT *pyi_ctx)
+{
+    const struct TOC_ENTRY *const *toc_entries;
+    uint32_t num_entries;
+    uint32_t i;
+    PyObject *archive_filename_obj;
+    PyObject *archive_path_obj;
+    PyObject *func_obj;
+    int rc;
+
+    toc_entries = pyi_archive_get_entries_by_typecode(pyi_ctx->archive, ARCHIVE_ITEM_LAZY_INDEX, &num_entries);
+    if (num_entries == 0) {
+        return 0;
+    }
+
+    PYI_DEBUG("LOADER: setting up on-demand access to archive entries...\n");
+
+    for (i = 0; i < num_entries; i++) {
+        if (_pyi_pylib_install_index(pyi_ctx->archive, toc_entries[i]) < 0) {
+            return -1;
+        }
+    }
+
+    /* Store path to and offset of the PKG archive */
+#ifdef _WIN32
+    archive_filename_obj = PI_PyUnicode_Decode(pyi_ctx->archive_filename, strlen(pyi_ctx->archive_filename), "utf-8", "strict");
+#else
+    archive_filename_obj = PI_PyUnicode_DecodeFSDefault(pyi_ctx->archive_filename);
+#endif
+    archive_path_obj = PI_PyUnicode_FromFormat("%U?%llu", archive_filename_obj, (unsigned long long)pyi_ctx->archive->pkg_offset);
+    PI_Py_DecRef(archive_filename_obj);
+    if (archive_path_obj == NULL) {
+        PYI_ERROR("Failed to format PKG archive path and offset\n");
+        return -1;
+    }
+
+    rc = PI_PySys_SetObject("_pyi_archive", archive_path_obj);
+    PI_Py_DecRef(archive_path_obj);
+    if (rc != 0) {
+        PYI_ERROR("Failed to store path to PKG archive into sys._pyi_archive!\n");
+        return -1;
+    }
+
+    /* Store the extraction function for on-demand binaries */
+    func_obj = PI_PyCFunction_NewEx(&_pyi_pylib_extract_lazy_binary_def, NULL, NULL);
+    if (func_obj == NULL) {
+        PYI_ERROR("Failed to create the extraction function for on-demand binaries!\n");
+        return -1;
+    }
+
+    rc = PI_PySys_SetObject("_pyi_extract_lazy_binary", func_obj);
+    PI_Py_DecRef(func_obj);
+    if (rc != 0) {
+        PYI_ERROR("Failed to store the extraction function into sys._pyi_extract_lazy_binary!\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Signal to the pyimod02_importers module that the application was built
+ * with the usage recorder (the `usage_recorder` option of EXE), by
+ * storing sys._pyi_usage_recorder. Without it, the importer ignores the
+ * PYINSTALLER_USAGE_PROFILE environment variable.
+ */
+int
+pyi_pylib_enable_usage_recorder(const struct PYI_CONTEXT *pyi_ctx)
+{
+    PyObject *flag_obj;
+    int rc;
+
+    (void)pyi_ctx;
+
+    flag_obj = PI_PyLong_FromLong(1);
+    if (flag_obj == NULL) {
+        return -1;
+    }
+
+    rc = PI_PySys_SetObject("_pyi_usage_recorder", flag_obj);
+    PI_Py_DecRef(flag_obj);
+    if (rc != 0) {
+        PYI_ERROR("Failed to store sys._pyi_usage_recorder!\n");
+        return -1;
+    }
+
+    return 0;
+}
+
 void
 pyi_pylib_finalize(const struct PYI_CONTEXT *pyi_ctx)
 {
@@ -429,3 +722,79 @@ pyi_pylib_finalize(const struct PYI_CONTEXT *pyi_ctx)
     PYI_DEBUG("LOADER: cleaning up Python interpreter...\n");
     PI_Py_Finalize();
 }
+
+/*
+ * Fast exit: run the clean-up that is observable by the application
+ * (waiting for non-daemon threads, atexit handlers, flushing of standard
+ * streams), and terminate the process without finalizing the Python
+ * interpreter. Tearing down all modules can take considerable time in
+ * large applications, while the resources are reclaimed by the OS anyway.
+ *
+ * If the script raised SystemExit, the exception object is expected in
+ * sys._pyi_system_exit, and the exit code is derived from it in the same
+ * way as the python interpreter does it; otherwise, the given exit code
+ * is used.
+ *
+ * Does not return, unless python interpreter is not initialized.
+ */
+static const char _pyi_fast_exit_code[] =
+    "import sys\n"
+    "def _pyi_fast_exit(status):\n"
+    "    exc = sys.__dict__.pop('_pyi_system_exit', None)\n"
+    "    if exc is not None:\n"
+    "        if exc.code is None:\n"
+    "            status = 0\n"
+    "        elif isinstance(exc.code, int):\n"
+    "            status = exc.code\n"
+    "        else:\n"
+    "            try:\n"
+    "                print(exc.code, file=sys.stderr)\n"
+    "            except Exception:\n"
+    "                pass\n"
+    "            status = 1\n"
+    "    threading = sys.modules.get('threading')\n"
+    "    if threading is not None:\n"
+    "        threading._shutdown()\n"
+    "    import atexit\n"
+    "    atexit._run_exitfuncs()\n"
+    "    for stream in (sys.stdout, sys.stderr, sys.__stdout__, sys.__stderr__):\n"
+    "        try:\n"
+    "            stream.flush()\n"
+    "        except Exception:\n"
+    "            pass\n"
+    "    sys._pyi_exit_status = status\n"
+    "_pyi_fast_exit(%d)\n"
+    "del _pyi_fast_exit\n";
+
+void
+pyi_pylib_fast_exit(const struct PYI_CONTEXT *pyi_ctx, int status)
+{
+    char code[sizeof(_pyi_fast_exit_code) + 16];
+    PyObject *status_obj;
+    long status_value;
+
+    if (!pyi_ctx->python_symbols_loaded) {
+        return;
+    }
+    if (PI_Py_IsInitialized() == 0) {
+        return;
+    }
+
+    PYI_DEBUG("LOADER: fast exit: running atexit handlers and flushing streams...\n");
+    snprintf(code, sizeof(code), _pyi_fast_exit_code, status);
+    if (PI_PyRun_SimpleStringFlags(code, NULL) == 0) {
+        status_obj = PI_PySys_GetObject("_pyi_exit_status"); /* borrowed reference */
+        if (status_obj) {
+            status_value = PI_PyLong_AsLong(status_obj);
+            if (status_value == -1 && PI_PyErr_Occurred()) {
+                PI_PyErr_Clear();
+            }
+            status = (int)status_value;
+        }
+    }
+
+    PYI_DEBUG("LOADER: fast exit: terminating process with exit code %d, without finalizing Python interpreter.\n", status);
+    fflush(stdout);
+    fflush(stderr);
+    _exit(status);
+}
@@ -24,8 +24,11 @@ int pyi_pylib_load(struct PYI_CONTEXT *pyi_ctx);
 int pyi_pylib_start_python(const struct PYI_CONTEXT *pyi_ctx);
 int pyi_pylib_import_modules(const struct PYI_CONTEXT *pyi_ctx);
 int pyi_pylib_install_pyz(const struct PYI_CONTEXT *pyi_ctx);
+int pyi_pylib_install_lazy_entries(const struct PYI_CONTEXT *pyi_ctx);
+int pyi_pylib_enable_usage_recorder(const struct PYI_CONTEXT *pyi_ctx);
 int pyi_pylib_run_scripts(const struct PYI_CONTEXT *pyi_ctx);
 
 void pyi_pylib_finalize(const struct PYI_CONTEXT *pyi_ctx);
+void pyi_pylib_fast_exit(const struct PYI_CONTEXT *pyi_ctx, int status);
 
 #endif /* PYI_PYTHONLIB_H */
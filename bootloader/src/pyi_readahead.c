@@ -0,0 +1,228 @@
+/*
+ * ****************************************************************************
+ * Copyright (c) 2013-2023, PyInstaller Development Team.
+ *
+ * Distributed under the terms of the GNU General Public License (version 2
+ * or later) with exception for distributing the bootloader.
+ *
+ * The full license is in the file COPYING.txt, distributed with this software.
+ *
+ * SPDX-License-Identifier: (GPL-2.0-or-later WITH Bootloader-exception)
+ * ****************************************************************************
+ */
+
+/*
+ * Background warm-up of page cache for bundled shared libraries.
+ *
+ * The first load of a large extension module (or of the shared library
+ * it links against) page-faults its whole mapping from disk, synchronously,
+ * on the import path. The list of such libraries is determined at build
+ * time and passed to bootloader via `pyi-readahead <name>` run-time
+ * options; once python shared library is loaded, a low-priority thread
+ * reads the listed files into page cache, while the main thread
+ * initializes the python interpreter and runs the bootstrap imports.
+ */
+
+#if defined(__linux__)
+    #define _GNU_SOURCE  /* readahead */
+#endif
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <io.h>  /* _read, _close */
+#else
+    #include <pthread.h>
+    #include <unistd.h>  /* read, close */
+    #include <sys/stat.h>  /* fstat */
+#endif
+#if defined(__linux__)
+    #include <sys/resource.h>  /* setpriority */
+    #include <sys/syscall.h>  /* SYS_gettid */
+#endif
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* PyInstaller headers. */
+#include "pyi_global.h"
+#include "pyi_archive.h"
+#include "pyi_main.h"
+#include "pyi_path.h"
+#include "pyi_readahead.h"
+
+/* Size of buffer used to read files on platforms without readahead(). */
+#define READAHEAD_BUFFER_SIZE (1024 * 1024)
+
+/* The list of files to warm up, owned by the readahead thread. The
+ * paths are stored one after another, each NULL-terminated. */
+struct READAHEAD_JOB
+{
+    size_t num_files;
+    char paths[1];
+};
+
+
+/*
+ * Read the file into page cache; any errors are ignored, as the file
+ * is going to be loaded (or not) by the main thread anyway.
+ */
+static void
+_pyi_readahead_file(const char *path, char *buffer)
+{
+    int fd;
+
+    fd = pyi_path_open(path, O_RDONLY, 0);
+    if (fd < 0) {
+        PYI_DEBUG("LOADER: readahead: could not open %s\n", path);
+        return;
+    }
+
+#if defined(__linux__)
+    if (1) {
+        struct stat statbuf;
+        (void)buffer;
+        if (fstat(fd, &statbuf) == 0) {
+            readahead(fd, 0, (size_t)statbuf.st_size);
+        }
+    }
+#elif defined(_WIN32)
+    while (_read(fd, buffer, READAHEAD_BUFFER_SIZE) > 0) {
+    }
+#else
+    while (read(fd, buffer, READAHEAD_BUFFER_SIZE) > 0) {
+    }
+#endif
+
+#ifdef _WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+}
+
+static void
+_pyi_readahead_run(struct READAHEAD_JOB *job)
+{
+    const char *path = job->paths;
+    char *buffer = NULL;
+    size_t i;
+
+    /* Lower the priority of the thread (the whole point is to make use
+     * of otherwise idle I/O, not to compete with the main thread). On
+     * Linux, the nice value is a per-thread attribute. */
+#if defined(_WIN32)
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#elif defined(__linux__)
+    setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 19);
+#endif
+
+#if !defined(__linux__)
+    buffer = malloc(READAHEAD_BUFFER_SIZE);
+    if (buffer == NULL) {
+        free(job);
+        return;
+    }
+#endif
+
+    for (i = 0; i < job->num_files; i++) {
+        PYI_DEBUG("LOADER: readahead: %s\n", path);
+        _pyi_readahead_file(path, buffer);
+        path += strlen(path) + 1;
+    }
+
+    free(buffer);
+    free(job);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI
+_pyi_readahead_thread(LPVOID arg)
+{
+    _pyi_readahead_run((struct READAHEAD_JOB *)arg);
+    return 0;
+}
+#else
+static void *
+_pyi_readahead_thread(void *arg)
+{
+    _pyi_readahead_run((struct READAHEAD_JOB *)arg);
+    return NULL;
+}
+#endif
+
+/*
+ * Start a detached, low-priority thread that reads the files listed
+ * by `pyi-readahead` run-time options into page cache. The file names
+ * are relative to application's top-level directory. Returns 0 on
+ * success (or if there is nothing to do), and -1 if the thread could
+ * not be started; the latter is not considered a fatal error.
+ */
+int
+pyi_readahead_start(const struct PYI_CONTEXT *pyi_ctx)
+{
+    const struct TOC_ENTRY *const *option_entries;
+    uint32_t num_options;
+    struct READAHEAD_JOB *job;
+    size_t job_size = sizeof(struct READAHEAD_JOB);
+    size_t home_dir_len = strlen(pyi_ctx->application_home_dir);
+    char *path;
+    uint32_t i;
+
+    /* Compute the size of the job structure */
+    option_entries = pyi_archive_get_entries_by_typecode(pyi_ctx->archive, ARCHIVE_ITEM_RUNTIME_OPTION, &num_options);
+    for (i = 0; i < num_options; i++) {
+        const char *name = option_entries[i]->name;
+        if (strncmp(name, "pyi-readahead ", 14) == 0) {
+            job_size += home_dir_len + 1 + strlen(name + 14) + 1;
+        }
+    }
+    if (job_size == sizeof(struct READAHEAD_JOB)) {
+        return 0;
+    }
+
+    job = calloc(1, job_size);
+    if (job == NULL) {
+        return -1;
+    }
+
+    /* Store full paths */
+    path = job->paths;
+    for (i = 0; i < num_options; i++) {
+        const char *name = option_entries[i]->name;
+        if (strncmp(name, "pyi-readahead ", 14) == 0) {
+            path += sprintf(path, "%s%c%s", pyi_ctx->application_home_dir, PYI_SEP, name + 14) + 1;
+            job->num_files++;
+        }
+    }
+
+    PYI_DEBUG("LOADER: starting readahead thread for %d file(s)...\n", (int)job->num_files);
+
+#ifdef _WIN32
+    if (1) {
+        HANDLE thread = CreateThread(NULL, 0, _pyi_readahead_thread, job, 0, NULL);
+        if (thread == NULL) {
+            free(job);
+            return -1;
+        }
+        CloseHandle(thread);
+    }
+#else
+    if (1) {
+        pthread_t thread;
+        pthread_attr_t attr;
+        int rc;
+
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        rc = pthread_create(&thread, &attr, _pyi_readahead_thread, job);
+        pthread_attr_destroy(&attr);
+        if (rc != 0) {
+            free(job);
+            return -1;
+        }
+    }
+#endif
+
+    return 0;
+}
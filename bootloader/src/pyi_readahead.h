@@ -0,0 +1,25 @@
+/*
+ * ****************************************************************************
+ * Copyright (c) 2013-2023, PyInstaller Development Team.
+ *
+ * Distributed under the terms of the GNU General Public License (version 2
+ * or later) with exception for distributing the bootloader.
+ *
+ * The full license is in the file COPYING.txt, distributed with this software.
+ *
+ * SPDX-License-Identifier: (GPL-2.0-or-later WITH Bootloader-exception)
+ * ****************************************************************************
+ */
+
+/*
+ * Background warm-up of page cache for bundled shared libraries.
+ */
+
+#ifndef PYI_READAHEAD_H
+#define PYI_READAHEAD_H
+
+struct PYI_CONTEXT;
+
+int pyi_readahead_start(const struct PYI_CONTEXT *pyi_ctx);
+
+#endif /* PYI_READAHEAD_H */
@@ -17,6 +17,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifndef _WIN32
+    #include <time.h>  /* clock_gettime */
+#endif
 
 /* PyInstaller headers */
 #include "pyi_global.h"
@@ -63,6 +66,7 @@
 
 /* Forward declarations */
 static Tcl_ThreadCreateProc _splash_init;
+static int _pyi_splash_post_status(struct SPLASH_CONTEXT *splash, bool force);
 struct Splash_Event;
 
 
@@ -241,6 +245,137 @@ pyi_splash_start(struct SPLASH_CONTEXT *splash, const char *executable)
     return 0;
 }
 
+/*
+ * Body of the bring-up thread: load Tcl/Tk shared libraries and start
+ * the splash screen, then publish the result. Once the splash screen is
+ * started, the status that was stored by the main thread in the meantime
+ * is posted to the Tcl interpreter thread.
+ */
+static void
+_pyi_splash_bringup(struct SPLASH_CONTEXT *splash)
+{
+    int status = -1;
+
+    if (pyi_splash_load_shared_libaries(splash) != 0) {
+        PYI_WARNING("Failed to load Tcl/Tk shared libraries for splash screen!\n");
+    } else if (pyi_splash_start(splash, splash->bringup_executable) != 0) {
+        PYI_WARNING("Failed to start splash screen!\n");
+    } else {
+        status = 0;
+    }
+
+#ifdef _WIN32
+    EnterCriticalSection(&splash->bringup_lock);
+#else
+    pthread_mutex_lock(&splash->bringup_lock);
+#endif
+
+    splash->bringup_status = status;
+    if (status == 0) {
+        splash->started = true;
+        PI_Tcl_MutexLock(&splash->status_mutex);
+        _pyi_splash_post_status(splash, true);
+        PI_Tcl_MutexUnlock(&splash->status_mutex);
+    }
+
+#ifdef _WIN32
+    LeaveCriticalSection(&splash->bringup_lock);
+#else
+    pthread_mutex_unlock(&splash->bringup_lock);
+#endif
+}
+
+#ifdef _WIN32
+static DWORD WINAPI
+_pyi_splash_bringup_thread(LPVOID arg)
+{
+    _pyi_splash_bringup((struct SPLASH_CONTEXT *)arg);
+    return 0;
+}
+#else
+static void *
+_pyi_splash_bringup_thread(void *arg)
+{
+    _pyi_splash_bringup((struct SPLASH_CONTEXT *)arg);
+    return NULL;
+}
+#endif
+
+/*
+ * Load Tcl/Tk shared libraries and start the splash screen in a separate
+ * bring-up thread, so that the caller can proceed with other work (i.e.,
+ * the extraction of application's files in onefile mode) in the meantime.
+ * The splash screen requirements must already be available on the
+ * filesystem. Status updates made before the splash screen is started
+ * are stored, and the latest one is displayed once the splash screen
+ * is up.
+ *
+ * Returns 0 if the bring-up thread was created, and -1 otherwise; in
+ * the latter case, the caller should fall back to synchronous start-up
+ * via pyi_splash_load_shared_libaries() and pyi_splash_start().
+ *
+ * The bring-up thread must be joined via pyi_splash_join() before the
+ * splash screen is finalized, and before the start-up data is freed.
+ */
+int
+pyi_splash_start_async(struct SPLASH_CONTEXT *splash, const char *executable)
+{
+    splash->bringup_executable = executable;
+    splash->bringup_status = -1;
+    splash->started = false;
+
+#ifdef _WIN32
+    InitializeCriticalSection(&splash->bringup_lock);
+    splash->bringup_thread = CreateThread(NULL, 0, _pyi_splash_bringup_thread, splash, 0, NULL);
+    if (splash->bringup_thread == NULL) {
+        DeleteCriticalSection(&splash->bringup_lock);
+        return -1;
+    }
+#else
+    if (pthread_mutex_init(&splash->bringup_lock, NULL) != 0) {
+        return -1;
+    }
+    if (pthread_create(&splash->bringup_thread, NULL, _pyi_splash_bringup_thread, splash) != 0) {
+        pthread_mutex_destroy(&splash->bringup_lock);
+        return -1;
+    }
+#endif
+
+    PYI_DEBUG("SPLASH: created splash screen bring-up thread.\n");
+    splash->bringup_active = true;
+
+    return 0;
+}
+
+/*
+ * Wait for the bring-up thread created by pyi_splash_start_async() to
+ * finish. Returns 0 if the splash screen was successfully started (or
+ * if there is no bring-up thread), and -1 if the bring-up failed; in
+ * the latter case, the caller should finalize and free the splash
+ * screen context.
+ */
+int
+pyi_splash_join(struct SPLASH_CONTEXT *splash)
+{
+    if (splash == NULL || !splash->bringup_active) {
+        return 0;
+    }
+
+    PYI_DEBUG("SPLASH: waiting for splash screen bring-up thread...\n");
+#ifdef _WIN32
+    WaitForSingleObject(splash->bringup_thread, INFINITE);
+    CloseHandle(splash->bringup_thread);
+    DeleteCriticalSection(&splash->bringup_lock);
+#else
+    pthread_join(splash->bringup_thread, NULL);
+    pthread_mutex_destroy(&splash->bringup_lock);
+#endif
+    splash->bringup_active = false;
+
+    PYI_DEBUG("SPLASH: splash screen bring-up %s\n", splash->bringup_status == 0 ? "succeeded." : "failed!");
+    return splash->bringup_status;
+}
+
 /*
  * Extract the necessary parts of the splash screen resources from
  * the PKG/CArchive, if they are bundled (i.e., onefile mode). No-op
@@ -443,6 +578,7 @@ pyi_splash_finalize(struct SPLASH_CONTEXT *splash)
     PI_Tcl_MutexFinalize(&splash->call_mutex);
     PI_Tcl_MutexFinalize(&splash->start_mutex);
     PI_Tcl_MutexFinalize(&splash->exit_mutex);
+    PI_Tcl_MutexFinalize(&splash->status_mutex);
 
     /* This function should only be called after python has been
      * destroyed with Py_Finalize. Tcl/Tk/tkinter do **not** support
@@ -493,6 +629,35 @@ pyi_splash_context_new()
     return splash;
 }
 
+/*
+ * Free the splash screen resources that are needed only during start-up
+ * of the splash screen (the script and the image) and during extraction
+ * (the list of requirements). Used by the onefile parent process to reduce
+ * its memory footprint while it waits for the child process. The Tcl
+ * interpreter thread uses the script and the image only before it signals
+ * the completion of its start-up, so this is safe to call once
+ * pyi_splash_start() returned.
+ */
+void
+pyi_splash_free_startup_data(struct SPLASH_CONTEXT *splash)
+{
+    if (splash == NULL) {
+        return;
+    }
+
+    free(splash->script);
+    splash->script = NULL;
+    splash->script_len = 0;
+
+    free(splash->image);
+    splash->image = NULL;
+    splash->image_len = 0;
+
+    free(splash->requirements);
+    splash->requirements = NULL;
+    splash->requirements_len = 0;
+}
+
 /*
  * Free memory allocated for the splash context structure (the memory
  * allocated for its heap-allocated fields, as well as the structure
@@ -607,39 +772,188 @@ _splash_event_proc(Tcl_Event *ev, int flags)
     return 1;
 }
 
+/* Minimum interval between two status updates posted to the Tcl
+ * interpreter thread, in milliseconds; corresponds to the refresh rate
+ * of a typical display, as faster updates could not be rendered anyway. */
+#define PYI_SPLASH_STATUS_UPDATE_INTERVAL 16
+
 /*
- * To update the splash screen text with the given text, we schedule a
- * Splash_Event into the Tcl interpreter's event queue.
- *
- * This function will update the variable "status_text", which updates the label
- * on the splash screen. We schedule this function in async mode, meaning
- * the main (bootloader) thread does not wait for this function to finish
- * its execution.
+ * Monotonic time in milliseconds, used for rate-limiting of status updates.
+ */
+static uint64_t
+_pyi_splash_get_time_ms(void)
+{
+#ifdef _WIN32
+    return (uint64_t)GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+#endif
+}
+
+/*
+ * Apply the latest values from the status mailbox to the Tcl variables
+ * "status_progress" (byte-based extraction progress, as a fraction
+ * between 0 and 1) and "status_text" (which updates the label on the
+ * splash screen). The progress is set first, so that traces on
+ * "status_text" see the matching progress value.
  *
  * Note: this function is executed inside the Tcl interpreter thread.
  */
 static int
-_pyi_splash_text_update(struct SPLASH_CONTEXT *splash, const void *user_data)
+_pyi_splash_status_update(struct SPLASH_CONTEXT *splash, const void *user_data)
 {
-    const char *text = (const char *)user_data;
+    char text[PYI_PATH_MAX];
+    char progress[32];
+    double fraction;
+
+    /* Copy the values and mark the mailbox as serviced, in a single
+     * critical section; the updates posted afterwards are either posted
+     * as a new event, or flushed at the end of extraction. */
+    PI_Tcl_MutexLock(&splash->status_mutex);
+    memcpy(text, splash->status_text, PYI_PATH_MAX);
+    if (splash->status_bytes_total > 0) {
+        fraction = (double)splash->status_bytes_done / (double)splash->status_bytes_total;
+    } else {
+        fraction = 0.0;
+    }
+    splash->status_dirty = false;
+    splash->status_pending = false;
+    PI_Tcl_MutexUnlock(&splash->status_mutex);
+
+    snprintf(progress, sizeof(progress), "%.4f", fraction > 1.0 ? 1.0 : fraction);
+    PI_Tcl_SetVar2(splash->interp, "status_progress", NULL, progress, TCL_GLOBAL_ONLY);
     PI_Tcl_SetVar2(splash->interp, "status_text", NULL, text, TCL_GLOBAL_ONLY);
     return 0;
 }
 
 /*
- * To update the text on the splash screen, we provide this function,
- * which enqueues an event for the Tcl interpreter thread to service.
+ * Post an event that applies the status mailbox, if there is no such
+ * event pending already, and if the rate limit allows it (or force is
+ * set). Must be called with status_mutex held.
+ */
+static int
+_pyi_splash_post_status(struct SPLASH_CONTEXT *splash, bool force)
+{
+    uint64_t now;
+
+    if (splash->status_pending || !splash->status_dirty) {
+        return 0;
+    }
+
+    now = _pyi_splash_get_time_ms();
+    if (!force && now - splash->status_post_time < PYI_SPLASH_STATUS_UPDATE_INTERVAL) {
+        return 0;
+    }
+
+    splash->status_pending = true;
+    splash->status_post_time = now;
+    return pyi_splash_send(splash, true, NULL, _pyi_splash_status_update);
+}
+
+/*
+ * Update the text and the byte-based extraction progress on the splash
+ * screen. The values are stored in the latest-value mailbox; intermediate
+ * updates are dropped, and events are posted to the Tcl interpreter thread
+ * at most at display refresh rate, so that extraction of many small files
+ * does not flood the Tcl thread with events (nor contend for its mutexes).
  *
  * This function is called from bootloader's main thread, namely from
  * the pyi_launch_extract_files_from_archive while it extracts files
- * from the executable-embedded archive.
+ * from the executable-embedded archive. Once extraction is complete,
+ * pyi_splash_flush_status() should be called to display the final
+ * values.
+ */
+int
+pyi_splash_update_progress(struct SPLASH_CONTEXT *splash, const char *text, uint64_t bytes_done, uint64_t bytes_total)
+{
+    int rc;
+
+    /* While the splash screen is being brought up asynchronously, only
+     * store the values; the bring-up thread posts them once the splash
+     * screen is started. */
+    if (splash->bringup_active) {
+        bool started;
+
+#ifdef _WIN32
+        EnterCriticalSection(&splash->bringup_lock);
+#else
+        pthread_mutex_lock(&splash->bringup_lock);
+#endif
+        started = splash->started;
+        if (!started) {
+            snprintf(splash->status_text, PYI_PATH_MAX, "%s", text);
+            splash->status_bytes_done = bytes_done;
+            splash->status_bytes_total = bytes_total;
+            splash->status_dirty = true;
+        }
+#ifdef _WIN32
+        LeaveCriticalSection(&splash->bringup_lock);
+#else
+        pthread_mutex_unlock(&splash->bringup_lock);
+#endif
+
+        if (!started) {
+            return 0;
+        }
+    }
+
+    PI_Tcl_MutexLock(&splash->status_mutex);
+    snprintf(splash->status_text, PYI_PATH_MAX, "%s", text);
+    splash->status_bytes_done = bytes_done;
+    splash->status_bytes_total = bytes_total;
+    splash->status_dirty = true;
+    rc = _pyi_splash_post_status(splash, false);
+    PI_Tcl_MutexUnlock(&splash->status_mutex);
+
+    return rc;
+}
+
+/*
+ * Update the text on the splash screen, keeping the progress value.
+ * See pyi_splash_update_progress().
  */
 int
 pyi_splash_update_text(struct SPLASH_CONTEXT *splash, const char *text)
 {
-    /* We enqueue the _pyi_splash_text_update function into the Tcl
-     * interpreter event queue in async mode, ignoring the return value. */
-    return pyi_splash_send(splash, true, text, _pyi_splash_text_update);
+    return pyi_splash_update_progress(splash, text, splash->status_bytes_done, splash->status_bytes_total);
+}
+
+/*
+ * Post the latest values from the status mailbox to the Tcl interpreter
+ * thread, regardless of the rate limit.
+ */
+int
+pyi_splash_flush_status(struct SPLASH_CONTEXT *splash)
+{
+    int rc;
+
+    /* Not started yet; the bring-up thread posts the latest values
+     * once the splash screen is started. */
+    if (splash->bringup_active) {
+        bool started;
+
+#ifdef _WIN32
+        EnterCriticalSection(&splash->bringup_lock);
+        started = splash->started;
+        LeaveCriticalSection(&splash->bringup_lock);
+#else
+        pthread_mutex_lock(&splash->bringup_lock);
+        started = splash->started;
+        pthread_mutex_unlock(&splash->bringup_lock);
+#endif
+
+        if (!started) {
+            return 0;
+        }
+    }
+
+    PI_Tcl_MutexLock(&splash->status_mutex);
+    rc = _pyi_splash_post_status(splash, true);
+    PI_Tcl_MutexUnlock(&splash->status_mutex);
+
+    return rc;
 }
 
 /*
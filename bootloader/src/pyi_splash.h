@@ -14,6 +14,12 @@
 #ifndef PYI_SPLASH_H
 #define PYI_SPLASH_H
 
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <pthread.h>
+#endif
+
 #include "zlib.h"
 #include "pyi_global.h"
 #include "pyi_archive.h"
@@ -124,6 +130,40 @@ struct SPLASH_CONTEXT
      * during finalization. */
     pyi_dylib_t dll_tcl;
     pyi_dylib_t dll_tk;
+
+    /* Latest-value mailbox for status updates (text and byte-based
+     * extraction progress), which are posted from the main thread during
+     * extraction. Each update overwrites the previous values; an event
+     * that applies the latest values in the Tcl interpreter thread is
+     * posted only if there is no such event pending yet, and at most
+     * once per PYI_SPLASH_STATUS_UPDATE_INTERVAL milliseconds. The
+     * fields are protected by status_mutex. */
+    Tcl_Mutex status_mutex;
+    char status_text[PYI_PATH_MAX];
+    uint64_t status_bytes_done;
+    uint64_t status_bytes_total;
+    bool status_dirty; /* the mailbox contains values that were not posted yet */
+    bool status_pending; /* an event was posted, but not serviced yet */
+    uint64_t status_post_time; /* time of the last post, in milliseconds */
+
+    /* Asynchronous bring-up (loading of Tcl/Tk shared libraries and start
+     * of the splash screen) in a separate thread; used by the onefile
+     * parent process to overlap the bring-up with the extraction of the
+     * application's files. See pyi_splash_start_async(). The bring-up
+     * thread handle and the bringup_active flag are accessed only from
+     * the main thread; the bringup_status and started fields are
+     * protected by bringup_lock while the bring-up thread is active. */
+#ifdef _WIN32
+    HANDLE bringup_thread;
+    CRITICAL_SECTION bringup_lock;
+#else
+    pthread_t bringup_thread;
+    pthread_mutex_t bringup_lock;
+#endif
+    const char *bringup_executable;
+    bool bringup_active; /* bring-up thread was created and not joined yet */
+    int bringup_status; /* 0 if splash screen was started, -1 on failure */
+    bool started; /* splash screen was started and can receive events */
 };
 
 typedef int (pyi_splash_event_proc)(struct SPLASH_CONTEXT *, const void *);
@@ -139,6 +179,8 @@ int pyi_splash_setup(struct SPLASH_CONTEXT *splash, const struct PYI_CONTEXT *py
 int pyi_splash_load_shared_libaries(struct SPLASH_CONTEXT *splash);
 int pyi_splash_finalize(struct SPLASH_CONTEXT *splash);
 int pyi_splash_start(struct SPLASH_CONTEXT *splash, const char *executable);
+int pyi_splash_start_async(struct SPLASH_CONTEXT *splash, const char *executable);
+int pyi_splash_join(struct SPLASH_CONTEXT *splash);
 
 /* Archive helper functions */
 int pyi_splash_extract(struct SPLASH_CONTEXT *splash, const struct PYI_CONTEXT *pyi_ctx);
@@ -151,9 +193,12 @@ int pyi_splash_send(
     pyi_splash_event_proc proc
 );
 int pyi_splash_update_text(struct SPLASH_CONTEXT *splash, const char *toc_entry_name);
+int pyi_splash_update_progress(struct SPLASH_CONTEXT *splash, const char *text, uint64_t bytes_done, uint64_t bytes_total);
+int pyi_splash_flush_status(struct SPLASH_CONTEXT *splash);
 
 /* Memory allocation functions */
 struct SPLASH_CONTEXT *pyi_splash_context_new();
+void pyi_splash_free_startup_data(struct SPLASH_CONTEXT *splash);
 void pyi_splash_context_free(struct SPLASH_CONTEXT **splash_ref);
 
 #endif /*PYI_SPLASH_H */
@@ -36,6 +36,22 @@ int pyi_create_temporary_application_directory(struct PYI_CONTEXT *pyi_ctx);
 /* Recursive directory deletion. */
 int pyi_recursive_rmdir(const char *dir);
 
+#if !defined(_WIN32)
+/* Suffix appended to the name of directory that is scheduled for
+ * deferred removal. */
+#define PYI_TOMBSTONE_SUFFIX ".deleted"
+
+/* Suffix appended to the name of temporary directory to obtain the
+ * name of its lock file. */
+#define PYI_LOCK_SUFFIX ".lock"
+
+int pyi_recursive_rmdir_detached(const char *dir);
+
+int pyi_lock_temporary_application_directory(struct PYI_CONTEXT *pyi_ctx);
+void pyi_unlock_temporary_application_directory(struct PYI_CONTEXT *pyi_ctx);
+int pyi_sweep_stale_temporary_directories(const struct PYI_CONTEXT *pyi_ctx);
+#endif
+
 /* Misc. file/directory manipulation. */
 int pyi_create_parent_directory_tree(const struct PYI_CONTEXT *pyi_ctx, const char *prefix_path, const char *filename);
 int pyi_copy_file(const char *src_filename, const char *dest_filename);
@@ -46,6 +62,9 @@ int pyi_utils_dlclose(pyi_dylib_t handle);
 
 /* Child process */
 int pyi_utils_create_child(struct PYI_CONTEXT *pyi_ctx);
+#if !defined(_WIN32)
+int pyi_utils_run_onefile_waiter(struct PYI_CONTEXT *pyi_ctx);
+#endif
 
 #if !defined(_WIN32) && !defined(__APPLE__)
 int pyi_utils_set_library_search_path(const char *path);
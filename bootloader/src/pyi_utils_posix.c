@@ -25,15 +25,23 @@
 #include <stdio.h>  /* FILE */
 #include <stdlib.h>
 #include <stddef.h> /* ptrdiff_t */
-#include <unistd.h> /* rmdir, unlink, mkdtemp */
+#include <unistd.h> /* rmdir, unlink, mkdtemp, nice */
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h> /* open */
 #include <signal.h> /* kill */
 #include <sys/stat.h> /* struct stat */
+#include <sys/file.h> /* flock */
 #include <sys/wait.h>
 #include <sys/sem.h> /* SysV semaphore API */
 
 #include <dirent.h>
+#include <time.h>
+#include <utime.h>
+
+#if defined(__linux__)
+    #include <sys/syscall.h> /* SYS_ioprio_set */
+#endif
 
 /*
  * On AIX  RTLD_MEMBER  flag is only visible when _ALL_SOURCE flag is defined.
@@ -358,6 +366,432 @@ pyi_recursive_rmdir(const char *dir_path)
     return rmdir(dir_path);
 }
 
+/*
+ * Lower the CPU and I/O scheduling priority of the calling process.
+ * Failures are ignored, as this is a best-effort optimization.
+ */
+static void
+_pyi_lower_process_priority()
+{
+    if (nice(19) == -1) {
+        /* Ignored; nice() may legitimately return -1 */
+    }
+#if defined(__linux__) && defined(SYS_ioprio_set)
+    /* ioprio_set(IOPRIO_WHO_PROCESS, 0, IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0));
+     * glibc does not provide a wrapper, nor the constants. */
+    syscall(SYS_ioprio_set, 1, 0, 3 << 13);
+#endif
+}
+
+/*
+ * Spawn a detached, low-priority helper process. The process is
+ * double-forked, so that the helper process is re-parented to init and
+ * the caller does not need to wait for it; the helper is detached from
+ * the session (and thus from the controlling terminal), and its standard
+ * streams are redirected to /dev/null.
+ *
+ * Returns 0 in the helper process (which must terminate via _exit() once
+ * it is done), 1 in the calling process if the helper process was
+ * successfully spawned, and -1 on error.
+ */
+static int
+_pyi_spawn_detached_helper()
+{
+    pid_t pid;
+    int status;
+
+    pid = fork();
+    if (pid < 0) {
+        return -1;
+    }
+
+    if (pid == 0) {
+        int fd;
+
+        /* Intermediate process: detach from the session, and spawn the
+         * helper process. */
+        setsid();
+        pid = fork();
+        if (pid != 0) {
+            _exit(pid < 0 ? 1 : 0);
+        }
+
+        /* Helper process: detach standard streams, and lower the
+         * priority. */
+        fd = open("/dev/null", O_RDWR);
+        if (fd >= 0) {
+            dup2(fd, STDIN_FILENO);
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            if (fd > STDERR_FILENO) {
+                close(fd);
+            }
+        }
+        _pyi_lower_process_priority();
+        return 0;
+    }
+
+    /* Reap the intermediate process. */
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return -1;
+    }
+
+    return 1;
+}
+
+/*
+ * Deferred removal of a directory. The directory is renamed to a
+ * tombstone name (which immediately frees the original path and marks
+ * the directory as scheduled for removal), and the tombstone directory
+ * is removed by a detached, low-priority helper process. This allows
+ * the onefile parent process to exit without waiting for the removal
+ * of a (potentially large) directory tree.
+ *
+ * If the directory cannot be renamed or the helper process cannot be
+ * spawned, the directory is removed synchronously. Returns 0 if the
+ * removal was successfully scheduled or performed, -1 on error.
+ */
+int
+pyi_recursive_rmdir_detached(const char *dir_path)
+{
+    char tombstone_path[PYI_PATH_MAX];
+
+    if (snprintf(tombstone_path, PYI_PATH_MAX, "%s%s", dir_path, PYI_TOMBSTONE_SUFFIX) >= PYI_PATH_MAX) {
+        return pyi_recursive_rmdir(dir_path);
+    }
+    if (rename(dir_path, tombstone_path) < 0) {
+        PYI_DEBUG("LOADER: failed to rename directory %s to tombstone name; removing it synchronously.\n", dir_path);
+        return pyi_recursive_rmdir(dir_path);
+    }
+
+    switch (_pyi_spawn_detached_helper()) {
+        case 0: {
+            /* Helper process */
+            _exit(pyi_recursive_rmdir(tombstone_path) < 0 ? 1 : 0);
+        }
+        case 1: {
+            /* Calling process */
+            break;
+        }
+        default: {
+            PYI_DEBUG("LOADER: failed to spawn helper process; removing directory synchronously.\n");
+            return pyi_recursive_rmdir(tombstone_path);
+        }
+    }
+
+    PYI_DEBUG("LOADER: scheduled removal of directory %s (renamed to %s).\n", dir_path, tombstone_path);
+    return 0;
+}
+
+
+/**********************************************************************\
+ *      Locking and garbage collection of temporary directories       *
+\**********************************************************************/
+
+/* Minimum interval (in seconds) between two sweeps for stale temporary
+ * directories. */
+#define PYI_SWEEP_INTERVAL (60 * 60)
+
+/* Minimum age (in seconds) of lock file or tombstone directory before
+ * it is considered for removal. This covers the short window between
+ * creation of the lock file and acquisition of the lock, as well as
+ * the removal that might still be carried out by a deferred-cleanup
+ * helper process. */
+#define PYI_SWEEP_GRACE_PERIOD 60
+
+/* Name of the (per-user) time-stamp file in the parent directory of
+ * temporary directories, used to rate-limit the sweeps. */
+#define PYI_SWEEP_STAMP_FORMAT "%s%c_MEIsweep-%lu.stamp"
+
+/*
+ * Create the lock file for onefile application's temporary directory,
+ * and acquire an exclusive advisory lock on it. The lock file is placed
+ * next to the temporary directory (instead of inside of it), so that
+ * it does not interfere with the application's contents. The lock is
+ * held until the process (and its child process, which inherits the
+ * descriptor) terminates, or until the lock is explicitly released via
+ * pyi_unlock_temporary_application_directory(). The lock file also
+ * contains the PID of the process that created it, for informational
+ * purposes.
+ *
+ * Returns 0 on success, -1 on failure. Failure to lock the directory
+ * is not fatal; the only consequence is that the directory will not be
+ * cleaned up if the application is abruptly terminated.
+ */
+int
+pyi_lock_temporary_application_directory(struct PYI_CONTEXT *pyi_ctx)
+{
+#if defined(LOCK_EX)
+    char lock_path[PYI_PATH_MAX];
+    char pid_str[32];
+    int fd;
+    int len;
+
+    if (snprintf(lock_path, PYI_PATH_MAX, "%s%s", pyi_ctx->application_home_dir, PYI_LOCK_SUFFIX) >= PYI_PATH_MAX) {
+        return -1;
+    }
+
+    fd = open(lock_path, O_RDWR | O_CREAT | O_NOFOLLOW, 0600);
+    if (fd < 0) {
+        PYI_DEBUG("LOADER: failed to create lock file: %s\n", lock_path);
+        return -1;
+    }
+
+    /* Ensure that descriptor does not clash with standard streams (in
+     * case any of those were closed when we were launched), and that
+     * the value of 0 can be used to denote "no lock held". */
+    if (fd <= STDERR_FILENO) {
+        int new_fd = fcntl(fd, F_DUPFD, STDERR_FILENO + 1);
+        close(fd);
+        if (new_fd < 0) {
+            unlink(lock_path);
+            return -1;
+        }
+        fd = new_fd;
+    }
+
+    if (flock(fd, LOCK_EX | LOCK_NB) < 0) {
+        PYI_DEBUG("LOADER: failed to lock lock file: %s\n", lock_path);
+        close(fd);
+        unlink(lock_path);
+        return -1;
+    }
+
+    /* Write PID marker; failures are ignored. */
+    len = snprintf(pid_str, sizeof(pid_str), "%ld\n", (long)getpid());
+    if (ftruncate(fd, 0) == 0 && write(fd, pid_str, len) != len) {
+        /* Ignored */
+    }
+
+    PYI_DEBUG("LOADER: locked temporary directory via lock file: %s\n", lock_path);
+    pyi_ctx->application_home_dir_lock_fd = fd;
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+/*
+ * Remove the lock file of onefile application's temporary directory,
+ * and release the lock. To be called after the temporary directory has
+ * been removed (or renamed to tombstone name).
+ */
+void
+pyi_unlock_temporary_application_directory(struct PYI_CONTEXT *pyi_ctx)
+{
+    char lock_path[PYI_PATH_MAX];
+
+    if (pyi_ctx->application_home_dir_lock_fd <= 0) {
+        return;
+    }
+
+    if (snprintf(lock_path, PYI_PATH_MAX, "%s%s", pyi_ctx->application_home_dir, PYI_LOCK_SUFFIX) < PYI_PATH_MAX) {
+        unlink(lock_path);
+    }
+
+    close(pyi_ctx->application_home_dir_lock_fd);
+    pyi_ctx->application_home_dir_lock_fd = 0;
+}
+
+#if defined(LOCK_EX)
+
+/* Check if the given name has the specified suffix. */
+static int
+_pyi_has_suffix(const char *name, const char *suffix)
+{
+    size_t name_len = strlen(name);
+    size_t suffix_len = strlen(suffix);
+    return name_len > suffix_len && strcmp(name + name_len - suffix_len, suffix) == 0;
+}
+
+/*
+ * Try to acquire the lock file of a temporary directory; if the lock
+ * is not held by any live process, the temporary directory is stale,
+ * and is removed together with its lock file.
+ */
+static void
+_pyi_sweep_locked_directory(const char *lock_path, time_t now)
+{
+    char dir_path[PYI_PATH_MAX];
+    struct stat stat_buf;
+    int fd;
+
+    /* Only consider regular files that belong to current user, and
+     * are old enough. */
+    if (lstat(lock_path, &stat_buf) < 0 || !S_ISREG(stat_buf.st_mode) || stat_buf.st_uid != getuid()) {
+        return;
+    }
+    if (now - stat_buf.st_mtime < PYI_SWEEP_GRACE_PERIOD) {
+        return;
+    }
+
+    fd = open(lock_path, O_RDWR | O_NOFOLLOW);
+    if (fd < 0) {
+        return;
+    }
+
+    /* If we manage to acquire the lock, no live process is using the
+     * directory anymore. Keep holding the lock while removing the
+     * directory, so that concurrent sweeps skip it. */
+    if (flock(fd, LOCK_EX | LOCK_NB) == 0) {
+        snprintf(dir_path, PYI_PATH_MAX, "%.*s", (int)(strlen(lock_path) - strlen(PYI_LOCK_SUFFIX)), lock_path);
+
+        if (lstat(dir_path, &stat_buf) == 0 && S_ISDIR(stat_buf.st_mode) && stat_buf.st_uid == getuid()) {
+            PYI_DEBUG("LOADER: removing stale temporary directory: %s\n", dir_path);
+            pyi_recursive_rmdir(dir_path);
+        }
+
+        /* Remove the lock file only if directory is gone. */
+        if (lstat(dir_path, &stat_buf) < 0 && errno == ENOENT) {
+            unlink(lock_path);
+        }
+    }
+
+    close(fd);
+}
+
+/*
+ * Remove tombstone directory left behind by an interrupted deferred
+ * cleanup.
+ */
+static void
+_pyi_sweep_tombstone_directory(const char *dir_path, time_t now)
+{
+    struct stat stat_buf;
+
+    /* Renaming the directory updates its status change time, so use
+     * that to give the helper process a chance to finish its job. */
+    if (lstat(dir_path, &stat_buf) < 0 || !S_ISDIR(stat_buf.st_mode) || stat_buf.st_uid != getuid()) {
+        return;
+    }
+    if (now - stat_buf.st_ctime < PYI_SWEEP_GRACE_PERIOD) {
+        return;
+    }
+
+    PYI_DEBUG("LOADER: removing tombstone directory: %s\n", dir_path);
+    pyi_recursive_rmdir(dir_path);
+}
+
+#endif /* defined(LOCK_EX) */
+
+/*
+ * Opportunistic sweep for stale temporary directories of onefile
+ * applications, left behind by instances that were abruptly terminated
+ * (SIGKILL, power loss, etc.) and did not get a chance to clean up
+ * after themselves.
+ *
+ * The sweep processes the parent directory of the given application's
+ * temporary directory, and is rate-limited via per-user time-stamp file
+ * in that directory, so that it is performed at most once every
+ * PYI_SWEEP_INTERVAL seconds. The actual sweep is performed in a
+ * detached, low-priority helper process, so it does not delay the
+ * application start-up.
+ *
+ * Only directories with lock files that are not locked by any process,
+ * and tombstone directories left behind by deferred cleanup, are
+ * removed; directories created by bootloaders without locking support
+ * are left alone, as there is no way to tell whether they are in use.
+ *
+ * Returns 0 if the sweep was scheduled, 1 if it was skipped, and -1 on
+ * error.
+ */
+int
+pyi_sweep_stale_temporary_directories(const struct PYI_CONTEXT *pyi_ctx)
+{
+#if defined(LOCK_EX)
+    char parent_dir[PYI_PATH_MAX];
+    char entry_path[PYI_PATH_MAX];
+    char *separator;
+    struct stat stat_buf;
+    time_t now;
+    DIR *dir_handle;
+    struct dirent *dir_entry;
+    int fd;
+
+    /* Determine parent directory of the temporary directory */
+    if (snprintf(parent_dir, PYI_PATH_MAX, "%s", pyi_ctx->application_home_dir) >= PYI_PATH_MAX) {
+        return -1;
+    }
+    separator = strrchr(parent_dir, PYI_SEP);
+    if (separator == NULL) {
+        return -1;
+    }
+    if (separator == parent_dir) {
+        separator++; /* Keep the root directory's separator */
+    }
+    *separator = '\0';
+
+    /* Rate-limit the sweeps via time-stamp file */
+    if (snprintf(entry_path, PYI_PATH_MAX, PYI_SWEEP_STAMP_FORMAT, parent_dir, PYI_SEP, (unsigned long)getuid()) >= PYI_PATH_MAX) {
+        return -1;
+    }
+
+    now = time(NULL);
+    if (lstat(entry_path, &stat_buf) == 0) {
+        if (stat_buf.st_mtime <= now && now - stat_buf.st_mtime < PYI_SWEEP_INTERVAL) {
+            PYI_DEBUG("LOADER: skipping sweep for stale temporary directories; last sweep was performed %ld seconds ago.\n", (long)(now - stat_buf.st_mtime));
+            return 1;
+        }
+    }
+
+    fd = open(entry_path, O_WRONLY | O_CREAT | O_NOFOLLOW, 0600);
+    if (fd < 0) {
+        return -1;
+    }
+    close(fd);
+    if (utime(entry_path, NULL) < 0) {
+        return -1;
+    }
+
+    switch (_pyi_spawn_detached_helper()) {
+        case 0: {
+            /* Helper process; continue below */
+            break;
+        }
+        case 1: {
+            /* Calling process */
+            PYI_DEBUG("LOADER: scheduled sweep for stale temporary directories in: %s\n", parent_dir);
+            return 0;
+        }
+        default: {
+            PYI_DEBUG("LOADER: failed to spawn helper process for sweep for stale temporary directories!\n");
+            return -1;
+        }
+    }
+
+    /* Helper process. Close the inherited descriptor of our own lock
+     * file; the lock remains held by the calling process. */
+    if (pyi_ctx->application_home_dir_lock_fd > 0) {
+        close(pyi_ctx->application_home_dir_lock_fd);
+    }
+
+    dir_handle = opendir(parent_dir);
+    if (dir_handle == NULL) {
+        _exit(1);
+    }
+
+    for (dir_entry = readdir(dir_handle); dir_entry != NULL; dir_entry = readdir(dir_handle)) {
+        if (strncmp(dir_entry->d_name, "_MEI", 4) != 0) {
+            continue;
+        }
+        if (snprintf(entry_path, PYI_PATH_MAX, "%s%c%s", parent_dir, PYI_SEP, dir_entry->d_name) >= PYI_PATH_MAX) {
+            continue;
+        }
+
+        if (_pyi_has_suffix(dir_entry->d_name, PYI_LOCK_SUFFIX)) {
+            _pyi_sweep_locked_directory(entry_path, now);
+        } else if (_pyi_has_suffix(dir_entry->d_name, PYI_TOMBSTONE_SUFFIX)) {
+            _pyi_sweep_tombstone_directory(entry_path, now);
+        }
+    }
+    closedir(dir_handle);
+
+    _exit(0);
+#else
+    return -1;
+#endif
+}
+
 
 /**********************************************************************\
  *                  Shared library loading/unloading                  *
@@ -526,6 +960,262 @@ _signal_handler(int signum)
     errno = original_errno; /* Restore original errno */
 }
 
+/* As indicated in signal(7), signal numbers range from 1-31 (standard)
+ * and 32-64 (Linux real-time). */
+#define PYI_NUM_SIGNALS 65
+
+/*
+ * Install signal handlers to either forward received signals to the
+ * child process, or ignore them (effectively blocking them).
+ */
+static void
+_pyi_install_signal_handlers(const struct PYI_CONTEXT *pyi_ctx)
+{
+    sighandler_t signal_handler;
+    int signum;
+
+    if (pyi_ctx->ignore_signals) {
+        PYI_DEBUG("LOADER: registering signal handlers to ignore received signals.\n");
+        signal_handler = &_ignoring_signal_handler;
+    } else {
+        PYI_DEBUG("LOADER: registering signal handlers to forward received signals to child.\n");
+        signal_handler = &_signal_handler;
+    }
+
+    for (signum = 0; signum < PYI_NUM_SIGNALS; ++signum) {
+        /* Don't mess with SIGCHLD/SIGCLD; it affects our ability
+         * to wait() for the child to exit. Similarly, do not change
+         * don't change SIGTSP handling to allow Ctrl-Z */
+        if (signum == SIGCHLD || signum == SIGCLD || signum == SIGTSTP) {
+            continue;
+        }
+        signal(signum, signal_handler);
+    }
+}
+
+/*
+ * After child process exited, reset signal handlers to default values.
+ */
+static void
+_pyi_restore_signal_handlers(const struct PYI_CONTEXT *pyi_ctx)
+{
+    int signum;
+
+    PYI_DEBUG("LOADER: restoring signal handlers\n");
+    for (signum = 0; signum < PYI_NUM_SIGNALS; ++signum) {
+        signal(signum, SIG_DFL);
+    }
+
+    /* Display statistics from forwarding signal-handler. */
+#if defined(LAUNCH_DEBUG)
+    if (!pyi_ctx->ignore_signals) {
+        PYI_DEBUG(
+            "LOADER: signal forwarding statistics: all=%u, ok=%u, err=%u, noop=%u\n",
+            pyi_ctx->signal_forward_all,
+            pyi_ctx->signal_forward_ok,
+            pyi_ctx->signal_forward_error,
+            pyi_ctx->signal_forward_noop
+        );
+    }
+#endif
+}
+
+/*
+ * Convert the status of the exited child process (as obtained from
+ * waitpid()) into exit code. If the child process was terminated by
+ * a signal, the signal is stored for re-raise after the cleanup.
+ */
+static int
+_pyi_get_child_exit_code(struct PYI_CONTEXT *pyi_ctx, int wait_rc, int status)
+{
+    /* Either wait() failed, or we jumped to `cleanup` and
+     * didn't wait() at all. Either way, exit with error,
+     * because rc does not contain a valid process exit code. */
+    if (wait_rc < 0) {
+        PYI_DEBUG("LOADER: exiting early\n");
+        return 1;
+    }
+
+    if (WIFEXITED(status)) {
+        PYI_DEBUG("LOADER: returning child exit status %d\n", WEXITSTATUS(status));
+        return WEXITSTATUS(status);
+    }
+
+    /* Process ended abnormally */
+    pyi_ctx->child_signalled = WIFSIGNALED(status);
+    if (pyi_ctx->child_signalled) {
+        pyi_ctx->child_signal = WTERMSIG(status);
+        PYI_DEBUG("LOADER: child received signal %d; storing for re-raise after cleanup...\n", pyi_ctx->child_signal);
+    }
+    return 1;
+}
+
+/* Name of the environment variable used to pass the state of onefile
+ * parent process to the waiter process. */
+#define PYI_ONEFILE_WAITER_ENV "_PYI_ONEFILE_WAITER"
+
+/*
+ * Hand over the supervision of the child process to a minimal waiter
+ * process, by replacing this (onefile parent) process with a new
+ * instance of the executable. The PID and the parent-child relationship
+ * are preserved across exec(), while everything that the parent process
+ * accumulated during extraction (heap, loaded libraries, stdio buffers,
+ * etc.) is discarded. The waiter is identified by an environment variable
+ * that carries the state needed for signal forwarding and cleanup; the
+ * child process does not inherit it, as it has already been forked.
+ *
+ * Signal handlers are reset to default by exec(), so all signals are
+ * blocked before exec(); the signals received in the meantime remain
+ * pending, and are forwarded once the waiter installs its handlers and
+ * unblocks them.
+ *
+ * Returns only if exec() failed; in that case, the state is restored,
+ * and the caller should wait for the child process itself.
+ */
+static void
+_pyi_exec_onefile_waiter(const struct PYI_CONTEXT *pyi_ctx, pid_t child_pid, int sem_id)
+{
+    char state[128];
+    char *waiter_argv[2];
+    sigset_t all_signals;
+    sigset_t old_signals;
+
+    snprintf(
+        state,
+        sizeof(state),
+        "%ld:%d:%d:%d:%d:%d",
+        (long)child_pid,
+        sem_id,
+        pyi_ctx->application_home_dir_lock_fd,
+        (int)pyi_ctx->ignore_signals,
+        (int)pyi_ctx->deferred_cleanup,
+        (int)pyi_ctx->strict_unpack_mode
+    );
+    if (pyi_setenv(PYI_ONEFILE_WAITER_ENV, state) < 0) {
+        return;
+    }
+
+    waiter_argv[0] = pyi_ctx->argv[0];
+    waiter_argv[1] = NULL;
+
+    PYI_DEBUG("LOADER: handing over supervision of child process to waiter process...\n");
+
+    sigfillset(&all_signals);
+    sigprocmask(SIG_SETMASK, &all_signals, &old_signals);
+
+    if (pyi_ctx->dynamic_loader_filename[0] != 0) {
+        char *const *exec_argv = pyi_prepend_dynamic_loader_to_argv(1, waiter_argv, (char *)pyi_ctx->dynamic_loader_filename);
+        if (exec_argv != NULL) {
+            execv(pyi_ctx->dynamic_loader_filename, exec_argv);
+            free((void *)exec_argv);
+        }
+    } else {
+        execv(pyi_ctx->executable_filename, waiter_argv);
+    }
+
+    /* exec() failed; continue waiting in this process */
+    sigprocmask(SIG_SETMASK, &old_signals, NULL);
+    pyi_unsetenv(PYI_ONEFILE_WAITER_ENV);
+    PYI_DEBUG("LOADER: failed to start waiter process (errno %d); waiting in parent process.\n", errno);
+}
+
+/*
+ * Check if this process is the onefile waiter process (see
+ * _pyi_exec_onefile_waiter), and if it is, restore the onefile parent
+ * process' state into the context structure, and wait for the child
+ * process to exit.
+ *
+ * Returns -2 if this is not the waiter process; -1 if the state is
+ * invalid or the waited-for process is not our child (in which case,
+ * no cleanup must be performed); otherwise, the child's exit code, as
+ * in pyi_utils_create_child().
+ */
+int
+pyi_utils_run_onefile_waiter(struct PYI_CONTEXT *pyi_ctx)
+{
+    char *state;
+    char *home_dir;
+    long child_pid;
+    int sem_id;
+    int lock_fd;
+    int ignore_signals;
+    int deferred_cleanup;
+    int strict_unpack_mode;
+    int parsed;
+    int status = 0;
+    int wait_rc;
+    sigset_t no_signals;
+
+    state = pyi_getenv(PYI_ONEFILE_WAITER_ENV);
+    if (state == NULL) {
+        return -2;
+    }
+    pyi_unsetenv(PYI_ONEFILE_WAITER_ENV);
+
+    PYI_DEBUG("LOADER: this is onefile waiter process (state: %s).\n", state);
+
+    parsed = sscanf(
+        state,
+        "%ld:%d:%d:%d:%d:%d",
+        &child_pid,
+        &sem_id,
+        &lock_fd,
+        &ignore_signals,
+        &deferred_cleanup,
+        &strict_unpack_mode
+    );
+    free(state);
+
+    /* The application's top-level directory was passed to the child
+     * process via environment variable, which we also inherited. */
+    home_dir = pyi_getenv("_PYI_APPLICATION_HOME_DIR");
+    if (parsed != 6 || child_pid <= 0 || home_dir == NULL ||
+        snprintf(pyi_ctx->application_home_dir, PYI_PATH_MAX, "%s", home_dir) >= PYI_PATH_MAX) {
+        PYI_ERROR("Invalid onefile waiter state!\n");
+        free(home_dir);
+        return -1;
+    }
+    free(home_dir);
+
+    pyi_ctx->child_pid = (pid_t)child_pid;
+    pyi_ctx->application_home_dir_lock_fd = lock_fd;
+    pyi_ctx->ignore_signals = (unsigned char)ignore_signals;
+    pyi_ctx->deferred_cleanup = (unsigned char)deferred_cleanup;
+    pyi_ctx->strict_unpack_mode = (unsigned char)strict_unpack_mode;
+
+    /* Install signal handlers, and unblock the signals (blocked by
+     * the parent process before exec()). */
+    _pyi_install_signal_handlers(pyi_ctx);
+    sigemptyset(&no_signals);
+    sigprocmask(SIG_SETMASK, &no_signals, NULL);
+
+    do {
+        wait_rc = waitpid((pid_t)child_pid, &status, 0);
+    } while (wait_rc < 0 && errno == EINTR);
+    pyi_ctx->child_pid = 0;
+
+    if (wait_rc < 0 && errno == ECHILD) {
+        /* Not our child; do not touch anything */
+        PYI_ERROR("Onefile waiter: process %ld is not a child of this process!\n", child_pid);
+        _pyi_restore_signal_handlers(pyi_ctx);
+        return -1;
+    }
+    if (wait_rc < 0) {
+        PYI_WARNING("LOADER: failed to wait for child process: %s\n", strerror(errno));
+    }
+
+    _pyi_restore_signal_handlers(pyi_ctx);
+
+    /* Destroy the sync semaphore (if available) */
+    if (sem_id >= 0) {
+        if (semctl(sem_id, 0, IPC_RMID) < 0) {
+            PYI_WARNING("LOADER: failed to destroy sync semaphore (errno %d)!\n", errno);
+        }
+    }
+
+    return _pyi_get_child_exit_code(pyi_ctx, wait_rc, status);
+}
+
 /* Start frozen application in a subprocess. The frozen application runs
  * in a subprocess. */
 int
@@ -535,13 +1225,6 @@ pyi_utils_create_child(struct PYI_CONTEXT *pyi_ctx)
     int rc = 0;
     int wait_rc = -1;
 
-    /* As indicated in signal(7), signal numbers range from 1-31 (standard)
-     * and 32-64 (Linux real-time). */
-    const size_t num_signals = 65;
-
-    sighandler_t signal_handler;
-    int signum;
-
     /* Create semaphore for synchronizing child and parent; we need to
      * ensure that the child starts executing user's python code only
      * *after* the parent has fully completed the `fork()` call *and* stored
@@ -681,23 +1364,7 @@ pyi_utils_create_child(struct PYI_CONTEXT *pyi_ctx)
 
     /* Install signal handlers to either forward received signals to the
      * child process, or ignore them (effectively blocking them). */
-    if (pyi_ctx->ignore_signals) {
-        PYI_DEBUG("LOADER: registering signal handlers to ignore received signals.\n");
-        signal_handler = &_ignoring_signal_handler;
-    } else {
-        PYI_DEBUG("LOADER: registering signal handlers to forward received signals to child.\n");
-        signal_handler = &_signal_handler;
-    }
-
-    for (signum = 0; signum < num_signals; ++signum) {
-        /* Don't mess with SIGCHLD/SIGCLD; it affects our ability
-         * to wait() for the child to exit. Similarly, do not change
-         * don't change SIGTSP handling to allow Ctrl-Z */
-        if (signum == SIGCHLD || signum == SIGCLD || signum == SIGTSTP) {
-            continue;
-        }
-        signal(signum, signal_handler);
-    }
+    _pyi_install_signal_handlers(pyi_ctx);
 
     if (sem_id >= 0) {
         PYI_DEBUG("LOADER: signalling the sync semaphore...\n");
@@ -709,6 +1376,16 @@ pyi_utils_create_child(struct PYI_CONTEXT *pyi_ctx)
         }
     }
 
+    /* Optionally hand over the supervision of the child process to the
+     * waiter process. Not applicable when splash screen is shown by this
+     * process, nor when Apple Events need to be forwarded (macOS). The
+     * call returns only if it failed. */
+#if !(defined(__APPLE__) && defined(WINDOWED)) && !defined(__CYGWIN__)
+    if (pyi_ctx->onefile_exec_waiter && pyi_ctx->splash == NULL) {
+        _pyi_exec_onefile_waiter(pyi_ctx, child_pid, sem_id);
+    }
+#endif
+
 #if defined(__APPLE__) && defined(WINDOWED)
     /* macOS: forward events to child */
     do {
@@ -752,23 +1429,7 @@ pyi_utils_create_child(struct PYI_CONTEXT *pyi_ctx)
     }
 
     /* After child process exited, reset signal handlers to default values. */
-    PYI_DEBUG("LOADER: restoring signal handlers\n");
-    for (signum = 0; signum < num_signals; ++signum) {
-        signal(signum, SIG_DFL);
-    }
-
-    /* Display statistics from forwarding signal-handler. */
-#if defined(LAUNCH_DEBUG)
-    if (!pyi_ctx->ignore_signals) {
-        PYI_DEBUG(
-            "LOADER: signal forwarding statistics: all=%u, ok=%u, err=%u, noop=%u\n",
-            pyi_ctx->signal_forward_all,
-            pyi_ctx->signal_forward_ok,
-            pyi_ctx->signal_forward_error,
-            pyi_ctx->signal_forward_noop
-        );
-    }
-#endif
+    _pyi_restore_signal_handlers(pyi_ctx);
 
 cleanup:
     /* Destroy the sync semaphore (if available) */
@@ -784,26 +1445,7 @@ pyi_utils_create_child(struct PYI_CONTEXT *pyi_ctx)
     pyi_utils_free_args(pyi_ctx);
 #endif
 
-    /* Either wait() failed, or we jumped to `cleanup` and
-     * didn't wait() at all. Either way, exit with error,
-     * because rc does not contain a valid process exit code. */
-    if (wait_rc < 0) {
-        PYI_DEBUG("LOADER: exiting early\n");
-        return 1;
-    }
-
-    if (WIFEXITED(rc)) {
-        PYI_DEBUG("LOADER: returning child exit status %d\n", WEXITSTATUS(rc));
-        return WEXITSTATUS(rc);
-    }
-
-    /* Process ended abnormally */
-    pyi_ctx->child_signalled = WIFSIGNALED(rc);
-    if (pyi_ctx->child_signalled) {
-        pyi_ctx->child_signal = WTERMSIG(rc);
-        PYI_DEBUG("LOADER: child received signal %d; storing for re-raise after cleanup...\n", pyi_ctx->child_signal);
-    }
-    return 1;
+    return _pyi_get_child_exit_code(pyi_ctx, wait_rc, rc);
 }
 
 
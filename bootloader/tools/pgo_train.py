@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+# -----------------------------------------------------------------------------
+# Copyright (c) 2014-2023, PyInstaller Development Team.
+#
+# Distributed under the terms of the GNU General Public License (version 2
+# or later) with exception for distributing the bootloader.
+#
+# The full license is in the file COPYING.txt, distributed with this software.
+#
+# SPDX-License-Identifier: (GPL-2.0-or-later WITH Bootloader-exception)
+# -----------------------------------------------------------------------------
+"""
+Training workload for profile-guided optimization of the optimized bootloader variants.
+
+Freezes sample applications with the (installed) instrumented optimized bootloader, and runs them repeatedly, so that
+the profile data covers the start-up path of the bootloader: opening the archive and reading its TOC, extraction of
+files in onefile mode, and the set-up and launch of the python interpreter. Invoked by the `pgo_train` waf command.
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+# Use the PyInstaller from this source tree.
+SOURCE_DIR = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', '..'))
+sys.path.insert(0, SOURCE_DIR)
+
+# Number of times each of the frozen sample applications is run.
+NUM_RUNS = 5
+
+# Number and size of the data files collected into the sample application; these make the extraction in onefile mode
+# non-trivial.
+NUM_DATA_FILES = 200
+DATA_FILE_SIZE = 16 * 1024
+
+SAMPLE_SCRIPT = """
+import os
+import sys
+import json
+import email.parser
+
+data_dir = os.path.join(sys._MEIPASS, 'data')
+assert len(os.listdir(data_dir)) == {num_data_files}
+print(json.dumps({{'ok': True}}))
+"""
+
+SAMPLE_SPEC = """
+a = Analysis([{script!r}], datas=[({data_dir!r}, 'data')])
+pyz = PYZ(a.pure)
+if {onefile!r}:
+    exe = EXE(pyz, a.scripts, a.binaries, a.datas, name={name!r}, console={console!r}, optimized_bootloader=True)
+else:
+    exe = EXE(pyz, a.scripts, [], exclude_binaries=True, name={name!r}, console={console!r}, optimized_bootloader=True)
+    coll = COLLECT(exe, a.binaries, a.datas, name={name!r})
+"""
+
+
+def _create_sample(work_dir):
+    script = os.path.join(work_dir, 'pgo_sample.py')
+    with open(script, 'w', encoding='utf-8') as fp:
+        fp.write(SAMPLE_SCRIPT.format(num_data_files=NUM_DATA_FILES))
+
+    data_dir = os.path.join(work_dir, 'data')
+    os.makedirs(data_dir)
+    for i in range(NUM_DATA_FILES):
+        with open(os.path.join(data_dir, f'file{i:04d}.bin'), 'wb') as fp:
+            # Mix of compressible and incompressible data.
+            fp.write(os.urandom(DATA_FILE_SIZE // 2) + bytes(DATA_FILE_SIZE // 2))
+
+    return script, data_dir
+
+
+def _freeze(work_dir, script, data_dir, name, onefile, console):
+    import PyInstaller.__main__
+
+    spec_file = os.path.join(work_dir, name + '.spec')
+    with open(spec_file, 'w', encoding='utf-8') as fp:
+        fp.write(SAMPLE_SPEC.format(script=script, data_dir=data_dir, name=name, onefile=onefile, console=console))
+
+    dist_dir = os.path.join(work_dir, 'dist')
+    PyInstaller.__main__.run([
+        '--noconfirm',
+        '--log-level=WARN',
+        '--distpath', dist_dir,
+        '--workpath', os.path.join(work_dir, 'build'),
+        spec_file,
+    ])
+
+    exe_name = name + ('.exe' if sys.platform in ('win32', 'cygwin') else '')
+    if onefile:
+        return os.path.join(dist_dir, exe_name)
+    return os.path.join(dist_dir, name, exe_name)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument(
+        '--windowed',
+        action='store_true',
+        help='Also train the windowed variant of the optimized bootloader.',
+    )
+    args = parser.parse_args()
+
+    consoles = [True, False] if args.windowed else [True]
+
+    with tempfile.TemporaryDirectory(prefix='pyi-pgo-') as work_dir:
+        script, data_dir = _create_sample(work_dir)
+
+        executables = []
+        for console in consoles:
+            for onefile in (True, False):
+                name = 'pgo_{}_{}'.format('onefile' if onefile else 'onedir', 'console' if console else 'windowed')
+                executables.append(_freeze(work_dir, script, data_dir, name, onefile, console))
+
+        for executable in executables:
+            print(f"Running training workload: {executable} ({NUM_RUNS} times)", flush=True)
+            for _ in range(NUM_RUNS):
+                subprocess.run([executable], check=True, stdout=subprocess.DEVNULL)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,1150 @@
+/*
+ * ****************************************************************************
+ * Copyright (c) 2013-2023, PyInstaller Development Team.
+ *
+ * Distributed under the terms of the GNU General Public License (version 2
+ * or later) with exception for distributing the bootloader.
+ *
+ * The full license is in the file COPYING.txt, distributed with this software.
+ *
+ * SPDX-License-Identifier: (GPL-2.0-or-later WITH Bootloader-exception)
+ * ****************************************************************************
+ */
+
+/*
+ * Stand-alone tool for inspecting, verifying and extracting the PKG archive
+ * that is embedded in a frozen application's executable (or stored in a
+ * stand-alone .pkg file). It is a native counterpart of pyi-archive_viewer,
+ * intended for processing large executables in bulk (e.g., in CI).
+ *
+ * The TOC is loaded using the bootloader's archive code; the entries' data
+ * is accessed through a read-only memory mapping of the whole file, and
+ * entries are verified/extracted by a pool of worker threads.
+ *
+ * Usage:
+ *   pyi-pkgtool list [-z] ARCHIVE
+ *   pyi-pkgtool verify [-j JOBS] ARCHIVE
+ *   pyi-pkgtool extract [-j JOBS] [-o OUTPUT_DIR] ARCHIVE [NAME ...]
+ */
+
+#include <errno.h>
+#include <fcntl.h>  /* open */
+#include <inttypes.h>  /* PRIu64 */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>  /* mmap */
+#include <sys/stat.h>  /* fstat, mkdir */
+#include <unistd.h>  /* write, symlinkat, unlinkat, sysconf */
+
+/* PyInstaller headers. */
+#include "zlib.h"
+#include "pyi_global.h"
+#include "pyi_archive.h"
+
+
+/* Size of the output buffer used when decompressing entries' data. */
+#define PKGTOOL_BUFFER_SIZE (1024 * 1024)
+
+/* Upper limit on number of worker threads. */
+#define PKGTOOL_MAX_JOBS 256
+
+/* Typecodes of PYZ entries; must match PYZ_ITEM_* definitions in
+ * PyInstaller/loader/pyimod01_archive.py. */
+static const char *_pkgtool_pyz_typenames[] = { "module", "package", "data", "nspkg" };
+
+enum PKGTOOL_COMMAND
+{
+    PKGTOOL_LIST,
+    PKGTOOL_VERIFY,
+    PKGTOOL_EXTRACT
+};
+
+/* State of the tool, shared by the worker threads. */
+struct PKGTOOL
+{
+    enum PKGTOOL_COMMAND command;
+
+    struct ARCHIVE *archive;
+
+    /* Read-only mapping of the whole archive file. */
+    const unsigned char *data;
+    size_t data_size;
+
+    /* Entries to process, and the position of the next unclaimed one. */
+    const struct TOC_ENTRY **entries;
+    uint32_t entry_count;
+    uint32_t next_entry;
+
+    /* Output directory (extract command), and its descriptor; all output
+     * paths are resolved relative to the descriptor, without following
+     * symbolic links. */
+    const char *output_dir;
+    int output_dirfd;
+
+    /* Number of entries that failed to verify or extract. */
+    uint32_t failure_count;
+
+    /* Protects next_entry and failure_count. */
+    pthread_mutex_t lock;
+};
+
+
+/**********************************************************************\
+ *                         Entry data access                          *
+\**********************************************************************/
+
+/*
+ * Return pointer to the entry's data in the mapped archive file, or NULL
+ * if the entry's data lies outside of the file.
+ */
+static const unsigned char *
+_pkgtool_get_entry_data(const struct PKGTOOL *tool, const struct TOC_ENTRY *toc_entry)
+{
+    uint64_t start = tool->archive->pkg_offset + toc_entry->offset;
+
+    if (start < toc_entry->offset || start > tool->data_size || toc_entry->length > tool->data_size - start) {
+        fprintf(stderr, "pyi-pkgtool: data of entry %s lies outside of the archive file!\n", toc_entry->name);
+        return NULL;
+    }
+
+    return tool->data + start;
+}
+
+/* Callback that receives chunks of decompressed data. */
+typedef int (*pkgtool_sink)(void *sink_arg, const unsigned char *chunk, size_t chunk_size);
+
+/*
+ * Decompress the given zlib stream, passing the output to the sink callback
+ * (if provided) in chunks of up to PKGTOOL_BUFFER_SIZE bytes. The buffer
+ * must be at least PKGTOOL_BUFFER_SIZE bytes large. Returns the length of
+ * decompressed data, or (uint64_t)-1 on error.
+ */
+static uint64_t
+_pkgtool_inflate(const unsigned char *src, uint64_t src_length, unsigned char *buffer, pkgtool_sink sink, void *sink_arg)
+{
+    z_stream zstream;
+    uint64_t total_length = 0;
+    int rc;
+
+    memset(&zstream, 0, sizeof(zstream));
+    if (inflateInit(&zstream) != Z_OK) {
+        return (uint64_t)-1;
+    }
+
+    do {
+        /* Feed the input in chunks that fit into uInt */
+        if (zstream.avail_in == 0 && src_length > 0) {
+            uInt chunk_size = src_length > 0x40000000 ? 0x40000000 : (uInt)src_length;
+            zstream.next_in = (unsigned char *)src;
+            zstream.avail_in = chunk_size;
+            src += chunk_size;
+            src_length -= chunk_size;
+        }
+
+        zstream.next_out = buffer;
+        zstream.avail_out = PKGTOOL_BUFFER_SIZE;
+        rc = inflate(&zstream, Z_NO_FLUSH);
+        if (rc != Z_OK && rc != Z_STREAM_END) {
+            break;
+        }
+
+        total_length += PKGTOOL_BUFFER_SIZE - zstream.avail_out;
+        if (sink && sink(sink_arg, buffer, PKGTOOL_BUFFER_SIZE - zstream.avail_out) < 0) {
+            rc = Z_ERRNO;
+            break;
+        }
+        if (rc == Z_OK && zstream.avail_in == 0 && src_length == 0 && zstream.avail_out != 0) {
+            rc = Z_DATA_ERROR; /* Truncated stream */
+            break;
+        }
+    } while (rc != Z_STREAM_END);
+
+    inflateEnd(&zstream);
+
+    return rc == Z_STREAM_END ? total_length : (uint64_t)-1;
+}
+
+/*
+ * Return the entry's uncompressed data; either pointer into the mapping
+ * (uncompressed entries), or a newly-allocated buffer that needs to be
+ * freed by the caller (compressed entries; *allocated is set to true).
+ */
+static const unsigned char *
+_pkgtool_get_uncompressed_data(const struct PKGTOOL *tool, const struct TOC_ENTRY *toc_entry, bool *allocated)
+{
+    const unsigned char *src;
+    unsigned char *data;
+    z_stream zstream;
+    int rc;
+
+    *allocated = false;
+
+    src = _pkgtool_get_entry_data(tool, toc_entry);
+    if (src == NULL) {
+        return NULL;
+    }
+    if (toc_entry->compression_flag != 1) {
+        return src;
+    }
+
+    if (toc_entry->uncompressed_length > SIZE_MAX - 1 || toc_entry->length > 0xFFFFFFFFu || toc_entry->uncompressed_length >= 0xFFFFFFFFu) {
+        fprintf(stderr, "pyi-pkgtool: entry %s is too large to be decompressed into memory!\n", toc_entry->name);
+        return NULL;
+    }
+    data = (unsigned char *)malloc((size_t)toc_entry->uncompressed_length + 1);
+    if (data == NULL) {
+        fprintf(stderr, "pyi-pkgtool: failed to allocate memory for entry %s!\n", toc_entry->name);
+        return NULL;
+    }
+
+    memset(&zstream, 0, sizeof(zstream));
+    zstream.next_in = (unsigned char *)src;
+    zstream.avail_in = (uInt)toc_entry->length;
+    zstream.next_out = data;
+    zstream.avail_out = (uInt)toc_entry->uncompressed_length + 1;
+    rc = inflateInit(&zstream);
+    if (rc == Z_OK) {
+        rc = inflate(&zstream, Z_FINISH);
+        inflateEnd(&zstream);
+    }
+    if (rc != Z_STREAM_END || zstream.total_out != toc_entry->uncompressed_length) {
+        fprintf(stderr, "pyi-pkgtool: failed to decompress entry %s!\n", toc_entry->name);
+        free(data);
+        return NULL;
+    }
+
+    *allocated = true;
+    return data;
+}
+
+
+/* Compute CRC-32 of data that might exceed the range of uInt. */
+static uint32_t
+_pkgtool_crc32(uint32_t digest, const unsigned char *data, uint64_t length)
+{
+    uLong crc = digest;
+
+    while (length > 0) {
+        uInt chunk_size = length > 0x40000000 ? 0x40000000 : (uInt)length;
+        crc = crc32(crc, data, chunk_size);
+        data += chunk_size;
+        length -= chunk_size;
+    }
+    return (uint32_t)crc;
+}
+
+static int
+_pkgtool_crc32_sink(void *sink_arg, const unsigned char *chunk, size_t chunk_size)
+{
+    uint32_t *digest = (uint32_t *)sink_arg;
+    *digest = _pkgtool_crc32(*digest, chunk, chunk_size);
+    return 0;
+}
+
+
+/**********************************************************************\
+ *                    PYZ archive (marshal) parsing                   *
+\**********************************************************************/
+
+/* Subset of the marshal format that is used by PYZ archive's TOC: a list
+ * of (name, (typecode, offset, length)) tuples. See Python/marshal.c. */
+#define MARSHAL_FLAG_REF 0x80
+
+/* Value read from marshal stream. For containers, only the number of
+ * items is recorded; the items follow in the stream. */
+struct MARSHAL_VALUE
+{
+    char type; /* 'i' (integer), 's' (string), 'c' (container), or 'n' (None/bool) */
+    int32_t integer;
+    const unsigned char *string;
+    uint32_t length; /* length of string, or number of items in container */
+};
+
+struct MARSHAL_READER
+{
+    const unsigned char *ptr;
+    const unsigned char *end;
+
+    /* Table of referenceable values */
+    struct MARSHAL_VALUE *refs;
+    uint32_t ref_count;
+    uint32_t ref_capacity;
+};
+
+static int
+_pkgtool_marshal_read_u32(struct MARSHAL_READER *reader, uint32_t *value)
+{
+    if (reader->end - reader->ptr < 4) {
+        return -1;
+    }
+    *value = (uint32_t)reader->ptr[0] | ((uint32_t)reader->ptr[1] << 8) | ((uint32_t)reader->ptr[2] << 16) | ((uint32_t)reader->ptr[3] << 24);
+    reader->ptr += 4;
+    return 0;
+}
+
+/*
+ * Read the next value from the marshal stream. Returns 0 on success,
+ * -1 on malformed input or unsupported value type.
+ */
+static int
+_pkgtool_marshal_read(struct MARSHAL_READER *reader, struct MARSHAL_VALUE *value)
+{
+    unsigned char code;
+    uint32_t ref_index = 0;
+    uint32_t length;
+    bool is_ref;
+
+    if (reader->ptr >= reader->end) {
+        return -1;
+    }
+    code = *reader->ptr++;
+    is_ref = (code & MARSHAL_FLAG_REF) != 0;
+    code &= ~MARSHAL_FLAG_REF;
+
+    /* Reserve the slot in the reference table, so that references are
+     * numbered in the same order as by the marshal module. */
+    if (is_ref) {
+        if (reader->ref_count == reader->ref_capacity) {
+            uint32_t capacity = reader->ref_capacity ? reader->ref_capacity * 2 : 256;
+            struct MARSHAL_VALUE *refs = (struct MARSHAL_VALUE *)realloc(reader->refs, capacity * sizeof(struct MARSHAL_VALUE));
+            if (refs == NULL) {
+                return -1;
+            }
+            reader->refs = refs;
+            reader->ref_capacity = capacity;
+        }
+        ref_index = reader->ref_count++;
+    }
+
+    memset(value, 0, sizeof(*value));
+    switch (code) {
+        case 'N':  /* None */
+        case 'T':  /* True */
+        case 'F': {  /* False */
+            value->type = 'n';
+            break;
+        }
+        case 'i': {  /* 32-bit integer */
+            uint32_t integer;
+            if (_pkgtool_marshal_read_u32(reader, &integer) < 0) {
+                return -1;
+            }
+            value->type = 'i';
+            value->integer = (int32_t)integer;
+            break;
+        }
+        case 'z':  /* short ASCII string */
+        case 'Z': {  /* short interned ASCII string */
+            if (reader->ptr >= reader->end) {
+                return -1;
+            }
+            length = *reader->ptr++;
+            goto read_string;
+        }
+        case 'a':  /* ASCII string */
+        case 'A':  /* interned ASCII string */
+        case 'u':  /* UTF-8 string */
+        case 't': {  /* interned UTF-8 string */
+            if (_pkgtool_marshal_read_u32(reader, &length) < 0) {
+                return -1;
+            }
+read_string:
+            if ((uint64_t)(reader->end - reader->ptr) < length) {
+                return -1;
+            }
+            value->type = 's';
+            value->string = reader->ptr;
+            value->length = length;
+            reader->ptr += length;
+            break;
+        }
+        case ')': {  /* small tuple */
+            if (reader->ptr >= reader->end) {
+                return -1;
+            }
+            value->type = 'c';
+            value->length = *reader->ptr++;
+            break;
+        }
+        case '(':  /* tuple */
+        case '[': {  /* list */
+            if (_pkgtool_marshal_read_u32(reader, &value->length) < 0) {
+                return -1;
+            }
+            value->type = 'c';
+            break;
+        }
+        case 'r': {  /* reference to earlier value */
+            uint32_t index;
+            if (_pkgtool_marshal_read_u32(reader, &index) < 0 || index >= reader->ref_count) {
+                return -1;
+            }
+            *value = reader->refs[index];
+            /* Contents of containers are not retained, so they cannot be
+             * referenced; never happens with PYZ TOC entries. */
+            if (value->type == 'c' && value->length != 0) {
+                return -1;
+            }
+            break;
+        }
+        default: {
+            return -1;
+        }
+    }
+
+    if (is_ref) {
+        reader->refs[ref_index] = *value;
+    }
+
+    return 0;
+}
+
+/* Callback that receives PYZ TOC entries. */
+typedef int (*pkgtool_pyz_callback)(void *callback_arg, const struct MARSHAL_VALUE *name, int32_t typecode, uint32_t offset, uint32_t length);
+
+/*
+ * Parse the TOC of the PYZ archive that is stored in the given buffer, and
+ * invoke the callback for each entry. Returns 0 on success, -1 on error.
+ */
+static int
+_pkgtool_walk_pyz(const unsigned char *pyz_data, uint64_t pyz_length, pkgtool_pyz_callback callback, void *callback_arg)
+{
+    struct MARSHAL_READER reader;
+    struct MARSHAL_VALUE toc;
+    uint32_t toc_offset;
+    uint32_t i;
+    int rc = -1;
+
+    /* Header: PYZ magic pattern (4 bytes), python bytecode magic (4 bytes),
+     * and TOC offset (big-endian 32-bit integer) */
+    if (pyz_length < 12 || memcmp(pyz_data, "PYZ\0", 4) != 0) {
+        return -1;
+    }
+    toc_offset = ((uint32_t)pyz_data[8] << 24) | ((uint32_t)pyz_data[9] << 16) | ((uint32_t)pyz_data[10] << 8) | (uint32_t)pyz_data[11];
+    if (toc_offset >= pyz_length) {
+        return -1;
+    }
+
+    memset(&reader, 0, sizeof(reader));
+    reader.ptr = pyz_data + toc_offset;
+    reader.end = pyz_data + pyz_length;
+
+    if (_pkgtool_marshal_read(&reader, &toc) < 0 || toc.type != 'c') {
+        goto cleanup;
+    }
+    for (i = 0; i < toc.length; i++) {
+        struct MARSHAL_VALUE entry, name, properties, typecode, offset, length;
+
+        if (_pkgtool_marshal_read(&reader, &entry) < 0 || entry.type != 'c' || entry.length != 2 ||
+            _pkgtool_marshal_read(&reader, &name) < 0 || name.type != 's' ||
+            _pkgtool_marshal_read(&reader, &properties) < 0 || properties.type != 'c' || properties.length != 3 ||
+            _pkgtool_marshal_read(&reader, &typecode) < 0 || typecode.type != 'i' ||
+            _pkgtool_marshal_read(&reader, &offset) < 0 || offset.type != 'i' ||
+            _pkgtool_marshal_read(&reader, &length) < 0 || length.type != 'i') {
+            goto cleanup;
+        }
+        if (offset.integer < 0 || length.integer < 0 || (uint64_t)offset.integer + (uint64_t)length.integer > pyz_length) {
+            goto cleanup;
+        }
+        if (callback(callback_arg, &name, typecode.integer, (uint32_t)offset.integer, (uint32_t)length.integer) < 0) {
+            goto cleanup;
+        }
+    }
+    rc = 0;
+
+cleanup:
+    free(reader.refs);
+    return rc;
+}
+
+static int
+_pkgtool_print_pyz_entry(void *callback_arg, const struct MARSHAL_VALUE *name, int32_t typecode, uint32_t offset, uint32_t length)
+{
+    const struct TOC_ENTRY *toc_entry = (const struct TOC_ENTRY *)callback_arg;
+    const char *type_name = "unknown";
+
+    if (typecode >= 0 && typecode < (int32_t)(sizeof(_pkgtool_pyz_typenames) / sizeof(_pkgtool_pyz_typenames[0]))) {
+        type_name = _pkgtool_pyz_typenames[typecode];
+    }
+    printf("%12" PRIu32 " %12s %-8s %s:%.*s\n", offset, "", type_name, toc_entry->name, (int)name->length, name->string);
+    (void)length; /* unused */
+    return 0;
+}
+
+/* State for verifying entries of a PYZ archive. */
+struct PKGTOOL_PYZ_VERIFY
+{
+    const struct TOC_ENTRY *toc_entry;
+    const unsigned char *pyz_data;
+    unsigned char *buffer;
+    uint32_t failure_count;
+};
+
+static int
+_pkgtool_verify_pyz_entry(void *callback_arg, const struct MARSHAL_VALUE *name, int32_t typecode, uint32_t offset, uint32_t length)
+{
+    struct PKGTOOL_PYZ_VERIFY *state = (struct PKGTOOL_PYZ_VERIFY *)callback_arg;
+
+    if (_pkgtool_inflate(state->pyz_data + offset, length, state->buffer, NULL, NULL) == (uint64_t)-1) {
+        fprintf(stderr, "pyi-pkgtool: failed to decompress entry %s:%.*s!\n", state->toc_entry->name, (int)name->length, name->string);
+        state->failure_count++;
+    }
+    (void)typecode; /* unused */
+    return 0;
+}
+
+
+/**********************************************************************\
+ *                        Listing (list command)                      *
+\**********************************************************************/
+
+static int
+_pkgtool_list(struct PKGTOOL *tool, bool list_pyz)
+{
+    const struct ARCHIVE *archive = tool->archive;
+    const struct TOC_ENTRY *toc_entry;
+    int rc = 0;
+
+    printf("%12s %12s %-8s %s\n", "Offset", "Length", "Type", "Name");
+    for (toc_entry = archive->toc; toc_entry < archive->toc_end; toc_entry = pyi_archive_next_toc_entry(archive, toc_entry)) {
+        printf(
+            "%12" PRIu64 " %12" PRIu64 " %c%-7s %s\n",
+            toc_entry->offset,
+            toc_entry->uncompressed_length,
+            toc_entry->typecode,
+            toc_entry->compression_flag == 1 ? " (z)" : "",
+            toc_entry->name
+        );
+
+        /* Nested PYZ archive */
+        if (list_pyz && toc_entry->typecode == ARCHIVE_ITEM_PYZ) {
+            bool allocated;
+            const unsigned char *pyz_data = _pkgtool_get_uncompressed_data(tool, toc_entry, &allocated);
+            if (pyz_data == NULL || _pkgtool_walk_pyz(pyz_data, toc_entry->uncompressed_length, _pkgtool_print_pyz_entry, (void *)toc_entry) < 0) {
+                fprintf(stderr, "pyi-pkgtool: failed to read PYZ archive %s!\n", toc_entry->name);
+                rc = -1;
+            }
+            if (allocated) {
+                free((void *)pyz_data);
+            }
+        }
+    }
+
+    printf(
+        "\nArchive format version: %d, Python version: %d.%d, Python library: %s\n",
+        archive->format_version,
+        archive->python_version / 100,
+        archive->python_version % 100,
+        archive->python_libname
+    );
+
+    return rc;
+}
+
+
+/**********************************************************************\
+ *                  Verification and extraction workers               *
+\**********************************************************************/
+
+/*
+ * Verify the entry: its data must lie within the archive file, the
+ * compressed data must decompress into the declared number of bytes, and
+ * the uncompressed data must match the digest (if archive provides them).
+ * Entries of nested PYZ archives are verified as well.
+ */
+static int
+_pkgtool_verify_entry(const struct PKGTOOL *tool, const struct TOC_ENTRY *toc_entry, unsigned char *buffer)
+{
+    const unsigned char *src;
+    uint64_t length;
+    uint32_t digest = 0;
+
+    src = _pkgtool_get_entry_data(tool, toc_entry);
+    if (src == NULL) {
+        return -1;
+    }
+
+    if (toc_entry->compression_flag == 1) {
+        length = _pkgtool_inflate(src, toc_entry->length, buffer, _pkgtool_crc32_sink, &digest);
+        if (length == (uint64_t)-1) {
+            fprintf(stderr, "pyi-pkgtool: failed to decompress entry %s!\n", toc_entry->name);
+            return -1;
+        }
+    } else {
+        length = toc_entry->length;
+        digest = _pkgtool_crc32(0, src, length);
+    }
+    if (length != toc_entry->uncompressed_length) {
+        fprintf(stderr, "pyi-pkgtool: length of entry %s does not match its TOC entry (%" PRIu64 " != %" PRIu64 ")!\n", toc_entry->name, length, toc_entry->uncompressed_length);
+        return -1;
+    }
+    if (tool->archive->has_digests && digest != toc_entry->digest) {
+        fprintf(stderr, "pyi-pkgtool: data of entry %s does not match its digest!\n", toc_entry->name);
+        return -1;
+    }
+
+    if (toc_entry->typecode == ARCHIVE_ITEM_PYZ) {
+        struct PKGTOOL_PYZ_VERIFY state;
+        bool allocated;
+        int rc = 0;
+
+        state.toc_entry = toc_entry;
+        state.pyz_data = _pkgtool_get_uncompressed_data(tool, toc_entry, &allocated);
+        state.buffer = buffer;
+        state.failure_count = 0;
+        if (state.pyz_data == NULL || _pkgtool_walk_pyz(state.pyz_data, toc_entry->uncompressed_length, _pkgtool_verify_pyz_entry, &state) < 0) {
+            fprintf(stderr, "pyi-pkgtool: failed to read PYZ archive %s!\n", toc_entry->name);
+            rc = -1;
+        } else if (state.failure_count) {
+            rc = -1;
+        }
+        if (allocated) {
+            free((void *)state.pyz_data);
+        }
+        return rc;
+    }
+
+    return 0;
+}
+
+/*
+ * Check that the entry name is a relative path that does not escape the
+ * output directory.
+ */
+static bool
+_pkgtool_is_safe_name(const char *name)
+{
+    const char *component = name;
+
+    if (name[0] == '\0' || name[0] == '/' || name[0] == '\\') {
+        return false;
+    }
+    while (component) {
+        const char *separator = strpbrk(component, "/\\");
+        size_t length = separator ? (size_t)(separator - component) : strlen(component);
+        if (length == 2 && component[0] == '.' && component[1] == '.') {
+            return false;
+        }
+        component = separator ? separator + 1 : NULL;
+    }
+    return true;
+}
+
+/*
+ * Check that the target of the symbolic link with the given entry name is a
+ * relative path that does not point outside of the output directory.
+ */
+static bool
+_pkgtool_is_safe_link_target(const char *name, const char *target)
+{
+    const char *component;
+    const char *separator;
+    int depth = 0;
+
+    if (target[0] == '\0' || target[0] == '/') {
+        return false;
+    }
+
+    /* Depth of the directory that contains the link (the name has already
+     * been checked not to contain .. components) */
+    for (component = name; (separator = strchr(component, '/')) != NULL; component = separator + 1) {
+        size_t length = (size_t)(separator - component);
+        if (length > 0 && !(length == 1 && component[0] == '.')) {
+            depth++;
+        }
+    }
+
+    component = target;
+    while (component) {
+        size_t length;
+        separator = strchr(component, '/');
+        length = separator ? (size_t)(separator - component) : strlen(component);
+        if (length == 2 && component[0] == '.' && component[1] == '.') {
+            if (--depth < 0) {
+                return false;
+            }
+        } else if (length > 0 && !(length == 1 && component[0] == '.')) {
+            depth++;
+        }
+        component = separator ? separator + 1 : NULL;
+    }
+    return true;
+}
+
+/*
+ * Open (and create, if necessary) the parent directory of the entry with
+ * the given name, relative to the output directory. Existing symbolic links
+ * are not followed. The directories might be created concurrently by other
+ * workers. On success, returns the directory descriptor, and stores the
+ * pointer to the last component of the name into basename.
+ */
+static int
+_pkgtool_open_parent_directory(const struct PKGTOOL *tool, const char *name, const char **basename)
+{
+    char component[PYI_PATH_MAX];
+    const char *start = name;
+    const char *separator;
+    int dirfd;
+
+    dirfd = dup(tool->output_dirfd);
+    if (dirfd < 0) {
+        fprintf(stderr, "pyi-pkgtool: failed to open output directory: %s\n", strerror(errno));
+        return -1;
+    }
+
+    while ((separator = strchr(start, '/')) != NULL) {
+        size_t length = (size_t)(separator - start);
+        int subdirfd;
+
+        if (length == 0 || (length == 1 && start[0] == '.')) {
+            start = separator + 1;
+            continue;
+        }
+        snprintf(component, sizeof(component), "%.*s", (int)length, start);
+
+        if (mkdirat(dirfd, component, 0755) < 0 && errno != EEXIST) {
+            fprintf(stderr, "pyi-pkgtool: failed to create directory %.*s: %s\n", (int)(separator - name), name, strerror(errno));
+            close(dirfd);
+            return -1;
+        }
+        subdirfd = openat(dirfd, component, O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
+        if (subdirfd < 0) {
+            fprintf(stderr, "pyi-pkgtool: failed to open directory %.*s: %s\n", (int)(separator - name), name, strerror(errno));
+            close(dirfd);
+            return -1;
+        }
+        close(dirfd);
+        dirfd = subdirfd;
+        start = separator + 1;
+    }
+
+    *basename = start;
+    return dirfd;
+}
+
+static int
+_pkgtool_write_all(void *sink_arg, const unsigned char *chunk, size_t chunk_size)
+{
+    int fd = *(int *)sink_arg;
+
+    while (chunk_size > 0) {
+        ssize_t written = write(fd, chunk, chunk_size > 0x40000000 ? 0x40000000 : chunk_size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        chunk += written;
+        chunk_size -= (size_t)written;
+    }
+    return 0;
+}
+
+/*
+ * Extract the entry into the output directory. Uncompressed data is written
+ * directly from the mapping; compressed data is decompressed in chunks.
+ */
+static int
+_pkgtool_extract_entry(const struct PKGTOOL *tool, const struct TOC_ENTRY *toc_entry, unsigned char *buffer)
+{
+    const struct TOC_ENTRY *data_entry = toc_entry;
+    char output_filename[PYI_PATH_MAX];
+    const unsigned char *src;
+    const char *basename;
+    mode_t mode;
+    int dirfd;
+    int fd;
+    int rc = 0;
+
+    if (!_pkgtool_is_safe_name(toc_entry->name)) {
+        fprintf(stderr, "pyi-pkgtool: refusing to extract entry with unsafe name %s!\n", toc_entry->name);
+        return -1;
+    }
+    if (snprintf(output_filename, PYI_PATH_MAX, "%s/%s", tool->output_dir, toc_entry->name) >= PYI_PATH_MAX) {
+        fprintf(stderr, "pyi-pkgtool: output path for entry %s is too long!\n", toc_entry->name);
+        return -1;
+    }
+
+    /* Aliases share the data blob with an earlier entry */
+    if (toc_entry->typecode == ARCHIVE_ITEM_ALIAS) {
+        data_entry = pyi_archive_resolve_alias(tool->archive, toc_entry);
+        if (data_entry == NULL) {
+            fprintf(stderr, "pyi-pkgtool: failed to resolve alias %s!\n", toc_entry->name);
+            return -1;
+        }
+    }
+
+    dirfd = _pkgtool_open_parent_directory(tool, toc_entry->name, &basename);
+    if (dirfd < 0) {
+        return -1;
+    }
+
+    /* Symbolic links store the link target as their data */
+    if (toc_entry->typecode == ARCHIVE_ITEM_SYMLINK) {
+        bool allocated;
+        const unsigned char *target = _pkgtool_get_uncompressed_data(tool, toc_entry, &allocated);
+        char link_target[PYI_PATH_MAX];
+
+        if (target == NULL) {
+            close(dirfd);
+            return -1;
+        }
+        snprintf(link_target, PYI_PATH_MAX, "%.*s", (int)toc_entry->uncompressed_length, target);
+        if (allocated) {
+            free((void *)target);
+        }
+        if (!_pkgtool_is_safe_link_target(toc_entry->name, link_target)) {
+            fprintf(stderr, "pyi-pkgtool: refusing to create symbolic link %s with unsafe target %s!\n", toc_entry->name, link_target);
+            close(dirfd);
+            return -1;
+        }
+        unlinkat(dirfd, basename, 0);
+        if (symlinkat(link_target, dirfd, basename) < 0) {
+            fprintf(stderr, "pyi-pkgtool: failed to create symbolic link %s: %s\n", output_filename, strerror(errno));
+            rc = -1;
+        }
+        close(dirfd);
+        return rc;
+    }
+
+    src = _pkgtool_get_entry_data(tool, data_entry);
+    if (src == NULL) {
+        close(dirfd);
+        return -1;
+    }
+
+    mode = (data_entry->typecode == ARCHIVE_ITEM_BINARY || data_entry->typecode == ARCHIVE_ITEM_LAZY_BINARY) ? 0755 : 0644;
+    fd = openat(dirfd, basename, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW, mode);
+    close(dirfd);
+    if (fd < 0) {
+        fprintf(stderr, "pyi-pkgtool: failed to open %s: %s\n", output_filename, strerror(errno));
+        return -1;
+    }
+
+    if (data_entry->compression_flag == 1) {
+        uint64_t length = _pkgtool_inflate(src, data_entry->length, buffer, _pkgtool_write_all, &fd);
+        if (length != data_entry->uncompressed_length) {
+            fprintf(stderr, "pyi-pkgtool: failed to extract entry %s!\n", toc_entry->name);
+            rc = -1;
+        }
+    } else if (_pkgtool_write_all(&fd, src, (size_t)data_entry->length) < 0) {
+        fprintf(stderr, "pyi-pkgtool: failed to write %s: %s\n", output_filename, strerror(errno));
+        rc = -1;
+    }
+
+    if (close(fd) < 0 && rc == 0) {
+        fprintf(stderr, "pyi-pkgtool: failed to write %s: %s\n", output_filename, strerror(errno));
+        rc = -1;
+    }
+
+    return rc;
+}
+
+static void *
+_pkgtool_worker(void *arg)
+{
+    struct PKGTOOL *tool = (struct PKGTOOL *)arg;
+    unsigned char *buffer;
+
+    buffer = (unsigned char *)malloc(PKGTOOL_BUFFER_SIZE);
+    if (buffer == NULL) {
+        fprintf(stderr, "pyi-pkgtool: failed to allocate decompression buffer!\n");
+        pthread_mutex_lock(&tool->lock);
+        tool->failure_count++;
+        pthread_mutex_unlock(&tool->lock);
+        return NULL;
+    }
+
+    for (;;) {
+        const struct TOC_ENTRY *toc_entry = NULL;
+        int rc;
+
+        /* Claim the next entry */
+        pthread_mutex_lock(&tool->lock);
+        if (tool->next_entry < tool->entry_count) {
+            toc_entry = tool->entries[tool->next_entry++];
+        }
+        pthread_mutex_unlock(&tool->lock);
+        if (toc_entry == NULL) {
+            break;
+        }
+
+        if (tool->command == PKGTOOL_VERIFY) {
+            rc = _pkgtool_verify_entry(tool, toc_entry, buffer);
+        } else {
+            rc = _pkgtool_extract_entry(tool, toc_entry, buffer);
+        }
+        if (rc < 0) {
+            pthread_mutex_lock(&tool->lock);
+            tool->failure_count++;
+            pthread_mutex_unlock(&tool->lock);
+        }
+    }
+
+    free(buffer);
+    return NULL;
+}
+
+/* Order entries by decreasing uncompressed length. */
+static int
+_pkgtool_compare_entries(const void *a, const void *b)
+{
+    const struct TOC_ENTRY *entry_a = *(const struct TOC_ENTRY *const *)a;
+    const struct TOC_ENTRY *entry_b = *(const struct TOC_ENTRY *const *)b;
+
+    if (entry_a->uncompressed_length != entry_b->uncompressed_length) {
+        return entry_a->uncompressed_length < entry_b->uncompressed_length ? 1 : -1;
+    }
+    return entry_a < entry_b ? -1 : (entry_a > entry_b);
+}
+
+/*
+ * Process the selected entries using the given number of worker threads.
+ * Largest entries are claimed first, so that a single large entry does not
+ * end up being processed last. When extracting, symbolic links are created
+ * only after all other entries have been written, by the main thread, so
+ * that a link cannot redirect the output of other entries. Returns the
+ * number of failed entries.
+ */
+static uint32_t
+_pkgtool_run_workers(struct PKGTOOL *tool, int job_count)
+{
+    pthread_t threads[PKGTOOL_MAX_JOBS];
+    int thread_count = 0;
+    uint32_t symlink_count = 0;
+    uint32_t i;
+
+    qsort((void *)tool->entries, tool->entry_count, sizeof(tool->entries[0]), _pkgtool_compare_entries);
+
+    /* Move symbolic links to the end of the list (preserving the order of
+     * the other entries), and exclude them from the parallel phase */
+    if (tool->command == PKGTOOL_EXTRACT) {
+        uint32_t regular_count = 0;
+        const struct TOC_ENTRY **symlinks = (const struct TOC_ENTRY **)calloc(tool->entry_count + 1, sizeof(struct TOC_ENTRY *));
+        if (symlinks == NULL) {
+            fprintf(stderr, "pyi-pkgtool: failed to allocate entry list!\n");
+            return tool->entry_count ? tool->entry_count : 1;
+        }
+        for (i = 0; i < tool->entry_count; i++) {
+            if (tool->entries[i]->typecode == ARCHIVE_ITEM_SYMLINK) {
+                symlinks[symlink_count++] = tool->entries[i];
+            } else {
+                tool->entries[regular_count++] = tool->entries[i];
+            }
+        }
+        memcpy((void *)(tool->entries + regular_count), symlinks, symlink_count * sizeof(struct TOC_ENTRY *));
+        free((void *)symlinks);
+        tool->entry_count = regular_count;
+    }
+
+    if ((uint32_t)job_count > tool->entry_count) {
+        job_count = tool->entry_count ? (int)tool->entry_count : 1;
+    }
+    for (i = 1; i < (uint32_t)job_count; i++) {
+        if (pthread_create(&threads[thread_count], NULL, _pkgtool_worker, tool) != 0) {
+            break; /* Continue with fewer workers */
+        }
+        thread_count++;
+    }
+
+    /* Main thread participates as a worker */
+    _pkgtool_worker(tool);
+
+    for (i = 0; i < (uint32_t)thread_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    /* Create the symbolic links */
+    if (symlink_count > 0) {
+        tool->entry_count += symlink_count;
+        _pkgtool_worker(tool);
+    }
+
+    return tool->failure_count;
+}
+
+
+/**********************************************************************\
+ *                               Main                                 *
+\**********************************************************************/
+
+static void
+_pkgtool_usage(void)
+{
+    fprintf(
+        stderr,
+        "usage: pyi-pkgtool list [-z] ARCHIVE\n"
+        "       pyi-pkgtool verify [-j JOBS] ARCHIVE\n"
+        "       pyi-pkgtool extract [-j JOBS] [-o OUTPUT_DIR] ARCHIVE [NAME ...]\n"
+        "\n"
+        "  -z             list contents of nested PYZ archives\n"
+        "  -j JOBS        number of worker threads (default: number of CPUs)\n"
+        "  -o OUTPUT_DIR  output directory (default: current directory)\n"
+    );
+}
+
+/*
+ * Select the entries to verify/extract: either the named ones, or all
+ * entries that carry data.
+ */
+static int
+_pkgtool_select_entries(struct PKGTOOL *tool, char *const *names, int name_count)
+{
+    const struct ARCHIVE *archive = tool->archive;
+    const struct TOC_ENTRY *toc_entry;
+    int i;
+
+    tool->entries = (const struct TOC_ENTRY **)calloc((archive->toc_end - archive->toc) + 1, sizeof(struct TOC_ENTRY *));
+    if (tool->entries == NULL) {
+        fprintf(stderr, "pyi-pkgtool: failed to allocate entry list!\n");
+        return -1;
+    }
+
+    if (name_count > 0) {
+        for (i = 0; i < name_count; i++) {
+            toc_entry = pyi_archive_find_entry_by_name(archive, names[i]);
+            if (toc_entry == NULL) {
+                fprintf(stderr, "pyi-pkgtool: entry %s not found in the archive!\n", names[i]);
+                return -1;
+            }
+            tool->entries[tool->entry_count++] = toc_entry;
+        }
+        return 0;
+    }
+
+    for (toc_entry = archive->toc; toc_entry < archive->toc_end; toc_entry = pyi_archive_next_toc_entry(archive, toc_entry)) {
+        /* Runtime options and MERGE dependencies carry no data */
+        if (toc_entry->typecode == ARCHIVE_ITEM_RUNTIME_OPTION || toc_entry->typecode == ARCHIVE_ITEM_DEPENDENCY) {
+            continue;
+        }
+        tool->entries[tool->entry_count++] = toc_entry;
+    }
+    return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct PKGTOOL tool;
+    const char *archive_filename;
+    bool list_pyz = false;
+    int job_count = 0;
+    struct stat archive_stat;
+    int fd;
+    int argi;
+    int rc = 1;
+
+    memset(&tool, 0, sizeof(tool));
+    tool.output_dir = ".";
+    tool.output_dirfd = -1;
+
+    if (argc < 2) {
+        _pkgtool_usage();
+        return 2;
+    }
+    if (strcmp(argv[1], "list") == 0) {
+        tool.command = PKGTOOL_LIST;
+    } else if (strcmp(argv[1], "verify") == 0) {
+        tool.command = PKGTOOL_VERIFY;
+    } else if (strcmp(argv[1], "extract") == 0) {
+        tool.command = PKGTOOL_EXTRACT;
+    } else {
+        _pkgtool_usage();
+        return 2;
+    }
+
+    /* Parse options */
+    for (argi = 2; argi < argc && argv[argi][0] == '-'; argi++) {
+        if (strcmp(argv[argi], "-z") == 0 && tool.command == PKGTOOL_LIST) {
+            list_pyz = true;
+        } else if (strcmp(argv[argi], "-j") == 0 && tool.command != PKGTOOL_LIST && argi + 1 < argc) {
+            job_count = atoi(argv[++argi]);
+        } else if (strcmp(argv[argi], "-o") == 0 && tool.command == PKGTOOL_EXTRACT && argi + 1 < argc) {
+            tool.output_dir = argv[++argi];
+        } else {
+            _pkgtool_usage();
+            return 2;
+        }
+    }
+    if (argi >= argc || (tool.command != PKGTOOL_EXTRACT && argi + 1 != argc)) {
+        _pkgtool_usage();
+        return 2;
+    }
+    archive_filename = argv[argi++];
+
+    if (job_count <= 0) {
+        long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+        job_count = cpu_count > 0 ? (int)cpu_count : 1;
+    }
+    if (job_count > PKGTOOL_MAX_JOBS) {
+        job_count = PKGTOOL_MAX_JOBS;
+    }
+
+    /* Load the TOC */
+    tool.archive = pyi_archive_open(archive_filename);
+    if (tool.archive == NULL) {
+        fprintf(stderr, "pyi-pkgtool: cannot open %s as PyInstaller archive!\n", archive_filename);
+        return 1;
+    }
+
+    /* Map the whole file */
+    fd = open(archive_filename, O_RDONLY);
+    if (fd < 0 || fstat(fd, &archive_stat) < 0) {
+        fprintf(stderr, "pyi-pkgtool: cannot open %s: %s\n", archive_filename, strerror(errno));
+        goto cleanup;
+    }
+    tool.data_size = (size_t)archive_stat.st_size;
+    tool.data = (const unsigned char *)mmap(NULL, tool.data_size ? tool.data_size : 1, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (tool.data == (const unsigned char *)MAP_FAILED) {
+        fprintf(stderr, "pyi-pkgtool: cannot map %s: %s\n", archive_filename, strerror(errno));
+        tool.data = NULL;
+        goto cleanup;
+    }
+
+    if (tool.command == PKGTOOL_LIST) {
+        rc = _pkgtool_list(&tool, list_pyz) < 0 ? 1 : 0;
+        goto cleanup;
+    }
+
+    /* Entries are processed in arbitrary order, and typically only once */
+#if defined(MADV_WILLNEED)
+    madvise((void *)tool.data, tool.data_size, MADV_WILLNEED);
+#endif
+
+    if (_pkgtool_select_entries(&tool, argv + argi, argc - argi) < 0) {
+        goto cleanup;
+    }
+    if (pthread_mutex_init(&tool.lock, NULL) != 0) {
+        fprintf(stderr, "pyi-pkgtool: failed to initialize mutex!\n");
+        goto cleanup;
+    }
+    if (tool.command == PKGTOOL_EXTRACT && mkdir(tool.output_dir, 0755) < 0 && errno != EEXIST) {
+        fprintf(stderr, "pyi-pkgtool: failed to create directory %s: %s\n", tool.output_dir, strerror(errno));
+    } else if (tool.command == PKGTOOL_EXTRACT && (tool.output_dirfd = open(tool.output_dir, O_RDONLY | O_DIRECTORY)) < 0) {
+        fprintf(stderr, "pyi-pkgtool: failed to open directory %s: %s\n", tool.output_dir, strerror(errno));
+    } else if (_pkgtool_run_workers(&tool, job_count) == 0) {
+        if (tool.command == PKGTOOL_VERIFY) {
+            printf("%s: %" PRIu32 " entries OK\n", archive_filename, tool.entry_count);
+        }
+        rc = 0;
+    } else {
+        fprintf(stderr, "pyi-pkgtool: %" PRIu32 " of %" PRIu32 " entries failed!\n", tool.failure_count, tool.entry_count);
+    }
+    pthread_mutex_destroy(&tool.lock);
+    if (tool.output_dirfd >= 0) {
+        close(tool.output_dirfd);
+    }
+
+cleanup:
+    if (tool.data) {
+        munmap((void *)tool.data, tool.data_size ? tool.data_size : 1);
+    }
+    free((void *)tool.entries);
+    pyi_archive_free(&tool.archive);
+
+    return rc;
+}
@@ -0,0 +1,46 @@
+#-----------------------------------------------------------------------------
+# Copyright (c) 2026, PyInstaller Development Team.
+#
+# Distributed under the terms of the GNU General Public License (version 2
+# or later) with exception for distributing the bootloader.
+#
+# The full license is in the file COPYING.txt, distributed with this software.
+#
+# SPDX-License-Identifier: (GPL-2.0-or-later WITH Bootloader-exception)
+#-----------------------------------------------------------------------------
+
+# The data file (the script's own copy) is collected as an on-demand data file, which is not extracted until it is
+# opened in a mode other than read-only mode.
+import os
+import sys
+
+filename = os.path.join(sys._MEIPASS, 'data', 'pyi_lazy_data.py')
+assert not os.path.exists(filename)
+
+# Served directly from the archive.
+with open(filename, 'rb') as fp:
+    contents = fp.read()
+assert b'on-demand data file' in contents
+
+# Make the extraction fail, by occupying the name of the temporary file with a directory.
+tmp_filename = f"{filename}.{os.getpid()}.tmp"
+os.makedirs(tmp_filename)
+try:
+    open(filename, 'r+b')
+except OSError:
+    pass
+else:
+    raise AssertionError("Extraction was expected to fail!")
+os.rmdir(tmp_filename)
+
+# After the failed extraction, the file must still be served from the archive.
+with open(filename, 'rb') as fp:
+    assert fp.read() == contents
+assert not os.path.exists(filename)
+
+# Extract the file, and modify the extracted copy.
+with open(filename, 'r+b') as fp:
+    assert fp.read() == contents
+    fp.write(b'\n# modified\n')
+with open(filename, 'rb') as fp:
+    assert fp.read() == contents + b'\n# modified\n'
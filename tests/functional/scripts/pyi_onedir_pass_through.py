@@ -0,0 +1,17 @@
+#-----------------------------------------------------------------------------
+# Copyright (c) 2026, PyInstaller Development Team.
+#
+# Distributed under the terms of the GNU General Public License (version 2
+# or later) with exception for distributing the bootloader.
+#
+# The full license is in the file COPYING.txt, distributed with this software.
+#
+# SPDX-License-Identifier: (GPL-2.0-or-later WITH Bootloader-exception)
+#-----------------------------------------------------------------------------
+
+# The data file is passed to EXE instead of COLLECT; the PKG passes it on to COLLECT.
+import os
+import sys
+
+with open(os.path.join(sys._MEIPASS, 'data', 'pyi_onedir_pass_through.py'), encoding='utf-8') as fp:
+    assert 'pass_through' in fp.read()
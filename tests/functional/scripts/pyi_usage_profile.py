@@ -0,0 +1,18 @@
+#-----------------------------------------------------------------------------
+# Copyright (c) 2026, PyInstaller Development Team.
+#
+# Distributed under the terms of the GNU General Public License (version 2
+# or later) with exception for distributing the bootloader.
+#
+# The full license is in the file COPYING.txt, distributed with this software.
+#
+# SPDX-License-Identifier: (GPL-2.0-or-later WITH Bootloader-exception)
+#-----------------------------------------------------------------------------
+
+# Imports a module and opens a data file, for the usage recorder to record.
+import os
+import sys
+import email.parser  # noqa: F401
+
+with open(os.path.join(sys._MEIPASS, 'data', 'pyi_usage_profile.py'), encoding='utf-8') as fp:
+    assert 'email.parser' in fp.read()
@@ -0,0 +1,25 @@
+# -*- mode: python -*-
+#-----------------------------------------------------------------------------
+# Copyright (c) 2026, PyInstaller Development Team.
+#
+# Distributed under the terms of the GNU General Public License (version 2
+# or later) with exception for distributing the bootloader.
+#
+# The full license is in the file COPYING.txt, distributed with this software.
+#
+# SPDX-License-Identifier: (GPL-2.0-or-later WITH Bootloader-exception)
+#-----------------------------------------------------------------------------
+
+app_name = 'pyi_lazy_data'
+script_file = os.path.join(os.path.dirname(SPECPATH), 'scripts', 'pyi_lazy_data.py')
+
+# The script opens its own copy, collected as an on-demand data file.
+a = Analysis([script_file], datas=[(script_file, 'data')])
+pyz = PYZ(a.pure)
+exe = EXE(pyz,
+          a.scripts,
+          a.binaries,
+          a.datas,
+          name=app_name,
+          lazy_data=['data/*'],
+          console=True)
@@ -0,0 +1,29 @@
+# -*- mode: python -*-
+#-----------------------------------------------------------------------------
+# Copyright (c) 2026, PyInstaller Development Team.
+#
+# Distributed under the terms of the GNU General Public License (version 2
+# or later) with exception for distributing the bootloader.
+#
+# The full license is in the file COPYING.txt, distributed with this software.
+#
+# SPDX-License-Identifier: (GPL-2.0-or-later WITH Bootloader-exception)
+#-----------------------------------------------------------------------------
+
+app_name = 'pyi_onedir_pass_through'
+script_file = os.path.join(os.path.dirname(SPECPATH), 'scripts', 'pyi_onedir_pass_through.py')
+
+a = Analysis([script_file])
+pyz = PYZ(a.pure)
+# The data file (the script's own copy) is passed to the onedir EXE; the PKG must pass it on to COLLECT via its
+# `dependencies`.
+exe = EXE(pyz,
+          a.scripts,
+          [(os.path.join('data', 'pyi_onedir_pass_through.py'), script_file, 'DATA')],
+          exclude_binaries=True,
+          name=app_name,
+          console=True)
+coll = COLLECT(exe,
+               a.binaries,
+               a.datas,
+               name=app_name)
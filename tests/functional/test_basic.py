@@ -824,3 +824,155 @@ def test_spec_options(pyi_builder_spec, spec_dir, capsys):
     with pytest.raises(SystemExit) as ex:
         pyi_builder_spec.test_spec(spec_dir / "pyi_spec_options.spec", pyi_args=["--", "--onefile"])
     assert "pyi_spec_options.spec: error: unrecognized arguments: --onefile" in capsys.readouterr().err
+
+
+# Check that the import profiler (activated by PYINSTALLER_IMPORT_PROFILE environment variable) writes a JSON report
+# with per-module timings at exit.
+def test_import_profiler(pyi_builder, monkeypatch, tmp_path):
+    import json
+
+    report_file = tmp_path / "import-profile.json"
+    monkeypatch.setenv('PYINSTALLER_IMPORT_PROFILE', str(report_file))
+    pyi_builder.test_source("""
+        import json
+        import email.parser
+        """)
+
+    report = json.loads(report_file.read_text(encoding="utf-8"))
+    assert report['unit'] == 'ms'
+    stats = report['modules']['email.parser']
+    for field in ('find_spec', 'read', 'decompress', 'unmarshal', 'exec', 'exec_self'):
+        assert field in stats
+    assert stats['exec'] >= stats['exec_self'] > 0
+
+
+# Check that the modules listed in `lazy_imports` are executed on first attribute access, and that excluded modules
+# are loaded eagerly.
+def test_lazy_imports(pyi_builder):
+    pyi_builder.test_source(
+        """
+        import sys
+        import email.parser
+        import email.message
+
+        assert type(sys.modules['email.parser']).__name__ == '_LazyModule'
+        assert type(sys.modules['email.message']).__name__ == 'module'
+
+        parser = email.parser.Parser()
+        assert type(sys.modules['email.parser']).__name__ == 'module'
+        """,
+        pyi_args=['--lazy-import', 'email', '--lazy-import', '!email.message']
+    )
+
+
+# Check that with `lazy_runtime_hooks`, the run-time hook for `inspect` is executed when the module is first imported,
+# instead of at start-up.
+def test_lazy_runtime_hooks(pyi_builder):
+    pyi_builder.test_source(
+        """
+        import sys
+
+        assert 'inspect' not in sys.modules
+        assert 'pyi_rth_inspect' not in sys.modules
+
+        import inspect
+
+        assert 'pyi_rth_inspect' in sys.modules
+        assert inspect.getsourcefile.__name__ == '_pyi_getsourcefile'
+        """,
+        pyi_args=['--lazy-runtime-hooks']
+    )
+
+
+# Check the points of execution of deferred run-time hooks: a hook executed 'before' its trigger module sees the module
+# object, but not the result of its execution, while a hook executed 'after' it sees the executed module.
+def test_deferred_runtime_hooks_execution_point(pyi_builder, tmp_path):
+    hooks_dir = tmp_path / 'hooks'
+    hooks_dir.mkdir()
+    (hooks_dir / 'pyi_test_rth_before.py').write_text(
+        "import sys\n"
+        "module = sys.modules['email.parser']\n"
+        "assert not hasattr(module, 'Parser')\n"
+        "module._pyi_before_hook_ran = True\n",
+        encoding='utf-8',
+    )
+    (hooks_dir / 'pyi_test_rth_after.py').write_text(
+        "import sys\n"
+        "module = sys.modules['email.parser']\n"
+        "assert hasattr(module, 'Parser')\n"
+        "assert module._pyi_before_hook_ran\n"
+        "module._pyi_after_hook_ran = True\n",
+        encoding='utf-8',
+    )
+
+    pyi_builder.test_source(
+        """
+        import sys
+        import pyimod02_importers
+
+        pyimod02_importers.install_deferred_runtime_hooks({
+            'email.parser': [('pyi_test_rth_before', 'before'), ('pyi_test_rth_after', 'after')],
+        })
+        assert 'pyi_test_rth_before' not in sys.modules
+
+        import email.parser
+
+        assert email.parser._pyi_before_hook_ran
+        assert email.parser._pyi_after_hook_ran
+        assert type(email.parser.__loader__).__name__ == 'PyiFrozenLoader'
+        assert email.parser.__spec__.loader is email.parser.__loader__
+        """,
+        pyi_args=[
+            '--paths', str(hooks_dir),
+            '--hidden-import', 'email.parser',
+            '--hidden-import', 'pyi_test_rth_before',
+            '--hidden-import', 'pyi_test_rth_after',
+        ]
+    )
+
+
+# Check that the usage recorder (enabled by the `usage_recorder` option of EXE, and activated by the
+# PYINSTALLER_USAGE_PROFILE environment variable) records the imported modules and the opened data files.
+def test_usage_profile(pyi_builder_spec, monkeypatch, tmp_path):
+    from PyInstaller.building.build_main import USAGE_PROFILE_FILE_HEADER
+
+    profile_file = tmp_path / "usage-profile.txt"
+    monkeypatch.setenv('PYINSTALLER_USAGE_PROFILE', str(profile_file))
+    pyi_builder_spec.test_spec('pyi_usage_profile.spec')
+
+    profile = profile_file.read_text(encoding="utf-8").splitlines()
+    assert profile[0] == USAGE_PROFILE_FILE_HEADER
+    assert 'module email.parser' in profile
+    assert 'file data/pyi_usage_profile.py' in profile
+
+
+# Check that the PYINSTALLER_USAGE_PROFILE environment variable is ignored by applications that were built without
+# the `usage_recorder` option.
+def test_usage_profile_disabled(pyi_builder, monkeypatch, tmp_path):
+    profile_file = tmp_path / "usage-profile.txt"
+    monkeypatch.setenv('PYINSTALLER_USAGE_PROFILE', str(profile_file))
+    pyi_builder.test_source(
+        """
+        import builtins
+        import io
+        import sys
+
+        assert not hasattr(sys, '_pyi_usage_recorder')
+        assert builtins.open is io.open
+        """
+    )
+
+    assert not profile_file.exists()
+
+
+# Check that the entries passed to onedir EXE that PKG passes on to COLLECT (via `dependencies`) are collected even if
+# the assembly of targets is deferred to the target scheduler (i.e., when building with more than one job).
+@pytest.mark.parametrize("jobs", (1, 2), ids=("serial", "parallel"))
+def test_onedir_pass_through_dependencies(pyi_builder_spec, jobs):
+    pyi_builder_spec.test_spec('pyi_onedir_pass_through.spec', pyi_args=['--jobs', str(jobs)])
+
+
+# Check that on-demand data files (the `lazy_data` option of onefile EXE) are served from the archive until they are
+# extracted, and remain available from the archive if the extraction fails.
+def test_lazy_data(pyi_builder_spec):
+    pyi_builder_spec.test_spec('pyi_lazy_data.spec')
@@ -11,6 +11,7 @@
 
 import pytest
 
+from PyInstaller.archive.readers import ZlibArchiveReader
 from PyInstaller.utils.tests import importorskip
 
 
@@ -31,5 +32,25 @@
         "onedir_and_onefile_depends_on_onedir",
     )
 )
-def test_spec_with_multipackage(pyi_builder_spec, spec_file):
-    pyi_builder_spec.test_spec(spec_file)
+@pytest.mark.parametrize("jobs", (1, 2), ids=("serial", "parallel"))
+def test_spec_with_multipackage(pyi_builder_spec, spec_file, jobs):
+    pyi_builder_spec.test_spec(spec_file, pyi_args=['--jobs', str(jobs)])
+
+
+# Onedir and onefile programs with shared PYZ archive; in addition to running the programs, check that the shared
+# modules were moved from the programs' PYZ archives into the shared one.
+@importorskip('psutil')  # Used as test for nested extension
+@pytest.mark.parametrize("jobs", (1, 2), ids=("serial", "parallel"))
+def test_spec_with_multipackage_shared_pyz(pyi_builder_spec, jobs, tmp_path):
+    pyi_builder_spec.test_spec("test_multipackage6.spec", pyi_args=['--jobs', str(jobs)])
+
+    shared_pyz = tmp_path / 'dist' / 'shared.pyz'
+    assert shared_pyz.is_file()
+    shared_modules = set(ZlibArchiveReader(str(shared_pyz)).toc)
+    assert 'multipackage_test_pkg' in shared_modules
+
+    pyz_files = sorted((tmp_path / 'build' / 'test_multipackage6').glob('PYZ-*.pyz'))
+    assert len(pyz_files) == 3
+    for pyz_file in pyz_files:
+        modules = set(ZlibArchiveReader(str(pyz_file)).toc)
+        assert not modules & shared_modules, f"Shared modules were not removed from {pyz_file.name}!"
@@ -0,0 +1,322 @@
+#-----------------------------------------------------------------------------
+# Copyright (c) 2026, PyInstaller Development Team.
+#
+# Distributed under the terms of the GNU General Public License (version 2
+# or later) with exception for distributing the bootloader.
+#
+# The full license is in the file COPYING.txt, distributed with this software.
+#
+# SPDX-License-Identifier: (GPL-2.0-or-later WITH Bootloader-exception)
+#-----------------------------------------------------------------------------
+
+# Tests for CArchive (PKG) writer and reader.
+import os
+import random
+import struct
+import zlib
+
+import pytest
+
+from PyInstaller.archive.readers import ArchiveReadError, CArchiveReader
+from PyInstaller.archive.writers import CArchiveWriter
+
+_PYLIB_NAME = 'libpython3.so'
+
+
+def _create_file(path, size, seed=0):
+    # Pseudo-random (incompressible) content.
+    rng = random.Random(seed)
+    data = bytes(rng.getrandbits(8) for _ in range(size))
+    path.write_bytes(data)
+    return str(path)
+
+
+@pytest.mark.parametrize('alignment', [None, 4096])
+def test_carchive_alignment(tmp_path, alignment):
+    file1 = _create_file(tmp_path / 'file1.bin', 5000, seed=1)
+    file2 = _create_file(tmp_path / 'file2.dat', 9000, seed=2)
+
+    entries = [
+        ('pyi-option', '', False, 'o'),
+        ('file1-compressed', file1, True, 'b'),
+        ('file2', file2, False, 'x'),
+        ('file1', file1, False, 'b'),
+    ]
+    pkg_file = str(tmp_path / 'archive.pkg')
+    CArchiveWriter(pkg_file, entries, _PYLIB_NAME, alignment=alignment)
+
+    reader = CArchiveReader(pkg_file)
+    assert reader.start_offset == 0
+
+    for name, src_name in (('file1-compressed', file1), ('file1', file1), ('file2', file2)):
+        with open(src_name, 'rb') as fp:
+            assert reader.extract(name) == fp.read()
+
+    if alignment:
+        # Uncompressed entries must be aligned; compressed ones are not.
+        for name in ('file1', 'file2'):
+            offset, _, _, compression_flag, _ = reader.toc[name]
+            assert compression_flag == 0
+            assert offset % alignment == 0
+    else:
+        # No padding between entries.
+        assert os.path.getsize(pkg_file) < 5000 * 2 + 9000 + 1024
+
+
+def test_carchive_deduplication(tmp_path):
+    file1 = _create_file(tmp_path / 'file1.bin', 5000, seed=1)
+    file1_copy = _create_file(tmp_path / 'file1_copy.bin', 5000, seed=1)
+    file2 = _create_file(tmp_path / 'file2.bin', 5000, seed=2)
+    empty1 = _create_file(tmp_path / 'empty1.dat', 0)
+    empty2 = _create_file(tmp_path / 'empty2.dat', 0)
+
+    entries = [
+        ('file1', file1, True, 'b'),
+        ('file1-copy', file1_copy, True, 'b'),
+        ('file1-uncompressed', file1_copy, False, 'b'),  # Different compression flag; not an alias.
+        ('file1-data', file1_copy, True, 'x'),  # Different typecode; not an alias.
+        ('file2', file2, True, 'b'),
+        ('empty1', empty1, False, 'x'),
+        ('empty2', empty2, False, 'x'),  # Empty files are not de-duplicated.
+    ]
+    pkg_file = str(tmp_path / 'archive.pkg')
+    CArchiveWriter(pkg_file, entries, _PYLIB_NAME, deduplicate=True)
+
+    reader = CArchiveReader(pkg_file)
+    typecodes = {name: toc_entry[-1] for name, toc_entry in reader.toc.items()}
+    assert typecodes == {
+        'file1': 'b',
+        'file1-copy': 'h',
+        'file1-uncompressed': 'b',
+        'file1-data': 'x',
+        'file2': 'b',
+        'empty1': 'x',
+        'empty2': 'x',
+    }
+
+    # Alias refers to the data blob of the original entry.
+    assert reader.toc['file1-copy'][:4] == reader.toc['file1'][:4]
+    with open(file1, 'rb') as fp:
+        assert reader.extract('file1-copy') == fp.read()
+
+
+@pytest.mark.parametrize('threshold', [None, 0.02])
+def test_carchive_adaptive_compression(tmp_path, threshold):
+    small_random = _create_file(tmp_path / 'small_random.bin', 10000, seed=1)
+    large_random = _create_file(tmp_path / 'large_random.bin', 300000, seed=2)
+    # Large file with compressible data; its compressibility is estimated from samples.
+    large_text = tmp_path / 'large_text.txt'
+    large_text.write_bytes(b'Lorem ipsum dolor sit amet. ' * 20000)
+    large_text = str(large_text)
+
+    entries = [
+        ('small_random', small_random, True, 'x'),
+        ('large_random', large_random, 9, 'x'),
+        ('large_text', large_text, 1, 'x'),
+        ('large_text_uncompressed', large_text, 0, 'x'),
+    ]
+    pkg_file = str(tmp_path / 'archive.pkg')
+    CArchiveWriter(pkg_file, entries, _PYLIB_NAME, compression_threshold=threshold)
+
+    reader = CArchiveReader(pkg_file)
+    compression_flags = {name: toc_entry[3] for name, toc_entry in reader.toc.items()}
+    if threshold is None:
+        assert compression_flags == {
+            'small_random': 1,
+            'large_random': 1,
+            'large_text': 1,
+            'large_text_uncompressed': 0,
+        }
+    else:
+        assert compression_flags == {
+            'small_random': 0,
+            'large_random': 0,
+            'large_text': 1,
+            'large_text_uncompressed': 0,
+        }
+
+    for name, src_name, *_ in entries:
+        with open(src_name, 'rb') as fp:
+            assert reader.extract(name) == fp.read()
+
+
+@pytest.mark.parametrize('format_version', [1, 2])
+def test_carchive_format_version(tmp_path, format_version):
+    file1 = _create_file(tmp_path / 'file1.bin', 5000, seed=1)
+    file2 = _create_file(tmp_path / 'file2.dat', 9000, seed=2)
+
+    entries = [
+        ('pyi-option', '', False, 'o'),
+        ('file1', file1, True, 'b'),
+        ('W ignore', '', False, 'o'),
+        ('file2', file2, False, 'x'),
+        ('pyi-option', '', False, 'o'),  # Duplicated OPTION entries are allowed.
+    ]
+    pkg_file = str(tmp_path / 'archive.pkg')
+    CArchiveWriter(pkg_file, entries, _PYLIB_NAME, format_version=format_version)
+
+    reader = CArchiveReader(pkg_file)
+    assert reader.format_version == format_version
+    assert reader.options == ['pyi-option', 'W ignore', 'pyi-option']
+    assert list(reader.toc) == ['file1', 'file2']
+    for name, src_name in (('file1', file1), ('file2', file2)):
+        with open(src_name, 'rb') as fp:
+            assert reader.extract(name) == fp.read()
+
+
+def test_carchive_v2_sections(tmp_path):
+    entries = [
+        ('opt1', '', False, 'o'),
+        ('opt2', '', False, 'o'),
+        ('link1', 'target', False, 'n'),
+        ('opt3', '', False, 'o'),
+    ]
+    pkg_file = str(tmp_path / 'archive.pkg')
+    CArchiveWriter(pkg_file, entries, _PYLIB_NAME, format_version=2)
+
+    # Parse the section table and entry index directly.
+    with open(pkg_file, 'rb') as fp:
+        data = fp.read()
+    cookie = struct.unpack(CArchiveReader._COOKIE_V2_FORMAT, data[-CArchiveReader._COOKIE_V2_LENGTH:])
+    _, v1_marker, format_version, _, toc_offset, _, entry_count, section_count, *_ = cookie
+    assert (v1_marker, format_version, entry_count, section_count) == (0, 2, 4, 2)
+
+    sections_offset = toc_offset + entry_count * CArchiveReader._TOC_ENTRY_V2_LENGTH
+    index_offset = sections_offset + section_count * CArchiveReader._TOC_SECTION_LENGTH
+    sections = [
+        struct.unpack_from(
+            CArchiveReader._TOC_SECTION_FORMAT,
+            data,
+            sections_offset + idx * CArchiveReader._TOC_SECTION_LENGTH,
+        )
+        for idx in range(section_count)
+    ]
+    index = struct.unpack_from(f'!{entry_count}I', data, index_offset)
+
+    # Sections are sorted by typecode; entries within section retain their original order.
+    assert sections == [(b'n', 0, 1), (b'o', 1, 3)]
+    assert index == (2, 0, 1, 3)
+
+
+def test_carchive_digests(tmp_path):
+    file1 = _create_file(tmp_path / 'file1.bin', 300000, seed=1)
+    file2 = _create_file(tmp_path / 'file2.dat', 9000, seed=2)
+
+    entries = [
+        ('file1', file1, True, 'b'),
+        ('file2', file2, False, 'x'),
+        ('file1-copy', file1, True, 'b'),  # Stored as an alias, which shares the digest.
+        ('link1', 'target', False, 'n'),
+    ]
+    pkg_file = str(tmp_path / 'archive.pkg')
+    CArchiveWriter(pkg_file, entries, _PYLIB_NAME, deduplicate=True, format_version=2)
+
+    reader = CArchiveReader(pkg_file)
+    for name, src_name in (('file1', file1), ('file2', file2), ('file1-copy', file1)):
+        with open(src_name, 'rb') as fp:
+            assert reader.digests[name] == zlib.crc32(fp.read())
+    assert reader.digests['link1'] == zlib.crc32(b'target\0')
+
+    # Corrupt the data of the uncompressed entry; the reader must detect the mismatch.
+    entry_offset, *_ = reader.toc['file2']
+    with open(pkg_file, 'r+b') as fp:
+        fp.seek(reader.start_offset + entry_offset + 100, os.SEEK_SET)
+        byte = fp.read(1)
+        fp.seek(-1, os.SEEK_CUR)
+        fp.write(bytes([byte[0] ^ 0xFF]))
+    with pytest.raises(ArchiveReadError):
+        CArchiveReader(pkg_file).extract('file2')
+
+
+def test_carchive_in_place_update(tmp_path):
+    file1 = _create_file(tmp_path / 'file1.bin', 50000, seed=1)
+    file2 = _create_file(tmp_path / 'file2.bin', 50000, seed=2)
+    file3 = _create_file(tmp_path / 'file3.bin', 1000, seed=3)
+
+    entries = [
+        ('pyi-option', '', False, 'o'),
+        ('file1', file1, True, 'b'),
+        ('file2', file2, False, 'x'),
+        ('file3', file3, True, 'x'),
+    ]
+    pkg_file = str(tmp_path / 'archive.pkg')
+    layout_file = pkg_file + '.layout'
+
+    writer = CArchiveWriter(pkg_file, entries, _PYLIB_NAME, layout_file=layout_file)
+    assert writer.num_reused_entries == 0
+    old_toc = CArchiveReader(pkg_file).toc
+
+    # Modify the small file, and add a new entry; the data of the unchanged entries must be kept at their offsets.
+    file3 = _create_file(tmp_path / 'file3.bin', 2000, seed=4)
+    file4 = _create_file(tmp_path / 'file4.bin', 1000, seed=5)
+    entries += [('file4', file4, True, 'x')]
+    writer = CArchiveWriter(pkg_file, entries, _PYLIB_NAME, layout_file=layout_file)
+    assert writer.num_reused_entries == 2
+
+    reader = CArchiveReader(pkg_file)
+    for name in ('file1', 'file2'):
+        assert reader.toc[name] == old_toc[name]
+    for name, src_name in (('file1', file1), ('file2', file2), ('file3', file3), ('file4', file4)):
+        with open(src_name, 'rb') as fp:
+            assert reader.extract(name) == fp.read()
+
+    # Modify a large file; the stale data exceeds the allowed fraction, so the archive is re-written from scratch.
+    file2 = _create_file(tmp_path / 'file2.bin', 50001, seed=6)
+    writer = CArchiveWriter(pkg_file, entries, _PYLIB_NAME, layout_file=layout_file)
+    assert writer.num_reused_entries == 0
+
+    reader = CArchiveReader(pkg_file)
+    with open(file2, 'rb') as fp:
+        assert reader.extract('file2') == fp.read()
+    assert os.path.getsize(pkg_file) < 50001 * 2 + 3000 + 1024
+
+    # Archive re-written by other means (i.e., without the layout file); the stale layout must not be used.
+    CArchiveWriter(pkg_file, entries[:-1], _PYLIB_NAME)
+    writer = CArchiveWriter(pkg_file, entries, _PYLIB_NAME, layout_file=layout_file)
+    assert writer.num_reused_entries == 0
+
+
+# In-place update of a de-duplicated archive; alias entries must always refer to the data blob of a non-alias entry.
+def test_carchive_in_place_update_deduplicated(tmp_path):
+    def _check_aliases(reader):
+        owner_offsets = {entry[0] for entry in reader.toc.values() if entry[4] != 'h'}
+        for name, entry in reader.toc.items():
+            if entry[4] == 'h':
+                assert entry[0] in owner_offsets, f"Alias {name} does not refer to data blob of any entry!"
+
+    big_file = _create_file(tmp_path / 'big.bin', 100000, seed=1)
+    liba = _create_file(tmp_path / 'liba.so', 2000, seed=2)
+    libb = _create_file(tmp_path / 'libb.so', 2000, seed=2)
+    other = _create_file(tmp_path / 'other.so', 1000, seed=3)
+
+    entries = [
+        ('big.bin', big_file, False, 'x'),
+        ('liba.so', liba, False, 'b'),
+        ('libb.so', libb, False, 'b'),
+        ('other.so', other, False, 'b'),
+    ]
+    pkg_file = str(tmp_path / 'archive.pkg')
+    layout_file = pkg_file + '.layout'
+
+    CArchiveWriter(pkg_file, entries, _PYLIB_NAME, deduplicate=True, layout_file=layout_file)
+    assert CArchiveReader(pkg_file).toc['libb.so'][4] == 'h'
+
+    # Modify an unrelated entry; the alias is de-duplicated against the reused data blob of the original entry.
+    _create_file(tmp_path / 'other.so', 1001, seed=4)
+    writer = CArchiveWriter(pkg_file, entries, _PYLIB_NAME, deduplicate=True, layout_file=layout_file)
+    assert writer.num_reused_entries == 2
+    reader = CArchiveReader(pkg_file)
+    assert reader.toc['libb.so'][4] == 'h'
+    assert reader.toc['libb.so'][0] == reader.toc['liba.so'][0]
+    _check_aliases(reader)
+
+    # Modify the original entry; its data blob is re-written at a different offset, and the alias must not keep
+    # referring to the old offset.
+    _create_file(tmp_path / 'liba.so', 2001, seed=5)
+    writer = CArchiveWriter(pkg_file, entries, _PYLIB_NAME, deduplicate=True, layout_file=layout_file)
+    assert writer.num_reused_entries > 0
+    reader = CArchiveReader(pkg_file)
+    _check_aliases(reader)
+    for name, src_name in (('liba.so', liba), ('libb.so', libb), ('other.so', other)):
+        with open(src_name, 'rb') as fp:
+            assert reader.extract(name) == fp.read()
@@ -0,0 +1,57 @@
+#-----------------------------------------------------------------------------
+# Copyright (c) 2026, PyInstaller Development Team.
+#
+# Distributed under the terms of the GNU General Public License (version 2
+# or later) with exception for distributing the bootloader.
+#
+# The full license is in the file COPYING.txt, distributed with this software.
+#
+# SPDX-License-Identifier: (GPL-2.0-or-later WITH Bootloader-exception)
+#-----------------------------------------------------------------------------
+
+# Tests for the selection of binaries for the `readahead_binaries` option of EXE.
+import os
+
+from PyInstaller.building.api import EXE
+
+
+def _make_binary(tmp_path, name, size):
+    path = tmp_path / name
+    path.write_bytes(b'\0' * size)
+    return str(path)
+
+
+def _make_exe(toc):
+    # Bypass the constructor, which requires a complete build environment.
+    exe = EXE.__new__(EXE)
+    exe.toc = toc
+    return exe
+
+
+# In onedir mode, the binaries are not passed to EXE; the selection must consider the binaries (and extensions)
+# collected by the Analysis.
+def test_readahead_binaries_onedir(tmp_path):
+    collected_binaries = [
+        ('libsmall.so', _make_binary(tmp_path, 'libsmall.so', 10), 'BINARY'),
+        (os.path.join('pkg', 'ext.so'), _make_binary(tmp_path, 'ext.so', 300), 'EXTENSION'),
+        ('libbig.so', _make_binary(tmp_path, 'libbig.so', 200), 'BINARY'),
+        ('data.txt', _make_binary(tmp_path, 'data.txt', 1000), 'DATA'),
+    ]
+    exe = _make_exe([('script', 'script.py', 'PYSOURCE')])
+    assert exe._select_readahead_binaries(2, collected_binaries) == [os.path.join('pkg', 'ext.so'), 'libbig.so']
+
+
+def test_readahead_binaries_onefile(tmp_path):
+    toc = [
+        ('libsmall.so', _make_binary(tmp_path, 'libsmall.so', 10), 'BINARY'),
+        ('ext.so', _make_binary(tmp_path, 'ext.so', 300), 'EXTENSION'),
+    ]
+    exe = _make_exe(toc)
+    # Entries that appear both in EXE's TOC and among the collected binaries are selected only once.
+    assert exe._select_readahead_binaries(5, toc) == ['ext.so', 'libsmall.so']
+
+
+def test_readahead_binaries_empty_selection(tmp_path, caplog):
+    exe = _make_exe([('script', 'script.py', 'PYSOURCE')])
+    assert exe._select_readahead_binaries(2, []) == []
+    assert "did not select any binaries" in caplog.text
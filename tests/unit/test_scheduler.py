@@ -0,0 +1,75 @@
+#-----------------------------------------------------------------------------
+# Copyright (c) 2026, PyInstaller Development Team.
+#
+# Distributed under the terms of the GNU General Public License (version 2
+# or later) with exception for distributing the bootloader.
+#
+# The full license is in the file COPYING.txt, distributed with this software.
+#
+# SPDX-License-Identifier: (GPL-2.0-or-later WITH Bootloader-exception)
+#-----------------------------------------------------------------------------
+
+# Tests for the scheduler of concurrent target assembly.
+import os
+import time
+
+import pytest
+
+from PyInstaller.building.datastruct import Target
+from PyInstaller.building.scheduler import TargetScheduler
+
+
+class _DummyTarget:
+    def __init__(self, name, delay=0, error=None):
+        self.target_name = name
+        self.delay = delay
+        self.error = error
+
+    def _check_and_assemble(self):
+        time.sleep(self.delay)
+        if self.error is not None:
+            raise ValueError(self.error)
+
+    def __repr__(self):
+        return self.target_name
+
+
+# A failure of a target that is declared after a pending target and its dependent (which is never submitted because
+# of the failure) must not be swallowed.
+def test_scheduler_reports_failure_of_later_target():
+    scheduler = TargetScheduler(jobs=4)
+    scheduler.targets = [
+        _DummyTarget('A', delay=1),
+        _DummyTarget('B'),
+        _DummyTarget('C', error='C failed'),
+    ]
+    scheduler.dependencies = [set(), {0}, set()]
+
+    with pytest.raises(ValueError, match='C failed'):
+        scheduler.run()
+
+
+class _FileTarget(Target):
+    def __init__(self, **attrs):
+        # Bypass `Target.__init__`, which requires a build configuration.
+        self.toc = []
+        vars(self).update(attrs)
+
+
+# The dependencies are inferred from direct references to other targets, and from the TOC entries whose source path is
+# the output (file or directory) of another target.
+def test_scheduler_infers_dependencies(tmp_path):
+    pyz = _FileTarget(name=str(tmp_path / 'PYZ-00.pyz'))
+    pkg = _FileTarget(toc=[('PYZ-00.pyz', str(tmp_path / 'PYZ-00.pyz'), 'PYZ')], name=str(tmp_path / 'app.pkg'))
+    exe = _FileTarget(pkg=pkg, name=str(tmp_path / 'build' / 'app'))
+    coll = _FileTarget(toc=[('app', str(tmp_path / 'build' / 'app'), 'EXECUTABLE')], name=str(tmp_path / 'dist'))
+    other_pyz = _FileTarget(name=str(tmp_path / 'PYZ-01.pyz'))
+    bundle = _FileTarget(toc=[('app', os.path.join(str(tmp_path / 'dist'), 'app', 'app'), 'EXECUTABLE')])
+
+    scheduler = TargetScheduler(jobs=2)
+    for target in (pyz, pkg, exe, coll, other_pyz, bundle):
+        scheduler.add(target)
+
+    assert scheduler.dependencies == [set(), {0}, {1}, {2}, set(), {3}]
+    assert scheduler._has_independent_targets()
+
@@ -0,0 +1,117 @@
+#-----------------------------------------------------------------------------
+# Copyright (c) 2026, PyInstaller Development Team.
+#
+# Distributed under the terms of the GNU General Public License (version 2
+# or later) with exception for distributing the bootloader.
+#
+# The full license is in the file COPYING.txt, distributed with this software.
+#
+# SPDX-License-Identifier: (GPL-2.0-or-later WITH Bootloader-exception)
+#-----------------------------------------------------------------------------
+
+# Tests for `Analysis.apply_usage_profile`, which slims down the bundle based on the recorded usage profile(s).
+import ast
+import os
+
+import pytest
+
+from PyInstaller import HOMEPATH
+from PyInstaller.building.build_main import Analysis, USAGE_PROFILE_FILE_HEADER
+from PyInstaller.config import CONF
+
+PURE = [
+    ('app', 'app.py', 'PYMODULE'),
+    ('app.used', 'app/used.py', 'PYMODULE'),
+    ('app.unused', 'app/unused.py', 'PYMODULE'),
+    ('app.plugins', 'app/plugins/__init__.py', 'PYMODULE'),
+    ('app.plugins.extra', 'app/plugins/extra.py', 'PYMODULE'),
+    ('json', 'json/__init__.py', 'PYMODULE'),
+]
+
+DATAS = [
+    ('base_library.zip', 'base_library.zip', 'DATA'),
+    ('app/data/used.txt', 'used.txt', 'DATA'),
+    ('app/data/unused.txt', 'unused.txt', 'DATA'),
+    ('certifi/cacert.pem', 'cacert.pem', 'DATA'),
+]
+
+BINARIES = [
+    ('lib-dynload/_used.so', '_used.so', 'EXTENSION'),
+    ('lib-dynload/_unused.so', '_unused.so', 'EXTENSION'),
+    ('libfoo.so', 'libfoo.so', 'BINARY'),
+]
+
+PROFILE = [
+    USAGE_PROFILE_FILE_HEADER,
+    'module app.used',
+    'module json',
+    'file app/data/used.txt',
+    'file lib-dynload/_used.so',
+]
+
+
+@pytest.fixture
+def analysis(tmp_path, monkeypatch):
+    monkeypatch.setitem(CONF, 'spec', str(tmp_path / 'app.spec'))
+    monkeypatch.setitem(CONF, 'specnm', 'app')
+    monkeypatch.setitem(CONF, 'workpath', str(tmp_path))
+
+    (tmp_path / 'usage-profile.txt').write_text('\n'.join(PROFILE) + '\n', encoding='utf-8')
+
+    # Bypass the constructor, which runs the analysis.
+    analysis = Analysis.__new__(Analysis)
+    analysis.invcnum = 0
+    analysis.pure = list(PURE)
+    analysis.datas = list(DATAS)
+    analysis.binaries = list(BINARIES)
+    return analysis
+
+
+def test_usage_profile_exclude(analysis):
+    pure = analysis.pure
+    unused = analysis.apply_usage_profile('usage-profile.txt', keep=['app.plugins.*', 'certifi/*'])
+
+    assert unused == ['app/data/unused.txt', 'lib-dynload/_unused.so']
+
+    # The parent package of a used module is kept, even though it was not recorded; `app.plugins` does not match the
+    # `keep` pattern, unlike its submodule.
+    assert [name for name, *_ in analysis.pure] == ['app', 'app.used', 'app.plugins.extra', 'json']
+    # The `pure` list must be modified in-place, to preserve its association with the code cache.
+    assert analysis.pure is pure
+
+    assert [name for name, *_ in analysis.datas] == ['base_library.zip', 'app/data/used.txt', 'certifi/cacert.pem']
+    # Shared libraries (other than extension modules) are never excluded.
+    assert [name for name, *_ in analysis.binaries] == ['lib-dynload/_used.so', 'libfoo.so']
+
+
+def test_usage_profile_lazy(analysis):
+    unused = analysis.apply_usage_profile(['usage-profile.txt'], mode='lazy')
+
+    assert unused == ['app/data/unused.txt', 'certifi/cacert.pem', 'lib-dynload/_unused.so']
+
+    # Nothing is removed in 'lazy' mode.
+    assert analysis.pure == PURE
+    assert analysis.datas == DATAS
+    assert analysis.binaries == BINARIES
+
+
+def test_usage_profile_invalid(analysis, tmp_path):
+    with pytest.raises(ValueError):
+        analysis.apply_usage_profile('usage-profile.txt', mode='remove')
+
+    (tmp_path / 'not-a-profile.txt').write_text('module json\n', encoding='utf-8')
+    with pytest.raises(SystemExit):
+        analysis.apply_usage_profile('not-a-profile.txt')
+
+
+# The usage recorder in the frozen application's importer defines its own copy of the header, because the module
+# cannot be imported at build time.
+def test_usage_profile_header_matches_recorder():
+    importers_file = os.path.join(HOMEPATH, 'PyInstaller', 'loader', 'pyimod02_importers.py')
+    with open(importers_file, 'r', encoding='utf-8') as fp:
+        tree = ast.parse(fp.read())
+    values = [
+        ast.literal_eval(node.value) for node in tree.body if isinstance(node, ast.Assign)
+        and any(isinstance(target, ast.Name) and target.id == 'USAGE_PROFILE_FILE_HEADER' for target in node.targets)
+    ]
+    assert values == [USAGE_PROFILE_FILE_HEADER]